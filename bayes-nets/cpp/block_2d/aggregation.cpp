@@ -0,0 +1,266 @@
+#include <cmath>
+#include <algorithm>
+
+#include <boost/math/constants/constants.hpp>
+
+#include "aggregation.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+
+const double T_digest::COMPRESSION_DEF = 200.0;
+
+// Values are buffered and merged into the centroids this many per unit of
+// compression at a time.
+static const size_t T_DIGEST_BUFFER_FACTOR = 5;
+
+T_digest::T_digest(double compression) :
+        compression_(compression),
+        weight_(0.0)
+{}
+
+void T_digest::add(double value, double weight)
+{
+    if(weight <= 0.0) return;
+    Centroid c;
+    c.mean_ = value;
+    c.weight_ = weight;
+    c.min_ = value;
+    c.max_ = value;
+    buffer_.push_back(c);
+    weight_ += weight;
+    if(buffer_.size() >= T_DIGEST_BUFFER_FACTOR * size_t(compression_)) compress();
+}
+
+// The scale function is k(q) = scale asin(2q - 1), and a centroid may span
+// at most 1 in k. This is the last quantile a centroid starting at q may
+// reach.
+static double get_q_limit(double q, double scale)
+{
+    const double half_pi = boost::math::constants::half_pi<double>();
+    double k = std::asin(2.0 * std::min(1.0, q) - 1.0) * scale + 1.0;
+    return k >= scale * half_pi ? 1.0 : (std::sin(k / scale) + 1.0) / 2.0;
+}
+
+void T_digest::compress() const
+{
+    if(buffer_.empty()) return;
+    buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+    centroids_.clear();
+    std::sort(buffer_.begin(), buffer_.end());
+
+    double scale = compression_ / (2.0 * boost::math::constants::pi<double>());
+    double total = 0.0;
+    for(const Centroid &c : buffer_)
+    {
+        total += c.weight_;
+    }
+    double weight_before = 0.0;
+    double q_limit = get_q_limit(0.0, scale);
+    Centroid cur = buffer_[0];
+    for(size_t i = 1; i < buffer_.size(); i++)
+    {
+        const Centroid &next = buffer_[i];
+        if((weight_before + cur.weight_ + next.weight_) / total <= q_limit)
+        {
+            // the check keeps a run of infinite log probabilities from turning into nan
+            if(next.mean_ != cur.mean_) cur.mean_ += (next.mean_ - cur.mean_) * next.weight_ / (cur.weight_ + next.weight_);
+            cur.weight_ += next.weight_;
+            cur.min_ = std::min(cur.min_, next.min_);
+            cur.max_ = std::max(cur.max_, next.max_);
+        }
+        else
+        {
+            centroids_.push_back(cur);
+            weight_before += cur.weight_;
+            q_limit = get_q_limit(weight_before / total, scale);
+            cur = next;
+        }
+    }
+    centroids_.push_back(cur);
+    buffer_.clear();
+}
+
+double T_digest::quantile(double q) const
+{
+    compress();
+    if(centroids_.empty()) throw Empty_exception(); //util::err_str(__FILE__, __LINE__);
+    double target = std::min(1.0, std::max(0.0, q)) * weight_;
+    double weight_before = 0.0;
+    size_t i = 0;
+    while(i + 1 < centroids_.size() && weight_before + centroids_[i].weight_ <= target)
+    {
+        weight_before += centroids_[i].weight_;
+        i++;
+    }
+    const Centroid &c = centroids_[i];
+    if(c.min_ == c.max_) return c.mean_;
+    double center = weight_before + c.weight_ / 2.0;
+    double r;
+    // interpolate between the centers of c and its neighbour on target's side
+    if(target < center)
+    {
+        if(i == 0) return c.min_ + (c.mean_ - c.min_) * target / center;
+        const Centroid &prev = centroids_[i - 1];
+        double prev_center = weight_before - prev.weight_ / 2.0;
+        r = prev.mean_ + (c.mean_ - prev.mean_) * (target - prev_center) / (center - prev_center);
+    }
+    else
+    {
+        if(i + 1 == centroids_.size())
+        {
+            double rest = weight_before + c.weight_ - center;
+            return rest > 0.0 ? c.mean_ + (c.max_ - c.mean_) * (target - center) / rest : c.mean_;
+        }
+        const Centroid &next = centroids_[i + 1];
+        double next_center = weight_before + c.weight_ + next.weight_ / 2.0;
+        r = c.mean_ + (next.mean_ - c.mean_) * (target - center) / (next_center - center);
+    }
+    return std::min(c.max_, std::max(c.min_, r));
+}
+
+Accumulator::Accumulator(cfg::Arguments_aggregator::Aggregation_type at) :
+        at_(at),
+        count_(0),
+        value_(0.0),
+        sum_(0.0)
+{
+    switch(at_)
+    {
+    case cfg::Arguments_aggregator::AT_MAX:
+    case cfg::Arguments_aggregator::AT_MIN:
+    case cfg::Arguments_aggregator::AT_MEAN:
+    case cfg::Arguments_aggregator::AT_FIRST:
+    case cfg::Arguments_aggregator::AT_MEDIAN:
+    case cfg::Arguments_aggregator::AT_LAST:
+        break;
+    default:
+        throw util::Unhandled_enum_value_exception(); //util::err_str(__FILE__, __LINE__);
+    }
+}
+
+void Accumulator::add(double value, unsigned count)
+{
+    if(!count) return;
+    switch(at_)
+    {
+    case cfg::Arguments_aggregator::AT_MAX:
+        value_ = count_ ? std::max(value_, value) : value;
+        break;
+    case cfg::Arguments_aggregator::AT_MIN:
+        value_ = count_ ? std::min(value_, value) : value;
+        break;
+    case cfg::Arguments_aggregator::AT_MEAN:
+        sum_ += value * count;
+        break;
+    case cfg::Arguments_aggregator::AT_FIRST:
+        if(!count_) value_ = value;
+        break;
+    case cfg::Arguments_aggregator::AT_MEDIAN:
+        digest_.add(value, double(count));
+        break;
+    case cfg::Arguments_aggregator::AT_LAST:
+        value_ = value;
+        break;
+    default:
+        throw util::Unhandled_enum_value_exception(); //util::err_str(__FILE__, __LINE__);
+    }
+    count_ += count;
+}
+
+double Accumulator::get() const
+{
+    if(!count_) throw Empty_exception(); //util::err_str(__FILE__, __LINE__);
+    if(at_ == cfg::Arguments_aggregator::AT_MEAN) return sum_ / double(count_);
+    if(at_ == cfg::Arguments_aggregator::AT_MEDIAN) return digest_.quantile(0.5);
+    return value_;
+}
+
+Entry_accumulator::Entry_accumulator(cfg::Arguments_aggregator::Aggregation_type at) :
+        log_prob_(at),
+        rvs_(RI_COUNT, Accumulator(at))
+{}
+
+void Entry_accumulator::add(const Chain_index_entry &e, unsigned count)
+{
+    log_prob_.add(e.log_prob_, count);
+    for(size_t i = 0; i < RI_COUNT; i++)
+    {
+        rvs_[i].add(e.rvs_[i], count);
+    }
+}
+
+Chain_index_entry Entry_accumulator::get() const
+{
+    Chain_index_entry r;
+    r.log_prob_ = log_prob_.get();
+    for(size_t i = 0; i < RI_COUNT; i++)
+    {
+        r.rvs_[i] = rvs_[i].get();
+    }
+    return r;
+}
+
+Range_binner::Range_binner(const cfg::Arguments_aggregator::Possible_aggregation &range)
+{
+    cfg::Arguments_aggregator::Aggregation_type at;
+    if(range.aggregate_)
+    {
+        start_ = range.data_.aggregation_range_.start_idx_;
+        stop_ = range.data_.aggregation_range_.stop_idx_;
+        stride_ = std::max(1u, range.data_.aggregation_range_.stride_);
+        bin_size_ = range.data_.aggregation_range_.bin_size_;
+        at = range.data_.aggregation_range_.type_;
+    }
+    else
+    {
+        // just the one index
+        start_ = stop_ = range.data_.no_aggregation_idx_;
+        stride_ = 1;
+        bin_size_ = 1;
+        at = cfg::Arguments_aggregator::AT_FIRST;
+    }
+    if(stop_ < start_) throw util::Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
+    unsigned range_len = stop_ + 1 - start_;
+    if(!bin_size_ || bin_size_ > range_len) bin_size_ = range_len;
+    bins_.assign((range_len + bin_size_ - 1) / bin_size_, Entry_accumulator(at));
+}
+
+unsigned Range_binner::get_bin_start(size_t k) const
+{
+    return start_ + unsigned(k) * bin_size_;
+}
+
+unsigned Range_binner::get_bin_stop(size_t k) const
+{
+    return std::min(stop_, get_bin_start(k) + bin_size_ - 1);
+}
+
+// the number of indices start + j * stride in [lo, hi), for lo >= start
+static unsigned long num_strided(unsigned long start, unsigned long stride, unsigned long lo, unsigned long hi)
+{
+    if(hi <= lo) return 0;
+    unsigned long first_j = (lo - start + stride - 1) / stride;
+    unsigned long guard_j = (hi - start + stride - 1) / stride;
+    return guard_j - first_j;
+}
+
+bool Range_binner::add(const Chain_index_entry &e)
+{
+    unsigned long lo = std::max<unsigned long>(e.first_iteration_, start_);
+    unsigned long hi = std::min<unsigned long>((unsigned long)(e.first_iteration_) + e.count_, (unsigned long)(stop_) + 1);
+    // A run is usually much shorter than a bin, so this visits one or two
+    // bins per entry.
+    for(size_t k = (lo - start_) / bin_size_; lo < hi; k++)
+    {
+        unsigned long bin_hi = std::min<unsigned long>((unsigned long)(get_bin_stop(k)) + 1, hi);
+        bins_[k].add(e, unsigned(num_strided(start_, stride_, lo, bin_hi)));
+        lo = bin_hi;
+    }
+    return (unsigned long)(e.first_iteration_) + e.count_ <= stop_;
+}
+
+}
+}
@@ -0,0 +1,143 @@
+#ifndef AGGREGATION_HPP
+#define AGGREGATION_HPP
+
+#include <vector>
+
+#include "config.hpp"
+#include "chain_index.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+
+// A t-digest (Dunning and Ertl, "Computing extremely accurate quantiles
+// using t-digests"): a quantile sketch of a stream of weighted values, in
+// O(compression) memory no matter how long the stream is.
+//
+// Accuracy: the values are kept as sorted centroids, each at most
+// (2 pi / compression) sqrt(q (1 - q)) of the total weight around its
+// quantile q, so the sketch is most accurate in the tails. A quantile is
+// interpolated from the two closest centroids, and clamped to the range of
+// values merged into the one it falls into. For the median, the rank of the
+// result is off by at most pi / (2 compression) of the total weight, 0.8%
+// with the default compression of 200, and usually much less. A value added
+// with a large weight (a long run of rejections) is never split, and acts
+// like that many copies of the value. While no centroids had to be merged
+// (fewer than about compression distinct values), quantiles are exact up to
+// the interpolation between neighbouring values.
+class T_digest
+{
+public:
+    class Empty_exception : std::exception {};
+
+    static const double COMPRESSION_DEF;
+
+    explicit T_digest(double compression = COMPRESSION_DEF);
+
+    void add(double value, double weight = 1.0);
+
+    double get_weight() const { return weight_; }
+    // q in [0, 1]
+    double quantile(double q) const;
+
+private:
+    class Centroid
+    {
+    public:
+        double mean_;
+        double weight_;
+        double min_;
+        double max_;
+
+        bool operator<(const Centroid &other) const { return mean_ < other.mean_; }
+    };
+
+    // Merges the buffered values into the centroids.
+    void compress() const;
+
+    double compression_;
+    double weight_;
+    // compressed lazily, so that quantile can be const
+    mutable std::vector<Centroid> centroids_;
+    mutable std::vector<Centroid> buffer_;
+};
+
+// Aggregates a stream of values with one of the Arguments_aggregator types.
+// AT_MEDIAN is estimated with a T_digest. The others are exact. All of them
+// take constant memory.
+class Accumulator
+{
+public:
+    class Empty_exception : std::exception {};
+
+    explicit Accumulator(cfg::Arguments_aggregator::Aggregation_type at);
+
+    // Adds value count times, after everything added before.
+    void add(double value, unsigned count = 1);
+
+    // The number of values added
+    unsigned long get_count() const { return count_; }
+    double get() const;
+
+private:
+    cfg::Arguments_aggregator::Aggregation_type at_;
+    unsigned long count_;
+    double value_;
+    double sum_;
+    T_digest digest_;
+};
+
+// An Accumulator of the log probability and each of the latents of a
+// Chain_index_entry.
+class Entry_accumulator
+{
+public:
+    explicit Entry_accumulator(cfg::Arguments_aggregator::Aggregation_type at);
+
+    void add(const Chain_index_entry &e, unsigned count = 1);
+
+    unsigned long get_count() const { return log_prob_.get_count(); }
+    // The aggregate of every field. Not a real entry: the iterations and
+    // accepted flag are left unset.
+    Chain_index_entry get() const;
+
+private:
+    Accumulator log_prob_;
+    std::vector<Accumulator> rvs_;
+};
+
+// The bins of an aggregation over an index range (see
+// Arguments_aggregator::Possible_aggregation), usually the iterations of one
+// chain: bin k covers indices [start + k * bin_size, start + (k + 1) *
+// bin_size), clipped to stop, and only every stride-th index counted from
+// start is aggregated. A single index is one bin that takes its value. Feed
+// it entries in order. An entry stands for the indices [first_iteration_,
+// first_iteration_ + count_).
+class Range_binner
+{
+public:
+    explicit Range_binner(const cfg::Arguments_aggregator::Possible_aggregation &range);
+
+    // Adds the indices of e in the range to their bins. false once e reaches
+    // past the range, so that the entries after it can be skipped.
+    bool add(const Chain_index_entry &e);
+
+    size_t get_num_bins() const { return bins_.size(); }
+    // first and last index (inclusive) of bin k
+    unsigned get_bin_start(size_t k) const;
+    unsigned get_bin_stop(size_t k) const;
+    const Entry_accumulator &get_bin(size_t k) const { return bins_[k]; }
+
+private:
+    unsigned start_;
+    unsigned stop_;
+    unsigned stride_;
+    unsigned bin_size_;
+    std::vector<Entry_accumulator> bins_;
+};
+
+}
+}
+
+#endif // AGGREGATION_HPP
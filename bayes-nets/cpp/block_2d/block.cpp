@@ -17,6 +17,26 @@ bool Block::operator==(const Block &other) const
             && (states_over_time_ == other.states_over_time_);
 }
 
+void Block::extend(const Camera & c, const Block & data)
+{
+    size_t final_timestamp = data.init_timestamp_ + data.states_over_time_.size();
+    for(size_t t = init_timestamp_ + states_over_time_.size(); t < final_timestamp; t++)
+    {
+        states_over_time_.push_back(State(
+                Hidden_state(c, geom_, states_over_time_.back().get_hidden_state()),
+                data.get_state(t).get_observed_state()));
+    }
+}
+
+void Block::truncate(size_t final_timestamp)
+{
+    if(final_timestamp <= init_timestamp_) throw Timestamp_out_of_bounds_exception();
+    if(final_timestamp - init_timestamp_ < states_over_time_.size())
+    {
+        states_over_time_.resize(final_timestamp - init_timestamp_);
+    }
+}
+
 void Block::recalculate_parent_values(const Camera &c, const Initial_block_rvs &ibr)
 {
     geom_.recalculate_parent_values(ibr);
@@ -80,6 +80,12 @@ public:
 
     void set_geometry(const Block_geom & g) { geom_ = g; }
 
+    // Simulates the timestamps data has past this block's last one, and takes
+    // their observations from data. The states already here are left alone.
+    void extend(const Camera & c, const Block & data);
+    // Drops the states from final_timestamp on. Keeps at least the first.
+    void truncate(size_t final_timestamp);
+
     double log_prob(const kjb::Normal_distribution & image_noise_dist) const
     {
         double accum = 0.0;
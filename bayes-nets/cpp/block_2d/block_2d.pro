@@ -4,11 +4,15 @@ CONFIG -= app_bundle
 CONFIG -= qt
 
 SOURCES += \
+    aggregation.cpp \
     annealing_schedule.cpp \
     block.cpp \
     block_geom.cpp \
     camera.cpp \
+    canvas.cpp \
+    chain_index.cpp \
     config.cpp \
+    csv_writer.cpp \
     driver_aggregator.cpp \
     driver_csv_chain.cpp \
     driver_csv_explr_rate.cpp \
@@ -16,39 +20,66 @@ SOURCES += \
     driver_csv_metrics.cpp \
     driver_data_gen.cpp \
     driver_data_image_gen.cpp \
+    driver_experiment.cpp \
     driver_image_combiner.cpp \
+    driver_index_chains.cpp \
     driver_inference_graddesc.cpp \
     driver_inference_hmc.cpp \
     driver_inference_image_gen.cpp \
     driver_inference_mh.cpp \
+    driver_inference_smc.cpp \
     fracture_rvs.cpp \
+    frame_renderer.cpp \
     hidden_state.cpp \
     initial_block_rvs.cpp \
+    least_squares.cpp \
     metropolis_hastings.cpp \
     prob.cpp \
     sample.cpp \
     sample_vector_adapter.cpp \
+    smc.cpp \
+    task_graph.cpp \
+    test_aggregation.cpp \
     test_archive.cpp \
+    test_canvas.cpp \
+    test_chain_index.cpp \
+    test_csv_writer.cpp \
     test_inference_mh.cpp \
+    test_least_squares.cpp \
     test_modify_vars.cpp \
-    util.cpp
+    test_smc.cpp \
+    thread_pool.cpp \
+    trace_codec.cpp \
+    util.cpp \
+    video_writer.cpp
 
 HEADERS += \
+    aggregation.hpp \
     annealing_schedule.hpp \
     block.hpp \
     block_geom.hpp \
     camera.hpp \
+    canvas.hpp \
+    chain_index.hpp \
     config.hpp \
+    csv_writer.hpp \
     fracture_rvs.hpp \
+    frame_renderer.hpp \
     hidden_state.hpp \
     initial_block_rvs.hpp \
+    least_squares.hpp \
     metropolis_hastings.hpp \
     observed_state.hpp \
     prob.hpp \
     sample.hpp \
     sample_vector_adapter.hpp \
+    smc.hpp \
     state.hpp \
-    util.hpp
+    task_graph.hpp \
+    thread_pool.hpp \
+    trace_codec.hpp \
+    util.hpp \
+    video_writer.hpp
 
 INCLUDEPATH += \
     /home/simon/svn-repos/ivilab/src/lib
@@ -0,0 +1,189 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+
+#include "canvas.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+Canvas::Canvas(unsigned im_w, unsigned im_h, const kjb::Image::Pixel_type &background) :
+        im_w_(im_w),
+        im_h_(im_h),
+        pixels_(size_t(im_w) * im_h, 0),
+        palette_(1, background)
+{}
+
+void Canvas::clear()
+{
+    std::fill(pixels_.begin(), pixels_.end(), 0);
+}
+
+void Canvas::draw_point(double row, double col, unsigned width, const kjb::Image::Pixel_type &color)
+{
+    unsigned char idx = get_color_idx(color);
+    int center_row = int(std::floor(row + 0.5));
+    int center_col = int(std::floor(col + 0.5));
+    for(int r = center_row - int(width); r <= center_row + int(width); r++)
+    {
+        for(int c = center_col - int(width); c <= center_col + int(width); c++)
+        {
+            set_pixel(r, c, idx);
+        }
+    }
+}
+
+void Canvas::draw_line_segment(int row_1, int col_1, int row_2, int col_2, const kjb::Image::Pixel_type &color)
+{
+    unsigned char idx = get_color_idx(color);
+    // Blocks that fell out of view can be far off. Skip those rather than
+    // stepping through all of their pixels.
+    if((row_1 < 0 && row_2 < 0) || (col_1 < 0 && col_2 < 0)) return;
+    if((row_1 >= int(im_h_) && row_2 >= int(im_h_)) || (col_1 >= int(im_w_) && col_2 >= int(im_w_))) return;
+
+    int d_row = std::abs(row_2 - row_1);
+    int d_col = -std::abs(col_2 - col_1);
+    int step_row = row_1 < row_2 ? 1 : -1;
+    int step_col = col_1 < col_2 ? 1 : -1;
+    int err = d_row + d_col;
+    while(true)
+    {
+        set_pixel(row_1, col_1, idx);
+        if(row_1 == row_2 && col_1 == col_2) break;
+        int err_2 = 2 * err;
+        if(err_2 >= d_col)
+        {
+            err += d_col;
+            row_1 += step_row;
+        }
+        if(err_2 <= d_row)
+        {
+            err += d_row;
+            col_1 += step_col;
+        }
+    }
+}
+
+unsigned char Canvas::get_color_idx(const kjb::Image::Pixel_type &color)
+{
+    for(size_t i = 0; i < palette_.size(); i++)
+    {
+        if(palette_[i].r == color.r && palette_[i].g == color.g && palette_[i].b == color.b)
+        {
+            return (unsigned char)(i);
+        }
+    }
+    if(palette_.size() == MAX_NUM_COLORS) throw Palette_full_exception(); //util::err_str(__FILE__, __LINE__);
+    palette_.push_back(color);
+    return (unsigned char)(palette_.size() - 1);
+}
+
+// little-endian TIFF fields
+static void put_u16(std::vector<char> &buf, uint16_t v)
+{
+    buf.push_back(char(v & 0xff));
+    buf.push_back(char(v >> 8));
+}
+
+static void put_u32(std::vector<char> &buf, uint32_t v)
+{
+    put_u16(buf, uint16_t(v & 0xffff));
+    put_u16(buf, uint16_t(v >> 16));
+}
+
+enum Tiff_field_type
+{
+    TFT_SHORT = 3,
+    TFT_LONG = 4,
+    TFT_RATIONAL = 5
+};
+
+static void put_ifd_entry(std::vector<char> &buf, uint16_t tag, Tiff_field_type type, uint32_t count, uint32_t value)
+{
+    put_u16(buf, tag);
+    put_u16(buf, uint16_t(type));
+    put_u32(buf, count);
+    if(type == TFT_SHORT && count == 1)
+    {
+        // left-justified in the value field
+        put_u16(buf, uint16_t(value));
+        put_u16(buf, 0);
+    }
+    else
+    {
+        put_u32(buf, value);
+    }
+}
+
+static uint16_t color_channel_to_u16(float c)
+{
+    return uint16_t(std::min(255.0f, std::max(0.0f, std::round(c))) * 257.0f);
+}
+
+void Canvas::write(const boost::filesystem::path &p) const
+{
+    // header, one IFD, the resolutions and the color map, then the pixels
+    // as one strip
+    const uint16_t num_entries = 13;
+    const uint32_t ifd_offset = 8;
+    const uint32_t x_res_offset = ifd_offset + 2 + 12 * num_entries + 4;
+    const uint32_t y_res_offset = x_res_offset + 8;
+    const uint32_t color_map_offset = y_res_offset + 8;
+    const uint32_t pixels_offset = color_map_offset + 3 * MAX_NUM_COLORS * 2;
+
+    std::vector<char> buf;
+    buf.reserve(pixels_offset);
+    buf.push_back('I');
+    buf.push_back('I');
+    put_u16(buf, 42);
+    put_u32(buf, ifd_offset);
+
+    put_u16(buf, num_entries);
+    put_ifd_entry(buf, 256, TFT_LONG, 1, im_w_);                            // ImageWidth
+    put_ifd_entry(buf, 257, TFT_LONG, 1, im_h_);                            // ImageLength
+    put_ifd_entry(buf, 258, TFT_SHORT, 1, 8);                               // BitsPerSample
+    put_ifd_entry(buf, 259, TFT_SHORT, 1, 1);                               // Compression: none
+    put_ifd_entry(buf, 262, TFT_SHORT, 1, 3);                               // PhotometricInterpretation: palette
+    put_ifd_entry(buf, 273, TFT_LONG, 1, pixels_offset);                    // StripOffsets
+    put_ifd_entry(buf, 277, TFT_SHORT, 1, 1);                               // SamplesPerPixel
+    put_ifd_entry(buf, 278, TFT_LONG, 1, im_h_);                            // RowsPerStrip
+    put_ifd_entry(buf, 279, TFT_LONG, 1, uint32_t(pixels_.size()));         // StripByteCounts
+    put_ifd_entry(buf, 282, TFT_RATIONAL, 1, x_res_offset);                 // XResolution
+    put_ifd_entry(buf, 283, TFT_RATIONAL, 1, y_res_offset);                 // YResolution
+    put_ifd_entry(buf, 296, TFT_SHORT, 1, 2);                               // ResolutionUnit: inch
+    put_ifd_entry(buf, 320, TFT_SHORT, 3 * MAX_NUM_COLORS, color_map_offset); // ColorMap
+    put_u32(buf, 0);
+
+    // 72 dpi
+    put_u32(buf, 72);
+    put_u32(buf, 1);
+    put_u32(buf, 72);
+    put_u32(buf, 1);
+
+    // all the reds, then the greens, then the blues
+    for(unsigned channel = 0; channel < 3; channel++)
+    {
+        for(size_t i = 0; i < MAX_NUM_COLORS; i++)
+        {
+            if(i >= palette_.size())
+            {
+                put_u16(buf, 0);
+                continue;
+            }
+            const kjb::Image::Pixel_type &c = palette_[i];
+            put_u16(buf, color_channel_to_u16(channel == 0 ? c.r : channel == 1 ? c.g : c.b));
+        }
+    }
+
+    std::ofstream f(p.string(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    f.write(buf.data(), std::streamsize(buf.size()));
+    f.write(reinterpret_cast<const char *>(pixels_.data()), std::streamsize(pixels_.size()));
+    if(!f) throw Write_exception(); //util::err_str(__FILE__, __LINE__);
+}
+
+}
+}
@@ -0,0 +1,68 @@
+#ifndef CANVAS_HPP
+#define CANVAS_HPP
+
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <i_cpp/i_image.h>
+
+namespace fracture
+{
+namespace util
+{
+
+// An image for line art: one byte per pixel, indexing a palette of at most
+// 256 colors. Entry 0 is the background. The colors are added to the palette
+// the first time they're drawn with.
+//
+// Coordinates are (row, col), like kjb::Image's. Anything drawn outside of
+// the canvas is clipped.
+class Canvas
+{
+public:
+    class Palette_full_exception : std::exception {};
+    class Write_exception : std::exception {};
+
+    static const size_t MAX_NUM_COLORS = 256;
+
+    Canvas(unsigned im_w, unsigned im_h, const kjb::Image::Pixel_type &background);
+
+    unsigned get_num_rows() const { return im_h_; }
+    unsigned get_num_cols() const { return im_w_; }
+
+    // Sets every pixel back to the background. The palette is kept.
+    void clear();
+
+    // A square of (2 * width + 1) pixels a side, centered on the pixel
+    // nearest to (row, col).
+    void draw_point(double row, double col, unsigned width, const kjb::Image::Pixel_type &color);
+    // A one pixel wide line, endpoints included (Bresenham).
+    void draw_line_segment(int row_1, int col_1, int row_2, int col_2, const kjb::Image::Pixel_type &color);
+
+    // palette index of the pixel
+    unsigned char operator()(unsigned row, unsigned col) const { return pixels_[size_t(row) * im_w_ + col]; }
+    const kjb::Image::Pixel_type &get_color(unsigned char idx) const { return palette_[idx]; }
+    size_t get_num_colors() const { return palette_.size(); }
+
+    // Writes an uncompressed 8-bit palette TIFF.
+    void write(const boost::filesystem::path &p) const;
+
+private:
+    unsigned char get_color_idx(const kjb::Image::Pixel_type &color);
+    void set_pixel(int row, int col, unsigned char idx)
+    {
+        if(row < 0 || col < 0 || row >= int(im_h_) || col >= int(im_w_)) return;
+        pixels_[size_t(row) * im_w_ + size_t(col)] = idx;
+    }
+
+    unsigned im_w_;
+    unsigned im_h_;
+    std::vector<unsigned char> pixels_;
+    std::vector<kjb::Image::Pixel_type> palette_;
+};
+
+}
+}
+
+#endif // CANVAS_HPP
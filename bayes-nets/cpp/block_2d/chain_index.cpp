@@ -0,0 +1,441 @@
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "chain_index.hpp"
+#include "csv_writer.hpp"
+#include "trace_codec.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+
+const char Chain_index::MAGIC[4] = {'F', 'C', 'I', 'X'};
+const unsigned Chain_index::VERSION = 2;
+const unsigned Chain_index::BLOCK_SIZE = 4096;
+
+template<typename T>
+static void write_raw(std::ofstream &f, const T &val)
+{
+    f.write(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+template<typename T>
+static void read_raw(std::ifstream &f, T &val)
+{
+    f.read(reinterpret_cast<char *>(&val), sizeof(T));
+    if(!f) throw Chain_index::Format_exception(); //util::err_str(__FILE__, __LINE__);
+}
+
+Chain_index_entry::Chain_index_entry(
+        const Sample &s,
+        double log_prob,
+        unsigned first_iteration,
+        unsigned count,
+        bool accepted) :
+
+        first_iteration_(first_iteration),
+        count_(count),
+        accepted_(accepted),
+        log_prob_(log_prob)
+{
+    Sample_vector_adapter sva;
+    for(size_t i = 0; i < RI_COUNT; i++)
+    {
+        rvs_[i] = sva.get(&s, i);
+    }
+}
+
+Chain_index::Chain_index(const Inference_record_20261019 &chain, const std::vector<double> &log_probs) :
+        rng_seed_(chain.rng_seed_)
+{
+    entries_.reserve(chain.runs_.size());
+    unsigned first_iteration = 0;
+    for(size_t i = 0; i < chain.runs_.size(); i++)
+    {
+        entries_.push_back(Chain_index_entry(
+                *chain.runs_[i].sample_,
+                log_probs[i],
+                first_iteration,
+                chain.runs_[i].count_,
+                i != 0));
+        first_iteration += chain.runs_[i].count_;
+    }
+}
+
+size_t Chain_index::get_num_iterations() const
+{
+    if(entries_.empty()) return 0;
+    return size_t(entries_.back().first_iteration_) + entries_.back().count_;
+}
+
+static double get_column_value(const Chain_index_entry &e, Index_column c)
+{
+    return c == IC_LOG_PROB ? e.log_prob_ : e.rvs_[c - IC_RVS];
+}
+
+static double &get_column_value(Chain_index_entry &e, Index_column c)
+{
+    return c == IC_LOG_PROB ? e.log_prob_ : e.rvs_[c - IC_RVS];
+}
+
+static void encode_column(
+        std::vector<Chain_index_entry>::const_iterator begin,
+        std::vector<Chain_index_entry>::const_iterator end,
+        Index_column c,
+        util::Bit_writer &out)
+{
+    if(c == IC_RUN_LENGTH)
+    {
+        for(auto it = begin; it != end; it++)
+        {
+            out.write_varint(it->count_);
+        }
+    }
+    else if(c == IC_ACCEPTED)
+    {
+        std::vector<bool> flags;
+        for(auto it = begin; it != end; it++)
+        {
+            flags.push_back(it->accepted_);
+        }
+        util::encode_flag_runs(flags, out);
+    }
+    else
+    {
+        util::Xor_encoder enc(out);
+        for(auto it = begin; it != end; it++)
+        {
+            enc.write(get_column_value(*it, c));
+        }
+    }
+}
+
+void Chain_index::save(const boost::filesystem::path &p) const
+{
+    std::ofstream f(p.string(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    f.write(MAGIC, sizeof(MAGIC));
+    write_raw(f, uint32_t(VERSION));
+    write_raw(f, uint32_t(rng_seed_));
+    write_raw(f, uint64_t(entries_.size()));
+    std::vector<util::Bit_writer> columns(IC_COUNT);
+    for(size_t block_start = 0; block_start < entries_.size(); block_start += BLOCK_SIZE)
+    {
+        auto begin = entries_.begin() + std::ptrdiff_t(block_start);
+        auto end = entries_.begin() + std::ptrdiff_t(std::min(entries_.size(), block_start + BLOCK_SIZE));
+        write_raw(f, uint32_t(end - begin));
+        for(size_t c = 0; c < IC_COUNT; c++)
+        {
+            columns[c].clear();
+            encode_column(begin, end, Index_column(c), columns[c]);
+            write_raw(f, uint32_t(columns[c].get_bytes().size()));
+        }
+        for(size_t c = 0; c < IC_COUNT; c++)
+        {
+            f.write(reinterpret_cast<const char *>(columns[c].get_bytes().data()), std::streamsize(columns[c].get_bytes().size()));
+        }
+    }
+}
+
+void Chain_index::load(const boost::filesystem::path &p)
+{
+    Chain_index_reader reader(p);
+    rng_seed_ = reader.get_rng_seed();
+    entries_.resize(reader.get_num_entries());
+    for(Chain_index_entry &e : entries_)
+    {
+        reader.next(e);
+    }
+}
+
+Chain_index_reader::Chain_index_reader(const boost::filesystem::path &p) :
+        Chain_index_reader(p, IC_COUNT)
+{}
+
+Chain_index_reader::Chain_index_reader(const boost::filesystem::path &p, Index_column c) :
+        f_(p.string(), std::ios_base::in | std::ios_base::binary),
+        column_(c),
+        num_read_(0),
+        next_first_iteration_(0),
+        block_pos_(0)
+{
+    char magic[sizeof(Chain_index::MAGIC)];
+    f_.read(magic, sizeof(magic));
+    if(!f_ || std::memcmp(magic, Chain_index::MAGIC, sizeof(magic)) != 0) throw Chain_index::Format_exception(); //util::err_str(__FILE__, __LINE__);
+    uint32_t version;
+    read_raw(f_, version);
+    // 1 is the uncompressed, row per entry layout
+    if(version != Chain_index::VERSION && version != 1) throw Chain_index::Format_exception(); //util::err_str(__FILE__, __LINE__);
+    version_ = version;
+    uint32_t rng_seed;
+    read_raw(f_, rng_seed);
+    rng_seed_ = rng_seed;
+    read_raw(f_, num_entries_);
+}
+
+void Chain_index_reader::read_block()
+{
+    uint32_t num_block_entries;
+    read_raw(f_, num_block_entries);
+    if(!num_block_entries || num_block_entries > num_entries_ - num_read_) throw Chain_index::Format_exception(); //util::err_str(__FILE__, __LINE__);
+    uint32_t sizes[IC_COUNT];
+    for(size_t c = 0; c < IC_COUNT; c++)
+    {
+        read_raw(f_, sizes[c]);
+    }
+    block_.resize(num_block_entries);
+    block_pos_ = 0;
+    try
+    {
+        for(size_t c = 0; c < IC_COUNT; c++)
+        {
+            if(column_ != IC_COUNT && c != IC_RUN_LENGTH && c != size_t(column_))
+            {
+                f_.seekg(std::streamoff(sizes[c]), std::ios_base::cur);
+                continue;
+            }
+            column_bytes_.resize(sizes[c]);
+            f_.read(reinterpret_cast<char *>(column_bytes_.data()), std::streamsize(sizes[c]));
+            if(!f_) throw Chain_index::Format_exception(); //util::err_str(__FILE__, __LINE__);
+            util::Bit_reader in(column_bytes_.data(), column_bytes_.size());
+            if(c == IC_RUN_LENGTH)
+            {
+                for(Chain_index_entry &e : block_)
+                {
+                    e.first_iteration_ = next_first_iteration_;
+                    e.count_ = unsigned(in.read_varint());
+                    next_first_iteration_ += e.count_;
+                }
+            }
+            else if(c == IC_ACCEPTED)
+            {
+                std::vector<bool> flags;
+                util::decode_flag_runs(in, block_.size(), flags);
+                for(size_t i = 0; i < block_.size(); i++)
+                {
+                    block_[i].accepted_ = flags[i];
+                }
+            }
+            else
+            {
+                util::Xor_decoder dec(in);
+                for(Chain_index_entry &e : block_)
+                {
+                    get_column_value(e, Index_column(c)) = dec.read();
+                }
+            }
+        }
+    }
+    catch(util::Trace_codec_exception &)
+    {
+        throw Chain_index::Format_exception(); //util::err_str(__FILE__, __LINE__);
+    }
+}
+
+bool Chain_index_reader::next(Chain_index_entry &e)
+{
+    if(num_read_ == num_entries_) return false;
+    if(version_ == 1)
+    {
+        uint32_t first_iteration;
+        uint32_t count;
+        uint8_t accepted;
+        read_raw(f_, first_iteration);
+        read_raw(f_, count);
+        read_raw(f_, accepted);
+        read_raw(f_, e.log_prob_);
+        for(size_t i = 0; i < RI_COUNT; i++)
+        {
+            read_raw(f_, e.rvs_[i]);
+        }
+        e.first_iteration_ = first_iteration;
+        e.count_ = count;
+        e.accepted_ = accepted != 0;
+    }
+    else
+    {
+        if(block_pos_ == block_.size()) read_block();
+        e = block_[block_pos_++];
+    }
+    num_read_++;
+    return true;
+}
+
+void save_chain_index(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        const Chain_index &in)
+{
+    in.save(util::get_inference_index_path(data_dir, dataset_idx, it, flex_vars));
+}
+
+bool has_chain_index(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars)
+{
+    boost::filesystem::path index_path = util::get_inference_index_path(data_dir, dataset_idx, it, flex_vars);
+    if(!boost::filesystem::exists(index_path)) return false;
+    // A chain that was rerun after indexing makes the sidecar stale.
+    boost::filesystem::path archive_path = util::get_inference_archive_path(data_dir, dataset_idx, it, flex_vars);
+    return !boost::filesystem::exists(archive_path)
+            || boost::filesystem::last_write_time(archive_path) <= boost::filesystem::last_write_time(index_path);
+}
+
+void load_chain_indices(
+        util::Thread_pool &pool,
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<std::vector<unsigned>> &flex_vars,
+        unsigned archive_ver,
+        std::vector<Chain_index> &out)
+{
+    out.clear();
+    out.resize(flex_vars.size());
+    std::vector<Inference_record_20261019> chains(flex_vars.size());
+    std::vector<char> indexed(flex_vars.size());
+    pool.parallel_for(flex_vars.size(), [&](size_t i)
+    {
+        indexed[i] = has_chain_index(data_dir, dataset_idx, it, flex_vars[i]);
+        if(indexed[i])
+        {
+            out[i].load(util::get_inference_index_path(data_dir, dataset_idx, it, flex_vars[i]));
+        }
+        else
+        {
+            load_inference_chain(data_dir, dataset_idx, it, flex_vars[i], archive_ver, chains[i]);
+        }
+    });
+
+    // Chains with a sidecar have no runs here and cost nothing.
+    std::vector<std::vector<double>> log_probs;
+    cache_log_probs(pool, chains, log_probs);
+
+    for(size_t i = 0; i < flex_vars.size(); i++)
+    {
+        if(indexed[i]) continue;
+        out[i] = Chain_index(chains[i], log_probs[i]);
+        for(Sample_run &run : chains[i].runs_)
+        {
+            delete run.sample_;
+        }
+    }
+}
+
+void stream_chain_index(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        unsigned archive_ver,
+        const std::function<bool(const Chain_index_entry &)> &f,
+        Index_column column)
+{
+    if(has_chain_index(data_dir, dataset_idx, it, flex_vars))
+    {
+        Chain_index_reader reader(util::get_inference_index_path(data_dir, dataset_idx, it, flex_vars), column);
+        Chain_index_entry e;
+        while(reader.next(e))
+        {
+            if(!f(e)) return;
+        }
+        return;
+    }
+
+    Inference_record_20261019 chain;
+    load_inference_chain(data_dir, dataset_idx, it, flex_vars, archive_ver, chain);
+    std::vector<double> log_probs;
+    log_probs.reserve(chain.runs_.size());
+    for(const Sample_run &run : chain.runs_)
+    {
+        log_probs.push_back(run.sample_->log_prob());
+    }
+    Chain_index index(chain, log_probs);
+    for(Sample_run &run : chain.runs_)
+    {
+        delete run.sample_;
+    }
+    for(const Chain_index_entry &e : index.entries_)
+    {
+        if(!f(e)) return;
+    }
+}
+
+void save_chain_comparison_csv(
+        const std::string &data_dir,
+        unsigned data_idx,
+        unsigned expl_rate,
+        const std::vector<Chain_index> &chains,
+        double ground_truth_log_prob)
+{
+    using namespace fracture::util;
+    boost::filesystem::path sample_instance_path = get_sample_path(data_dir, data_idx);
+    std::ostringstream fname;
+    fname << pad_unsigned(data_idx) << "_" << util::INFERENCE_TYPE_STR[util::IT_METROPOLIS] << "_" << pad_unsigned(expl_rate) << "_chain_comparison.csv";
+    sample_instance_path /= fname.str();
+    std::vector<std::string> columns(1, "Iteration");
+    for(size_t i = 0; i < chains.size(); i++)
+    {
+        columns.push_back("Chain " + std::to_string(i));
+    }
+    columns.push_back("True Log Probability");
+    Csv_writer f(sample_instance_path, columns);
+
+    // Write a row at every iteration where at least one chain starts a new
+    // run, i.e. wherever some chain accepted a move. A chain that ends early
+    // keeps its last log probability, and an empty one gets empty cells.
+    size_t num_iterations = 0;
+    for(const Chain_index &c : chains)
+    {
+        num_iterations = std::max(num_iterations, c.get_num_iterations());
+    }
+    std::vector<size_t> cur_run(chains.size(), 0);
+    std::vector<size_t> cur_run_end(chains.size());
+    for(size_t i = 0; i < chains.size(); i++)
+    {
+        cur_run_end[i] = chains[i].entries_.empty() ? 0 : chains[i].entries_[0].count_;
+    }
+    size_t j = 0;
+    while(j < num_iterations)
+    {
+        // Move every chain whose run ended by j onto the run holding j.
+        for(size_t i = 0; i < chains.size(); i++)
+        {
+            while(cur_run_end[i] <= j && cur_run[i] + 1 < chains[i].entries_.size())
+            {
+                cur_run[i]++;
+                cur_run_end[i] += chains[i].entries_[cur_run[i]].count_;
+            }
+        }
+
+        f.write(j);
+        for(size_t i = 0; i < chains.size(); i++)
+        {
+            if(chains[i].entries_.empty()) f.write(std::string());
+            else f.write(chains[i].entries_[cur_run[i]].log_prob_);
+        }
+        f.write(ground_truth_log_prob);
+        f.end_row();
+
+        // The end of a chain's last run is not an acceptance.
+        size_t next_j = num_iterations;
+        for(size_t i = 0; i < chains.size(); i++)
+        {
+            if(cur_run[i] + 1 < chains[i].entries_.size() && cur_run_end[i] < next_j) next_j = cur_run_end[i];
+        }
+        j = next_j;
+    }
+}
+
+
+}
+}
@@ -0,0 +1,185 @@
+#ifndef CHAIN_INDEX_HPP
+#define CHAIN_INDEX_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <functional>
+
+#include <boost/filesystem/path.hpp>
+
+#include "sample.hpp"
+#include "sample_vector_adapter.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+
+// The metrics of one run of a chain (see Sample_run): everything the csv and
+// aggregation drivers need, without the Sample itself.
+class Chain_index_entry
+{
+public:
+    Chain_index_entry() {}
+    Chain_index_entry(
+            const Sample &s,
+            double log_prob,
+            unsigned first_iteration,
+            unsigned count,
+            bool accepted);
+
+    // The run covers iterations [first_iteration_, first_iteration_ + count_).
+    unsigned first_iteration_;
+    unsigned count_;
+    // Whether the first iteration of the run was an accepted move. Only the
+    // initial sample of a chain was not. The other count_ - 1 iterations of a
+    // run are always rejections.
+    bool accepted_;
+    double log_prob_;
+    // indexed by Rvs_idx
+    double rvs_[RI_COUNT];
+};
+
+// The columns of a sidecar (see Chain_index).
+enum Index_column
+{
+    IC_RUN_LENGTH,
+    IC_ACCEPTED,
+    IC_LOG_PROB,
+    // the RI_COUNT latents, in Rvs_idx order
+    IC_RVS,
+
+    // DO NOT CREATE ENTRIES BELOW HERE
+    IC_COUNT = IC_RVS + RI_COUNT
+};
+
+// A compact sidecar for an inference archive, written once by
+// driver_index_chains. The drivers that only need metrics read it instead of
+// deserializing the archive.
+//
+// File layout (native byte order): MAGIC, VERSION, rng seed, number of
+// entries, then the entries in blocks of up to BLOCK_SIZE. A block is its
+// number of entries, the size in bytes of each of its IC_COUNT columns,
+// then the columns (see trace_codec.hpp): the run lengths as varints, the
+// accepted flags run-length encoded, and the log probability and latents
+// XOR compressed. The first iteration of an entry is the sum of the run
+// lengths before it. A column of a block can be skipped without decoding
+// it, so reading one variable's trace costs about that column's size.
+//
+// Version 1 sidecars, an uncompressed row per entry, can still be read.
+class Chain_index
+{
+public:
+    class Format_exception : std::exception {};
+
+    static const char MAGIC[4];
+    static const unsigned VERSION;
+    static const unsigned BLOCK_SIZE;
+
+    Chain_index() : rng_seed_(0) {}
+    // log_probs[i] is the log probability of chain.runs_[i].
+    Chain_index(const Inference_record_20261019 &chain, const std::vector<double> &log_probs);
+
+    size_t get_num_iterations() const;
+
+    void save(const boost::filesystem::path &p) const;
+    void load(const boost::filesystem::path &p);
+
+    unsigned rng_seed_;
+    std::vector<Chain_index_entry> entries_;
+};
+
+// Reads a sidecar written by Chain_index::save one entry at a time, for
+// passes over a chain that don't need all of it in memory. At most a block
+// is decoded at a time.
+class Chain_index_reader
+{
+public:
+    explicit Chain_index_reader(const boost::filesystem::path &p);
+    // Only decodes the iterations of the entries and column c; the other
+    // fields of the entries are left unset. The other columns are skipped.
+    Chain_index_reader(const boost::filesystem::path &p, Index_column c);
+
+    unsigned get_rng_seed() const { return rng_seed_; }
+    uint64_t get_num_entries() const { return num_entries_; }
+
+    // Reads the next entry into e. false once every entry was read.
+    bool next(Chain_index_entry &e);
+
+private:
+    void read_block();
+
+    std::ifstream f_;
+    // IC_COUNT for all of them
+    Index_column column_;
+    unsigned version_;
+    unsigned rng_seed_;
+    uint64_t num_entries_;
+    uint64_t num_read_;
+    unsigned next_first_iteration_;
+    std::vector<Chain_index_entry> block_;
+    size_t block_pos_;
+    std::vector<uint8_t> column_bytes_;
+};
+
+void save_chain_index(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        const Chain_index &in);
+
+// Whether a sidecar exists that is not older than its archive.
+bool has_chain_index(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars);
+
+// Gets the index of one chain per entry of flex_vars, out[i] being the chain
+// for flex_vars[i]. Sidecars are used where present. Otherwise, the archive
+// is loaded and indexed in memory (and freed again), with the log
+// probabilities computed on the pool.
+void load_chain_indices(
+        util::Thread_pool &pool,
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<std::vector<unsigned>> &flex_vars,
+        unsigned archive_ver,
+        std::vector<Chain_index> &out);
+
+// Calls f on the entries of one chain in order, until f returns false. They
+// are read one at a time from the sidecar if there is one. Otherwise, the
+// archive is loaded and indexed first. With a column other than IC_COUNT,
+// only that column of the sidecar is read, and the other fields of the
+// entries may be unset.
+void stream_chain_index(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        unsigned archive_ver,
+        const std::function<bool(const Chain_index_entry &)> &f,
+        Index_column column = IC_COUNT);
+
+// Writes the log probability of every chain of one dataset and exploration
+// rate side by side, one row per iteration at which any of the chains accepted
+// a move, to <dataset>_<inference type>_<exploration rate>_chain_comparison.csv
+// in the dataset's folder. The chains may differ in length; one that ends
+// early repeats its last log probability, and an empty one is left blank.
+void save_chain_comparison_csv(
+        const std::string &data_dir,
+        unsigned data_idx,
+        unsigned expl_rate,
+        const std::vector<Chain_index> &chains,
+        double ground_truth_log_prob);
+
+}
+}
+
+#endif // CHAIN_INDEX_HPP
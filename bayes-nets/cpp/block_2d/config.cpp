@@ -1,3 +1,5 @@
+#include <fstream>
+
 #include "config.hpp"
 #include "util.hpp"
 
@@ -11,6 +13,8 @@ const std::vector<std::string> Arguments_data_gen::CAM_FPS_OPTION     = {"-f", "
 const std::vector<std::string> Arguments_data_gen::DATASET_IDX_OPTION = {"-i", "--index"};
 const std::vector<std::string> Arguments_data_gen::RNG_SEED_OPTION    = {"-s", "--seed"};
 const std::vector<std::string> Arguments_data_gen::DATA_FOLDER_OPTION = {"-d", "--data-folder"};
+const std::vector<std::string> Arguments_data_gen::NUM_DATASETS_OPTION = {"-N", "--num-datasets"};
+const std::vector<std::string> Arguments_data_gen::BINARY_OPTION = {"-b", "--binary"};
 const unsigned Arguments_data_gen::NUM_IMS_DEF        = 30;
 const unsigned Arguments_data_gen::IM_W_DEF           = 640;
 const unsigned Arguments_data_gen::IM_H_DEF           = 480;
@@ -18,6 +22,8 @@ const double Arguments_data_gen::CAM_FPS_DEF          = 30.0;
 const unsigned Arguments_data_gen::DATASET_IDX_DEF    = 0;
 const unsigned Arguments_data_gen::RNG_SEED_DEF       = unsigned(util::get_sys_time_nano());
 const std::string Arguments_data_gen::DATA_FOLDER_DEF = "./data/";
+const unsigned Arguments_data_gen::NUM_DATASETS_DEF = 0;
+const bool Arguments_data_gen::BINARY_DEF = false;
 
 Arguments_data_gen::Arguments_data_gen() :
         num_ims_(NUM_IMS_DEF),
@@ -26,7 +32,11 @@ Arguments_data_gen::Arguments_data_gen() :
         cam_fps_(CAM_FPS_DEF),
         dataset_idx_(DATASET_IDX_DEF),
         rng_seed_(RNG_SEED_DEF),
-        data_folder_(DATA_FOLDER_DEF)
+        data_folder_(DATA_FOLDER_DEF),
+        num_datasets_(NUM_DATASETS_DEF),
+        num_threads_(Arguments_aggregator::NUM_THREADS_DEF),
+        binary_(BINARY_DEF),
+        image_format_(Arguments_aggregator::IMAGE_FORMAT_DEF)
 {}
 
 Arguments_data_gen::Arguments_data_gen(int argc, const char * const * const argv) :
@@ -67,6 +77,23 @@ void Arguments_data_gen::parse(int argc, const char * const * const argv)
         {
             data_folder_ = argv[i + 1];
         }
+        else if(NUM_DATASETS_OPTION[0] == argv[i] || NUM_DATASETS_OPTION[1] == argv[i])
+        {
+            num_datasets_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_aggregator::NUM_THREADS_OPT[0] == argv[i] || Arguments_aggregator::NUM_THREADS_OPT[1] == argv[i])
+        {
+            num_threads_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(BINARY_OPTION[0] == argv[i] || BINARY_OPTION[1] == argv[i])
+        {
+            binary_ = true;
+            continue;
+        }
+        else if(Arguments_aggregator::IMAGE_FORMAT_OPT[0] == argv[i] || Arguments_aggregator::IMAGE_FORMAT_OPT[1] == argv[i])
+        {
+            image_format_ = Arguments_aggregator::parse_image_format(argv[i + 1]);
+        }
         else
         {
             continue;
@@ -81,6 +108,8 @@ const std::vector<std::string> Arguments_inference_mh::CHAIN_IDX_OPTION = { "-c"
 const std::vector<std::string> Arguments_inference_mh::CHAIN_LEN_OPTION = {"-l", "--length"};
 const std::vector<std::string> Arguments_inference_mh::SAMPLE_VELOCITY_OPT = {"-V", "--sample-velocities"};
 const std::vector<std::string> Arguments_inference_mh::CONSTRAIN_ANG_VEL_OPT = {"-C", "--constrain-angular-velocities"};
+const std::vector<std::string> Arguments_inference_mh::RESUME_OPT = {"-r", "--resume"};
+const std::vector<std::string> Arguments_inference_mh::LEAST_SQUARES_INIT_OPT = {"-L", "--least-squares-init"};
 const double Arguments_inference_mh::STDS_MULTIPLIER_DEF = 1.5;
 const unsigned Arguments_inference_mh::STDS_EXP_DEF = 0;
 const unsigned Arguments_inference_mh::CHAIN_IDX_DEF = 0;
@@ -88,6 +117,8 @@ const unsigned Arguments_inference_mh::CHAIN_LEN_DEF = 1000000;
 // default is dumb mode
 const bool Arguments_inference_mh::SAMPLE_VELOCITY_DEF = false;
 const bool Arguments_inference_mh::CONSTRAIN_ANG_VEL_DEF = false;
+const bool Arguments_inference_mh::RESUME_DEF = false;
+const bool Arguments_inference_mh::LEAST_SQUARES_INIT_DEF = false;
 
 Arguments_inference_mh::Arguments_inference_mh() :
     dataset_idx_(Arguments_data_gen::DATASET_IDX_DEF),
@@ -98,8 +129,11 @@ Arguments_inference_mh::Arguments_inference_mh() :
     rng_seed_(Arguments_data_gen::RNG_SEED_DEF),
     data_folder_(Arguments_data_gen::DATA_FOLDER_DEF),
     data_archive_ver_(Arguments_aggregator::DATA_ARCHIVE_VER_DEF),
+    inference_archive_ver_(Arguments_aggregator::INFERENCE_ARCHIVE_VER_DEF),
     sample_velocity_(SAMPLE_VELOCITY_DEF),
-    constrain_ang_vel_(CONSTRAIN_ANG_VEL_DEF)
+    constrain_ang_vel_(CONSTRAIN_ANG_VEL_DEF),
+    resume_(RESUME_DEF),
+    least_squares_init_(LEAST_SQUARES_INIT_DEF)
 {}
 
 Arguments_inference_mh::Arguments_inference_mh(int argc, const char * const * const argv) :
@@ -144,6 +178,10 @@ void Arguments_inference_mh::parse(int argc, const char * const * const argv)
         {
             data_archive_ver_ = unsigned(std::stoul(argv[i + 1]));
         }
+        else if(Arguments_aggregator::INFERENCE_ARCHIVE_VER_OPT[1] == argv[i])
+        {
+            inference_archive_ver_ = unsigned(std::stoul(argv[i + 1]));
+        }
         else if(SAMPLE_VELOCITY_OPT[0] == argv[i] || SAMPLE_VELOCITY_OPT[1] == argv[i])
         {
             sample_velocity_ = true;
@@ -154,6 +192,100 @@ void Arguments_inference_mh::parse(int argc, const char * const * const argv)
             constrain_ang_vel_ = true;
             continue;
         }
+        else if(RESUME_OPT[0] == argv[i] || RESUME_OPT[1] == argv[i])
+        {
+            resume_ = true;
+            continue;
+        }
+        else if(LEAST_SQUARES_INIT_OPT[0] == argv[i] || LEAST_SQUARES_INIT_OPT[1] == argv[i])
+        {
+            least_squares_init_ = true;
+            continue;
+        }
+        else
+        {
+            continue;
+        }
+        i++;
+    }
+}
+
+const std::vector<std::string> Arguments_inference_smc::NUM_PARTICLES_OPT = {"-n", "--num-particles"};
+const std::vector<std::string> Arguments_inference_smc::NUM_MOVES_OPT = {"-k", "--moves"};
+const std::vector<std::string> Arguments_inference_smc::ESS_THRESHOLD_OPT = {"-t", "--ess-threshold"};
+const std::vector<std::string> Arguments_inference_smc::RESUME_OPT = {"-r", "--resume"};
+const std::vector<std::string> Arguments_inference_smc::STREAM_OPT = {"-S", "--stream"};
+const unsigned Arguments_inference_smc::NUM_PARTICLES_DEF = 1024;
+const unsigned Arguments_inference_smc::NUM_MOVES_DEF = 10;
+const double Arguments_inference_smc::ESS_THRESHOLD_DEF = 0.5;
+const bool Arguments_inference_smc::RESUME_DEF = false;
+const bool Arguments_inference_smc::STREAM_DEF = false;
+
+Arguments_inference_smc::Arguments_inference_smc() :
+    dataset_idx_(Arguments_data_gen::DATASET_IDX_DEF),
+    rng_seed_(Arguments_data_gen::RNG_SEED_DEF),
+    data_folder_(Arguments_data_gen::DATA_FOLDER_DEF),
+    data_archive_ver_(Arguments_aggregator::DATA_ARCHIVE_VER_DEF),
+    num_threads_(Arguments_aggregator::NUM_THREADS_DEF),
+    num_particles_(NUM_PARTICLES_DEF),
+    num_moves_(NUM_MOVES_DEF),
+    ess_threshold_(ESS_THRESHOLD_DEF),
+    resume_(RESUME_DEF),
+    stream_(STREAM_DEF)
+{}
+
+Arguments_inference_smc::Arguments_inference_smc(int argc, const char * const * const argv) :
+        Arguments_inference_smc()
+{
+    parse(argc, argv);
+}
+
+void Arguments_inference_smc::parse(int argc, const char * const * const argv)
+{
+    for(int i = 0; i < argc; i++)
+    {
+        if(Arguments_data_gen::DATASET_IDX_OPTION[0] == argv[i] || Arguments_data_gen::DATASET_IDX_OPTION[1] == argv[i])
+        {
+            dataset_idx_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_data_gen::RNG_SEED_OPTION[0] == argv[i] || Arguments_data_gen::RNG_SEED_OPTION[1] == argv[i])
+        {
+            rng_seed_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_data_gen::DATA_FOLDER_OPTION[0] == argv[i] || Arguments_data_gen::DATA_FOLDER_OPTION[1] == argv[i])
+        {
+            data_folder_ = argv[i + 1];
+        }
+        else if(Arguments_aggregator::DATA_ARCHIVE_VER_OPT[0] == argv[i] || Arguments_aggregator::DATA_ARCHIVE_VER_OPT[1] == argv[i])
+        {
+            data_archive_ver_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_aggregator::NUM_THREADS_OPT[0] == argv[i] || Arguments_aggregator::NUM_THREADS_OPT[1] == argv[i])
+        {
+            num_threads_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_PARTICLES_OPT[0] == argv[i] || NUM_PARTICLES_OPT[1] == argv[i])
+        {
+            num_particles_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_MOVES_OPT[0] == argv[i] || NUM_MOVES_OPT[1] == argv[i])
+        {
+            num_moves_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(ESS_THRESHOLD_OPT[0] == argv[i] || ESS_THRESHOLD_OPT[1] == argv[i])
+        {
+            ess_threshold_ = std::stod(argv[i + 1]);
+        }
+        else if(RESUME_OPT[0] == argv[i] || RESUME_OPT[1] == argv[i])
+        {
+            resume_ = true;
+            continue;
+        }
+        else if(STREAM_OPT[0] == argv[i] || STREAM_OPT[1] == argv[i])
+        {
+            stream_ = true;
+            continue;
+        }
         else
         {
             continue;
@@ -176,6 +308,8 @@ const std::vector<std::string> Arguments_aggregator::GROUND_TRUTH_FOLDER_OPT = {
 const std::vector<std::string> Arguments_aggregator::OUTPUT_FOLDER_OPT {"-o", "--output-folder"};
 const std::vector<std::string> Arguments_aggregator::DATA_ARCHIVE_VER_OPT = {"-v", "--data-archive-version"};
 const std::vector<std::string> Arguments_aggregator::INFERENCE_ARCHIVE_VER_OPT = {"-r", "--inference-archive-version"};
+const std::vector<std::string> Arguments_aggregator::NUM_THREADS_OPT = {"-j", "--threads"};
+const std::vector<std::string> Arguments_aggregator::IMAGE_FORMAT_OPT = {"-t", "--image-format"};
 
 const std::string Arguments_aggregator::OUTPUT_FOLDER_DEF;
 const Arguments_aggregator::Possible_aggregation Arguments_aggregator::DATASET_DEF(
@@ -186,7 +320,9 @@ const Arguments_aggregator::Possible_aggregation Arguments_aggregator::CHAIN_DEF
         Arguments_inference_mh::CHAIN_IDX_DEF);
 const Arguments_aggregator::Possible_aggregation Arguments_aggregator::CHAIN_SAMPLE_DEF(0);
 const unsigned Arguments_aggregator::DATA_ARCHIVE_VER_DEF = 20191031;
-const unsigned Arguments_aggregator::INFERENCE_ARCHIVE_VER_DEF = 20191031;
+const unsigned Arguments_aggregator::INFERENCE_ARCHIVE_VER_DEF = 20261019;
+const unsigned Arguments_aggregator::NUM_THREADS_DEF = 0;
+const util::Image_format Arguments_aggregator::IMAGE_FORMAT_DEF = util::IF_TIFF;
 
 Arguments_aggregator::Arguments_aggregator() :
         in_folder_(Arguments_data_gen::DATA_FOLDER_DEF),
@@ -196,7 +332,9 @@ Arguments_aggregator::Arguments_aggregator() :
         chain_(CHAIN_DEF),
         chain_sample_(CHAIN_SAMPLE_DEF),
         data_archive_ver_(DATA_ARCHIVE_VER_DEF),
-        inference_archive_ver_(INFERENCE_ARCHIVE_VER_DEF)
+        inference_archive_ver_(INFERENCE_ARCHIVE_VER_DEF),
+        num_threads_(NUM_THREADS_DEF),
+        image_format_(IMAGE_FORMAT_DEF)
 {}
 
 Arguments_aggregator::Arguments_aggregator(int argc, const char * const * const argv):
@@ -228,7 +366,7 @@ void Arguments_aggregator::parse(int argc, const char * const * const argv)
             if(dataset_.aggregate_)
                 aggregation_ct++;
         }
-        else if(Arguments_inference_mh::STDS_EXP_OPTION[0] == argv[i] || Arguments_inference_mh::STDS_EXP_OPTION[0] == argv[i])
+        else if(Arguments_inference_mh::STDS_EXP_OPTION[0] == argv[i] || Arguments_inference_mh::STDS_EXP_OPTION[1] == argv[i])
         {
             exploration_rate_ = parse_idx_or_range(argc - i, argv + i + 1);
             if(exploration_rate_.aggregate_)
@@ -254,6 +392,14 @@ void Arguments_aggregator::parse(int argc, const char * const * const argv)
         {
             inference_archive_ver_ = unsigned(std::stoul(argv[i + 1]));
         }
+        else if(NUM_THREADS_OPT[0] == argv[i] || NUM_THREADS_OPT[1] == argv[i])
+        {
+            num_threads_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(IMAGE_FORMAT_OPT[0] == argv[i] || IMAGE_FORMAT_OPT[1] == argv[i])
+        {
+            image_format_ = parse_image_format(argv[i + 1]);
+        }
         else
         {
             continue;
@@ -263,6 +409,15 @@ void Arguments_aggregator::parse(int argc, const char * const * const argv)
     if(aggregation_ct > 1) throw Aggregation_exception(); //util::err_str(__FILE__, __LINE__);
 }
 
+util::Image_format Arguments_aggregator::parse_image_format(const std::string &s)
+{
+    for(unsigned i = 0; i < util::IF_COUNT; i++)
+    {
+        if(util::IMAGE_FORMAT_STRS[i] == s) return util::Image_format(i);
+    }
+    throw Image_format_exception(); //util::err_str(__FILE__, __LINE__);
+}
+
 // Figures out whether the current option is empty or not (basically, if it
 // starts with ';' or it's EOF, it's empty). Then, parses the value and consumes it
 // from the string.
@@ -324,6 +479,108 @@ Arguments_aggregator::Possible_aggregation Arguments_aggregator::parse_idx_or_ra
     }
 }
 
+const std::vector<std::string> Arguments_experiment::CONFIG_FILE_OPT = {"-x", "--config"};
+const std::string Arguments_experiment::NUM_EXPONENTS_KEY = "num-exponents";
+const std::string Arguments_experiment::EXPONENT_STRIDE_KEY = "exponent-stride";
+const std::string Arguments_experiment::NUM_CHAINS_KEY = "num-chains";
+const unsigned Arguments_experiment::NUM_EXPONENTS_DEF = 1;
+const unsigned Arguments_experiment::EXPONENT_STRIDE_DEF = 1;
+const unsigned Arguments_experiment::NUM_CHAINS_DEF = 1;
+
+Arguments_experiment::Arguments_experiment() :
+        data_folder_(Arguments_data_gen::DATA_FOLDER_DEF),
+        rng_seed_(Arguments_data_gen::RNG_SEED_DEF),
+        num_threads_(Arguments_aggregator::NUM_THREADS_DEF),
+        num_datasets_(1),
+        num_ims_(Arguments_data_gen::NUM_IMS_DEF),
+        im_w_(Arguments_data_gen::IM_W_DEF),
+        im_h_(Arguments_data_gen::IM_H_DEF),
+        cam_fps_(Arguments_data_gen::CAM_FPS_DEF),
+        binary_(Arguments_data_gen::BINARY_DEF),
+        stds_multiplier_(Arguments_inference_mh::STDS_MULTIPLIER_DEF),
+        starting_stds_exp_(Arguments_inference_mh::STDS_EXP_DEF),
+        num_stds_exps_(NUM_EXPONENTS_DEF),
+        stds_exp_stride_(EXPONENT_STRIDE_DEF),
+        num_chains_(NUM_CHAINS_DEF),
+        chain_len_(Arguments_inference_mh::CHAIN_LEN_DEF),
+        sample_velocity_(Arguments_inference_mh::SAMPLE_VELOCITY_DEF),
+        constrain_ang_vel_(Arguments_inference_mh::CONSTRAIN_ANG_VEL_DEF)
+{}
+
+Arguments_experiment::Arguments_experiment(int argc, const char * const * const argv) :
+        Arguments_experiment()
+{
+    parse(argc, argv);
+}
+
+void Arguments_experiment::parse(int argc, const char * const * const argv)
+{
+    // the file first, so that the command line wins
+    for(int i = 0; i < argc - 1; i++)
+    {
+        if(CONFIG_FILE_OPT[0] == argv[i] || CONFIG_FILE_OPT[1] == argv[i])
+        {
+            parse_config_file(argv[i + 1]);
+        }
+    }
+    for(int i = 0; i < argc; i++)
+    {
+        if(Arguments_data_gen::DATA_FOLDER_OPTION[0] == argv[i] || Arguments_data_gen::DATA_FOLDER_OPTION[1] == argv[i])
+        {
+            data_folder_ = argv[i + 1];
+        }
+        else if(Arguments_data_gen::RNG_SEED_OPTION[0] == argv[i] || Arguments_data_gen::RNG_SEED_OPTION[1] == argv[i])
+        {
+            rng_seed_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_aggregator::NUM_THREADS_OPT[0] == argv[i] || Arguments_aggregator::NUM_THREADS_OPT[1] == argv[i])
+        {
+            num_threads_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else
+        {
+            continue;
+        }
+        i++;
+    }
+}
+
+// "--num-ims" -> "num-ims"
+static const char *config_key(const std::vector<std::string> &opt)
+{
+    return opt[1].c_str() + 2;
+}
+
+void Arguments_experiment::parse_config_file(const std::string &path)
+{
+    namespace po = boost::program_options;
+    po::options_description desc;
+    desc.add_options()
+            (config_key(Arguments_data_gen::DATA_FOLDER_OPTION), po::value<std::string>(&data_folder_)->default_value(data_folder_))
+            (config_key(Arguments_data_gen::RNG_SEED_OPTION), po::value<unsigned>(&rng_seed_)->default_value(rng_seed_))
+            (config_key(Arguments_aggregator::NUM_THREADS_OPT), po::value<unsigned>(&num_threads_)->default_value(num_threads_))
+            (config_key(Arguments_data_gen::NUM_DATASETS_OPTION), po::value<unsigned>(&num_datasets_)->default_value(num_datasets_))
+            (config_key(Arguments_data_gen::NUM_IMS_OPTION), po::value<unsigned>(&num_ims_)->default_value(num_ims_))
+            (config_key(Arguments_data_gen::IM_W_OPTION), po::value<unsigned>(&im_w_)->default_value(im_w_))
+            (config_key(Arguments_data_gen::IM_H_OPTION), po::value<unsigned>(&im_h_)->default_value(im_h_))
+            (config_key(Arguments_data_gen::CAM_FPS_OPTION), po::value<double>(&cam_fps_)->default_value(cam_fps_))
+            (config_key(Arguments_data_gen::BINARY_OPTION), po::value<bool>(&binary_)->default_value(binary_))
+            (config_key(Arguments_inference_mh::STDS_MULTIPLIER_OPTION), po::value<double>(&stds_multiplier_)->default_value(stds_multiplier_))
+            (config_key(Arguments_inference_mh::STDS_EXP_OPTION), po::value<unsigned>(&starting_stds_exp_)->default_value(starting_stds_exp_))
+            (NUM_EXPONENTS_KEY.c_str(), po::value<unsigned>(&num_stds_exps_)->default_value(num_stds_exps_))
+            (EXPONENT_STRIDE_KEY.c_str(), po::value<unsigned>(&stds_exp_stride_)->default_value(stds_exp_stride_))
+            (NUM_CHAINS_KEY.c_str(), po::value<unsigned>(&num_chains_)->default_value(num_chains_))
+            (config_key(Arguments_inference_mh::CHAIN_LEN_OPTION), po::value<unsigned>(&chain_len_)->default_value(chain_len_))
+            (config_key(Arguments_inference_mh::SAMPLE_VELOCITY_OPT), po::value<bool>(&sample_velocity_)->default_value(sample_velocity_))
+            (config_key(Arguments_inference_mh::CONSTRAIN_ANG_VEL_OPT), po::value<bool>(&constrain_ang_vel_)->default_value(constrain_ang_vel_));
+
+    std::ifstream f(path);
+    if(!f) throw Config_file_exception(); //util::err_str(__FILE__, __LINE__);
+    po::variables_map vm;
+    po::store(po::parse_config_file(f, desc), vm);
+    po::notify(vm);
+}
+
 Arguments_image_combiner::Arguments_image_combiner() :
         in_folder_(Arguments_data_gen::DATA_FOLDER_DEF),
         dataset_idx_(Arguments_data_gen::DATASET_IDX_DEF),
@@ -334,7 +591,10 @@ Arguments_image_combiner::Arguments_image_combiner() :
         chain_idx_(Arguments_inference_mh::CHAIN_IDX_DEF),
         chain_sample_idx_(Arguments_inference_mh::CHAIN_LEN_DEF),
         inference_polygons_color_(COLOR_INFERENCE_POLYGONS),
-        inference_centers_of_mass_color_(COLOR_INFERENCE_CENTERS_OF_MASS)
+        inference_centers_of_mass_color_(COLOR_INFERENCE_CENTERS_OF_MASS),
+        inference_archive_ver_(Arguments_aggregator::INFERENCE_ARCHIVE_VER_DEF),
+        num_threads_(Arguments_aggregator::NUM_THREADS_DEF),
+        image_format_(Arguments_aggregator::IMAGE_FORMAT_DEF)
 {}
 
 Arguments_image_combiner::Arguments_image_combiner(int argc, const char * const * const argv):
@@ -368,6 +628,18 @@ void Arguments_image_combiner::parse(int argc, const char *const *const argv)
         {
             chain_sample_idx_ = unsigned(std::stoul(argv[i + 1]));
         }
+        else if(Arguments_aggregator::INFERENCE_ARCHIVE_VER_OPT[0] == argv[i] || Arguments_aggregator::INFERENCE_ARCHIVE_VER_OPT[1] == argv[i])
+        {
+            inference_archive_ver_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_aggregator::NUM_THREADS_OPT[0] == argv[i] || Arguments_aggregator::NUM_THREADS_OPT[1] == argv[i])
+        {
+            num_threads_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(Arguments_aggregator::IMAGE_FORMAT_OPT[0] == argv[i] || Arguments_aggregator::IMAGE_FORMAT_OPT[1] == argv[i])
+        {
+            image_format_ = Arguments_aggregator::parse_image_format(argv[i + 1]);
+        }
         else
         {
             continue;
@@ -393,4 +665,5 @@ std::istringstream &operator>>(std::istringstream &ss, fracture::cfg::Arguments_
             break;
         }
     }
+    return ss;
 }
@@ -22,6 +22,8 @@ public:
     static const std::vector<std::string> DATASET_IDX_OPTION;
     static const std::vector<std::string> RNG_SEED_OPTION;
     static const std::vector<std::string> DATA_FOLDER_OPTION;
+    static const std::vector<std::string> NUM_DATASETS_OPTION;
+    static const std::vector<std::string> BINARY_OPTION;
 
     static const unsigned NUM_IMS_DEF;
     static const unsigned IM_W_DEF;
@@ -30,6 +32,8 @@ public:
     static const unsigned DATASET_IDX_DEF;
     static const unsigned RNG_SEED_DEF;
     static const std::string DATA_FOLDER_DEF;
+    static const unsigned NUM_DATASETS_DEF;
+    static const bool BINARY_DEF;
 
     Arguments_data_gen();
     Arguments_data_gen(int argc, const char * const * const argv);
@@ -43,6 +47,17 @@ public:
     unsigned dataset_idx_;
     unsigned rng_seed_;
     std::string data_folder_;
+
+    // 0 generates dataset_idx_ only, seeded with rng_seed_. Otherwise,
+    // generates datasets dataset_idx_ through dataset_idx_ + num_datasets_ - 1
+    // on num_threads_ threads, each seeded with prob::derive_seed(rng_seed_,
+    // its index), as driver_experiment does.
+    unsigned num_datasets_;
+    unsigned num_threads_;
+    // whether to write binary rather than text archives (see save_data_record)
+    bool binary_;
+    // how driver_data_image_gen writes the frames
+    util::Image_format image_format_;
 };
 
 class Arguments_inference_mh
@@ -54,6 +69,8 @@ public:
     static const std::vector<std::string> CHAIN_LEN_OPTION;
     static const std::vector<std::string> SAMPLE_VELOCITY_OPT;
     static const std::vector<std::string> CONSTRAIN_ANG_VEL_OPT;
+    static const std::vector<std::string> RESUME_OPT;
+    static const std::vector<std::string> LEAST_SQUARES_INIT_OPT;
 
     static const double STDS_MULTIPLIER_DEF;
     static const unsigned STDS_EXP_DEF;
@@ -61,6 +78,8 @@ public:
     static const unsigned CHAIN_LEN_DEF;
     static const bool SAMPLE_VELOCITY_DEF;
     static const bool CONSTRAIN_ANG_VEL_DEF;
+    static const bool RESUME_DEF;
+    static const bool LEAST_SQUARES_INIT_DEF;
 
     Arguments_inference_mh();
     Arguments_inference_mh(int argc, const char * const * const argv);
@@ -75,6 +94,9 @@ public:
     unsigned rng_seed_;
     std::string data_folder_;
     unsigned data_archive_ver_;
+    // the version of the chain resumed from. Only the long option is taken,
+    // since -r is --resume here.
+    unsigned inference_archive_ver_;
 
     // whether to sample velocity (true) or momentum (false) for the new proposals
     // (decouples momentum and block volume)
@@ -83,12 +105,64 @@ public:
     // whether to reject new samples with angular velocities > 2 * pi. Removes such
     // local minima from the search space.
     bool constrain_ang_vel_;
+
+    // whether to start the chain from the last sample of the chain saved
+    // under the same arguments, extended over the frames the data has gained
+    // since, rather than from a forward sample.
+    bool resume_;
+
+    // whether to start the chain from a least squares fit to the observed
+    // polygons (see get_least_squares_initial_sample) rather than from a
+    // forward sample. Ignored when resuming.
+    bool least_squares_init_;
+};
+
+class Arguments_inference_smc
+{
+public:
+    static const std::vector<std::string> NUM_PARTICLES_OPT;
+    static const std::vector<std::string> NUM_MOVES_OPT;
+    static const std::vector<std::string> ESS_THRESHOLD_OPT;
+    static const std::vector<std::string> RESUME_OPT;
+    static const std::vector<std::string> STREAM_OPT;
+
+    static const unsigned NUM_PARTICLES_DEF;
+    static const unsigned NUM_MOVES_DEF;
+    static const double ESS_THRESHOLD_DEF;
+    static const bool RESUME_DEF;
+    static const bool STREAM_DEF;
+
+    Arguments_inference_smc();
+    Arguments_inference_smc(int argc, const char * const * const argv);
+
+    void parse(int argc, const char * const * const argv);
+
+    unsigned dataset_idx_;
+    unsigned rng_seed_;
+    std::string data_folder_;
+    unsigned data_archive_ver_;
+    unsigned num_threads_;
+
+    unsigned num_particles_;
+    // MH moves per particle after each resample
+    unsigned num_moves_;
+    // resample when the effective sample size drops below this fraction of
+    // the number of particles
+    double ess_threshold_;
+
+    // whether to pick up the population saved under the same arguments and
+    // only assimilate the frames the data has gained since
+    bool resume_;
+    // whether to take in the frames one at a time, as if they arrived that
+    // way, and report the latency of each
+    bool stream_;
 };
 
 class Arguments_aggregator
 {
 public:
     class Aggregation_exception : std::exception {};
+    class Image_format_exception : std::exception {};
     enum Aggregation_type
     {
         AT_MAX,
@@ -158,6 +232,25 @@ public:
             data_.aggregation_range_.bin_size_ = bin_size;
         }
 
+        // The single index, or every index of the range (stop inclusive).
+        std::vector<unsigned> get_indices() const
+        {
+            std::vector<unsigned> r;
+            if(!aggregate_)
+            {
+                r.push_back(data_.no_aggregation_idx_);
+                return r;
+            }
+            for(
+                    unsigned idx = data_.aggregation_range_.start_idx_;
+                    idx <= data_.aggregation_range_.stop_idx_;
+                    idx += data_.aggregation_range_.stride_)
+            {
+                r.push_back(idx);
+            }
+            return r;
+        }
+
         bool aggregate_;
         union
         {
@@ -178,7 +271,9 @@ public:
     // TODO this should be moved to its own separate arguments class
     static const std::vector<std::string> DATA_ARCHIVE_VER_OPT;
     static const std::vector<std::string> INFERENCE_ARCHIVE_VER_OPT;
-
+    static const std::vector<std::string> NUM_THREADS_OPT;
+    // one of util::IMAGE_FORMAT_STRS
+    static const std::vector<std::string> IMAGE_FORMAT_OPT;
 
 
     // TODO ADD OPTIONS FOR THESE
@@ -189,6 +284,9 @@ public:
     static const Possible_aggregation CHAIN_SAMPLE_DEF;
     static const unsigned DATA_ARCHIVE_VER_DEF;
     static const unsigned INFERENCE_ARCHIVE_VER_DEF;
+    // 0 means one thread per hardware thread
+    static const unsigned NUM_THREADS_DEF;
+    static const util::Image_format IMAGE_FORMAT_DEF;
 
     Arguments_aggregator();
     Arguments_aggregator(int argc, const char * const * const argv);
@@ -204,11 +302,69 @@ public:
     Possible_aggregation chain_sample_;
     unsigned data_archive_ver_;
     unsigned inference_archive_ver_;
+    unsigned num_threads_;
+    util::Image_format image_format_;
+
+    static util::Image_format parse_image_format(const std::string &s);
 
 private:
     static Possible_aggregation parse_idx_or_range(int argc, const char * const * const argv);
 };
 
+// The grid of a whole experiment, for driver_experiment. It's read from a
+// config file of "key = value" lines (see scripts/experiment.cfg).
+//
+// A key is the long option of the per-stage driver that takes the same
+// value, or one of the *_KEY grid sizes below. The number of datasets is
+// driver_data_gen's. There are NUM_EXPONENTS_KEY exploration rates, from
+// the "exponent" key up in steps of EXPONENT_STRIDE_KEY.
+//
+// Keys left out keep their defaults, and -d, -s and -j on the command line
+// override the file.
+class Arguments_experiment
+{
+public:
+    class Config_file_exception : std::exception {};
+
+    static const std::vector<std::string> CONFIG_FILE_OPT;
+
+    static const std::string NUM_EXPONENTS_KEY;
+    static const std::string EXPONENT_STRIDE_KEY;
+    static const std::string NUM_CHAINS_KEY;
+
+    static const unsigned NUM_EXPONENTS_DEF;
+    static const unsigned EXPONENT_STRIDE_DEF;
+    static const unsigned NUM_CHAINS_DEF;
+
+    Arguments_experiment();
+    Arguments_experiment(int argc, const char * const * const argv);
+
+    void parse(int argc, const char * const * const argv);
+    void parse_config_file(const std::string &path);
+
+    std::string data_folder_;
+    unsigned rng_seed_;
+    unsigned num_threads_;
+
+    // generation
+    unsigned num_datasets_;
+    unsigned num_ims_;
+    unsigned im_w_;
+    unsigned im_h_;
+    double cam_fps_;
+    bool binary_;
+
+    // MH inference
+    double stds_multiplier_;
+    unsigned starting_stds_exp_;
+    unsigned num_stds_exps_;
+    unsigned stds_exp_stride_;
+    unsigned num_chains_;
+    unsigned chain_len_;
+    bool sample_velocity_;
+    bool constrain_ang_vel_;
+};
+
 class Arguments_image_combiner
 {
 public:
@@ -228,10 +384,16 @@ public:
 
     unsigned exploration_rate_;
     unsigned chain_idx_;
+    // the sample shown is clamped to the chain's last iteration, which is
+    // what the default picks, but the output folder is named by this
     unsigned chain_sample_idx_;
 
     kjb::Image::Pixel_type inference_polygons_color_;
     kjb::Image::Pixel_type inference_centers_of_mass_color_;
+
+    unsigned inference_archive_ver_;
+    unsigned num_threads_;
+    util::Image_format image_format_;
 };
 
 const kjb::Image::Pixel_type COLOR_GROUND_TRUTH_POLYGONS =
@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "csv_writer.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+const size_t Csv_writer::BUFFER_SIZE_DEF = size_t(1) << 20;
+
+Csv_writer::Csv_writer(
+        const boost::filesystem::path &p,
+        const std::vector<std::string> &columns,
+        size_t buffer_size) :
+        f_(p.string(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary),
+        buf_(std::max<size_t>(buffer_size, 64)),
+        used_(0),
+        num_columns_(columns.size()),
+        num_cells_(0)
+{
+    if(!f_) throw Open_exception(); //util::err_str(__FILE__, __LINE__);
+    for(const std::string &c : columns)
+    {
+        write(c);
+    }
+    end_row();
+}
+
+Csv_writer::~Csv_writer()
+{
+    flush();
+}
+
+size_t Csv_writer::format_double(double v, char *out)
+{
+    // the shortest of the precisions that can round trip
+    int n = 0;
+    for(int precision = 15; precision <= 17; precision++)
+    {
+        n = std::snprintf(out, 32, "%.*g", precision, v);
+        if(precision == 17 || std::strtod(out, nullptr) == v) break;
+    }
+    return size_t(n);
+}
+
+char *Csv_writer::begin_cell(size_t len)
+{
+    if(num_cells_ == num_columns_) throw Row_size_exception(); //util::err_str(__FILE__, __LINE__);
+    // separator, quotes and the end of the row
+    size_t needed = len + 4;
+    if(used_ + needed > buf_.size())
+    {
+        flush();
+        if(needed > buf_.size()) buf_.resize(needed);
+    }
+    char *p = buf_.data() + used_;
+    if(num_cells_) *p++ = ',';
+    *p++ = '"';
+    return p;
+}
+
+void Csv_writer::end_cell(char *end)
+{
+    *end++ = '"';
+    used_ = size_t(end - buf_.data());
+    num_cells_++;
+}
+
+void Csv_writer::write(double v)
+{
+    char *p = begin_cell(32);
+    end_cell(p + format_double(v, p));
+}
+
+void Csv_writer::write(const std::string &v)
+{
+    // quotes are escaped by doubling them
+    char *p = begin_cell(2 * v.size());
+    for(char c : v)
+    {
+        if(c == '"') *p++ = '"';
+        *p++ = c;
+    }
+    end_cell(p);
+}
+
+void Csv_writer::write_integer(bool negative, unsigned long long magnitude)
+{
+    char digits[20];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while(magnitude);
+    char *p = begin_cell(n + 1);
+    if(negative) *p++ = '-';
+    while(n) *p++ = digits[--n];
+    end_cell(p);
+}
+
+void Csv_writer::end_row()
+{
+    if(num_cells_ != num_columns_) throw Row_size_exception(); //util::err_str(__FILE__, __LINE__);
+    // begin_cell left room for it, unless there are no columns
+    if(used_ == buf_.size()) flush();
+    buf_[used_++] = '\n';
+    num_cells_ = 0;
+}
+
+void Csv_writer::flush()
+{
+    f_.write(buf_.data(), std::streamsize(used_));
+    f_.flush();
+    used_ = 0;
+}
+
+}
+}
@@ -0,0 +1,78 @@
+#ifndef CSV_WRITER_HPP
+#define CSV_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <type_traits>
+
+#include <boost/filesystem/path.hpp>
+
+namespace fracture
+{
+namespace util
+{
+
+// Writes a CSV file with a fixed set of columns, every cell quoted. The
+// header is written on construction, and every row must have exactly one
+// cell per column. Rows are formatted into a large buffer that is written
+// out in one go when it fills, instead of cell by cell. Doubles are written
+// with the fewest of 15, 16 or 17 significant digits that reads back as the
+// same double, so no precision is lost, though it isn't always the shortest
+// such form.
+class Csv_writer
+{
+public:
+    class Open_exception : std::exception {};
+    class Row_size_exception : std::exception {};
+
+    static const size_t BUFFER_SIZE_DEF;
+
+    Csv_writer(
+            const boost::filesystem::path &p,
+            const std::vector<std::string> &columns,
+            size_t buffer_size = BUFFER_SIZE_DEF);
+    // flushes
+    ~Csv_writer();
+
+    void write(double v);
+    void write(const std::string &v);
+    void write(const char *v) { write(std::string(v)); }
+    // bools are written as 0 or 1
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type write(T v)
+    {
+        if(std::is_signed<T>::value && v < T(0)) write_integer(true, 0ULL - (unsigned long long)(v));
+        else write_integer(false, (unsigned long long)(v));
+    }
+    // an empty cell
+    void skip() { write(std::string()); }
+
+    void end_row();
+    // Writes out the buffer. Only needed to read the file while it's open.
+    void flush();
+
+    size_t get_num_columns() const { return num_columns_; }
+
+    // The shortest decimal form of v that reads back as v. out must hold
+    // at least 32 chars. Returns the number of chars written (no '\0').
+    static size_t format_double(double v, char *out);
+
+private:
+    void write_integer(bool negative, unsigned long long magnitude);
+    // Starts a cell: the separator and opening quote, and room for at
+    // least len more chars.
+    char *begin_cell(size_t len);
+    void end_cell(char *end);
+
+    std::ofstream f_;
+    std::vector<char> buf_;
+    size_t used_;
+    size_t num_columns_;
+    size_t num_cells_;
+};
+
+}
+}
+
+#endif // CSV_WRITER_HPP
@@ -1,10 +1,15 @@
 #include <vector>
-#include <thread>
+#include <string>
+#include <sstream>
 
-#include <boost/archive/text_iarchive.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include "config.hpp"
 #include "sample.hpp"
+#include "chain_index.hpp"
+#include "aggregation.hpp"
+#include "thread_pool.hpp"
+#include "csv_writer.hpp"
 
 /**
  *  The idea behind this driver is that we essentially have a multidimensional array of data,
@@ -14,6 +19,16 @@
  *  a method of aggregation, and be able to collapse that dimension down. We want to collapse
  *  the dimensions down, one at a time, using as much parallel processing as possible
  *  to ensure that the this is done in a reasonable amount of time.
+ *
+ *  Aggregation is done over the metrics of the samples (their log probability and
+ *  latents, see Chain_index_entry), not the samples themselves. Exactly one of -i, -e,
+ *  -c or -l may be a range. The bins are written one per row to
+ *  <dataset>_<exploration rate>_<chain>_<iteration>_aggregate.csv in the output
+ *  folder (the data folder by default), a range being written as <start>-<stop>.
+ *
+ *  Over iterations (-l), the chain's entries are streamed into the bins, so memory
+ *  doesn't grow with the chain's length. Over datasets, exploration rates or chains,
+ *  each of the chains is read concurrently for its value at the -l iteration.
  */
 
 namespace fracture
@@ -23,271 +38,145 @@ namespace block_2d
 namespace driver_aggregator
 {
 
-// TODO figure out a better way to do this. Aggregation only makes sense over a metric.
-// It makes less sense over samples. What's an average sample? Does it average all rvs?
-
-//// assumes that same-pointers can only occur in series.
-//// duplicate pointers basically comes from the Metropolis-Hastings rejections.
-//void free_chain_samples(std::vector<Sample *> & chain)
-//{
-//    Sample *prev = nullptr;
-//    for(Sample *cur : chain)
-//    {
-//        if(cur != prev)
-//        {
-//            prev = cur;
-//            delete cur;
-//        }
-//    }
-//}
-
-//// If the at is AT_MEAN, the caller is responsible for properly freeing the memory.
-//Sample *aggregate_bin(
-//        const std::vector<Sample *> &chain,
-//        const cfg::Arguments_aggregator::Aggregation_type &at,
-//        unsigned start,
-//        unsigned guard,
-//        unsigned stride)
-//{
-//    switch(at)
-//    {
-//    case cfg::Arguments_aggregator::AT_FIRST:
-//        return chain[start];
-//    case cfg::Arguments_aggregator::AT_MEDIAN:
-//        return chain[(start + guard) / 2];
-//    case cfg::Arguments_aggregator::AT_LAST:
-//        return chain[guard - 1];
-//    }
-//    Sample *r = nullptr;
-//    double r_log_prob;
-//    for(unsigned cur_elem = start; cur_elem < guard; cur_elem += stride)
-//    {
-//        Sample *cur = chain[cur_elem];
-//        double considered_log_prob;
-//        if(cur_elem == start)
-//        {
-//            switch(at)
-//            {
-//            case cfg::Arguments_aggregator::AT_MAX:
-//            case cfg::Arguments_aggregator::AT_MIN:
-//                r = cur;
-//                break;
-//            case cfg::Arguments_aggregator::AT_MEAN:
-//                // In case we attempt to add values, but subsequent samples
-//                // in the input vector also point to the same value.
-//                // Would mess up results.
-//                r = new Sample(*cur);
-//                break;
-//            }
-//            r_log_prob = r->log_prob();
-//        }
-//        else
-//        {
-//            switch(at)
-//            {
-//            case cfg::Arguments_aggregator::AT_MAX:
-//                considered_log_prob = cur->log_prob();
-//                if(considered_log_prob > r_log_prob)
-//                {
-//                    r = cur;
-//                    r_log_prob = considered_log_prob;
-//                }
-//                break;
-//            case cfg::Arguments_aggregator::AT_MIN:
-//                considered_log_prob = cur->log_prob();
-//                if(considered_log_prob < r_log_prob)
-//                {
-//                    r = cur;
-//                    r_log_prob = considered_log_prob;
-//                }
-//                break;
-//            case cfg::Arguments_aggregator::AT_MEAN:
-//                r->add_rvs(*cur);
-//                break;
-//            default:
-//                throw util::Unhandled_enum_value_exception(); //util::err_str(__FILE__, __LINE__);
-//            }
-//        }
-//    }
-//    if(at == cfg::Arguments_aggregator::AT_MEAN)
-//        r->div_rvs(guard - start);
-//}
-
-//void aggregate_vector(
-//        const std::vector<Sample *> &in,
-//        const cfg::Arguments_aggregator::Possible_aggregation &aggregation_options,
-//        std::vector<Sample *> &out)
-//{
-//    assert(aggregation_options.aggregate_);
-//    unsigned num_elems = (aggregation_options.data_.aggregation_range_.stop_idx_ + 1 - aggregation_options.data_.aggregation_range_.start_idx_)
-//            / aggregation_options.data_.aggregation_range_.stride_;
-//    unsigned num_bins = unsigned(std::ceil(num_elems
-//            / double(aggregation_options.data_.aggregation_range_.bin_size_)));
-//    out.reserve(num_bins);
-//    for(unsigned cur_bin = 0; cur_bin < num_bins; cur_bin++)
-//    {
-//        unsigned start = cur_bin * aggregation_options.data_.aggregation_range_.bin_size_;
-//        unsigned guard = std::min((cur_bin + 1) * aggregation_options.data_.aggregation_range_.bin_size_, num_elems);
-//        out.push_back(aggregate_bin(
-//                in,
-//                aggregation_options.data_.aggregation_range_.type_,
-//                start,
-//                guard,
-//                aggregation_options.data_.aggregation_range_.stride_));
-//    }
-//}
-
-//// Each inner vector represents a single MCMC chain.
-//// Our goal is to aggregate along the other dimension (along the outer vector).
-//// precondition: all inner vectors have the same size.
-//void aggregate_vector_of_vectors(
-//        const std::vector<std::vector<Sample *>> &in,
-//        const cfg::Arguments_aggregator::Possible_aggregation &aggregation_options,
-//        std::vector<Sample *> &out)
-//{
-//    assert(aggregation_options.aggregate_);
-//    out.reserve(in[0].size());
-//    for(unsigned sample_idx = 0; sample_idx < in[0].size(); sample_idx++)
-//    {
-//        std::vector<Sample *> cur_sample_in_vec;
-//        for(unsigned i = 0; i < in.size(); i++)
-//        {
-//            cur_sample_in_vec.push_back(in[i][sample_idx]);
-//        }
-//        std::vector<Sample *> cur_sample_out_vec;
-//        aggregate_vector(cur_sample_in_vec, aggregation_options, cur_sample_out_vec);
-//        assert(cur_sample_out_vec.size() == 1);
-//        out.push_back(cur_sample_out_vec[0]);
-//    }
-//}
-
-//void perform_chain_sample_aggregation(const cfg::Arguments_aggregator &args)
-//{
-//    std::vector<unsigned> flex_vars = util::setup_flex_vars(
-//            args.exploration_rate_.data_.no_aggregation_idx_,
-//            args.chain_.data_.no_aggregation_idx_);
-//    std::vector<Sample *> chain;
-//    load_inference_record(
-//            args.in_folder_,
-//            args.dataset_.data_.no_aggregation_idx_,
-//            util::IT_METROPOLIS,
-//            flex_vars,
-//            chain);
-//    std::vector<Sample *> aggregated;
-//    aggregate_vector(
-//            chain,
-//            args.chain_sample_,
-//            aggregated);
-//    save_inference_record(
-//            args.out_folder_,
-//            args.dataset_.data_.no_aggregation_idx_,
-//            util::IT_METROPOLIS,
-//            flex_vars,
-//            aggregated);
-//    if(args.chain_sample_.data_.aggregation_range_.type_ == cfg::Arguments_aggregator::AT_MEAN)
-//        free_chain_samples(aggregated);
-//    free_chain_samples(chain);
-//}
-
-//void perform_chain_aggregation(const cfg::Arguments_aggregator &args)
-//{
-//    std::vector<unsigned> fv;
-//    std::vector<std::vector<Sample *>> chains;
-//    for(
-//            unsigned chain_cur = args.chain_.data_.aggregation_range_.start_idx_;
-//            chain_cur <= args.chain_.data_.aggregation_range_.stop_idx_;
-//            chain_cur += args.chain_.data_.aggregation_range_.stride_)
-//    {
-//        fv = util::setup_flex_vars(
-//                args.exploration_rate_.data_.no_aggregation_idx_,
-//                chain_cur);
-//        chains.push_back(std::vector<Sample *>());
-//        load_inference_record(
-//                args.in_folder_,
-//                args.dataset_.data_.no_aggregation_idx_,
-//                util::IT_METROPOLIS,
-//                fv,
-//                chains[chains.size() - 1]);
-//    }
-
-//    std::vector<Sample *> out;
-//    aggregate_vector_of_vectors(chains, args.chain_, out);
-
-//    fv = util::setup_flex_vars(
-//            args.exploration_rate_.data_.no_aggregation_idx_,
-//            args.chain_.data_.aggregation_range_.start_idx_);
-//    save_inference_record(
-//            args.out_folder_,
-//            args.dataset_.data_.no_aggregation_idx_,
-//            util::IT_METROPOLIS,
-//            fv,
-//            out);
-//}
+enum Aggregated_dim
+{
+    AD_DATASET,
+    AD_EXPLORATION_RATE,
+    AD_CHAIN,
+    AD_ITERATION,
+
+    // DO NOT CREATE ENTRIES BELOW HERE
+    AD_COUNT
+};
+const std::string AD_STRS[AD_COUNT] = {
+    "Dataset",
+    "Exploration Rate",
+    "Chain",
+    "Iteration"
+};
+
+std::string possible_aggregation_to_str(const cfg::Arguments_aggregator::Possible_aggregation &pa)
+{
+    if(!pa.aggregate_) return util::pad_unsigned(pa.data_.no_aggregation_idx_);
+    return util::pad_unsigned(pa.data_.aggregation_range_.start_idx_)
+            + "-" + util::pad_unsigned(pa.data_.aggregation_range_.stop_idx_);
+}
 
+boost::filesystem::path get_aggregate_csv_path(const cfg::Arguments_aggregator &args)
+{
+    boost::filesystem::path r(args.out_folder_.empty() ? args.in_folder_ : args.out_folder_);
+    boost::filesystem::create_directories(r);
+    std::ostringstream fname;
+    fname << possible_aggregation_to_str(args.dataset_)
+          << "_" << possible_aggregation_to_str(args.exploration_rate_)
+          << "_" << possible_aggregation_to_str(args.chain_)
+          << "_" << possible_aggregation_to_str(args.chain_sample_)
+          << "_aggregate.csv";
+    return r / fname.str();
+}
 
-//void perform_exploration_rate_aggregation(cfg::Arguments_aggregator &args)
-//{
-//    std::vector<unsigned> fv;
-//    std::vector<std::vector<Sample *>> chains;
-//    for(
-//            unsigned expl_rate_cur = args.exploration_rate_.data_.aggregation_range_.start_idx_;
-//            expl_rate_cur <= args.exploration_rate_.data_.aggregation_range_.stop_idx_;
-//            expl_rate_cur += args.exploration_rate_.data_.aggregation_range_.stride_)
-//    {
-//        fv = util::setup_flex_vars(
-//                expl_rate_cur,
-//                args.chain_.data_.no_aggregation_idx_);
-//        chains.push_back(std::vector<Sample *>());
-//        load_inference_record(
-//                args.in_folder_,
-//                args.dataset_.data_.no_aggregation_idx_,
-//                util::IT_METROPOLIS,
-//                fv,
-//                chains[chains.size() - 1]);
-//    }
+void save_aggregate_csv(const cfg::Arguments_aggregator &args, Aggregated_dim ad, const Range_binner &bins)
+{
+    std::vector<std::string> columns = {
+        AD_STRS[ad] + " Start",
+        AD_STRS[ad] + " Stop",
+        "Count",
+        "Log Probability"
+    };
+    columns.insert(columns.end(), Rvs_idx_str, Rvs_idx_str + RI_COUNT);
+    util::Csv_writer f(get_aggregate_csv_path(args), columns);
+    for(size_t k = 0; k < bins.get_num_bins(); k++)
+    {
+        // With a stride, a bin can be left without any index.
+        if(!bins.get_bin(k).get_count()) continue;
+        Chain_index_entry e = bins.get_bin(k).get();
+        f.write(bins.get_bin_start(k));
+        f.write(bins.get_bin_stop(k));
+        f.write(bins.get_bin(k).get_count());
+        f.write(e.log_prob_);
+        for(size_t i = 0; i < RI_COUNT; i++)
+        {
+            f.write(e.rvs_[i]);
+        }
+        f.end_row();
+    }
+}
 
-//    std::vector<Sample *> out;
-//    aggregate_vector_of_vectors(chains, args.exploration_rate_, out);
+// Streams one chain into bins over args.chain_sample_.
+void bin_chain(
+        const cfg::Arguments_aggregator &args,
+        unsigned dataset_idx,
+        unsigned expl_rate,
+        unsigned chain_idx,
+        Range_binner &out)
+{
+    stream_chain_index(
+            args.in_folder_,
+            dataset_idx,
+            util::IT_METROPOLIS,
+            util::setup_mh_flex_vars(expl_rate, chain_idx),
+            args.inference_archive_ver_,
+            [&](const Chain_index_entry &e) { return out.add(e); });
+}
 
-//    fv = util::setup_flex_vars(
-//            args.exploration_rate_.data_.aggregation_range_.start_idx_,
-//            args.chain_.data_.no_aggregation_idx_);
-//    save_inference_record(
-//            args.out_folder_,
-//            args.dataset_.data_.no_aggregation_idx_,
-//            util::IT_METROPOLIS,
-//            fv,
-//            out);
-//}
+void perform_iteration_aggregation(const cfg::Arguments_aggregator &args)
+{
+    Range_binner bins(args.chain_sample_);
+    bin_chain(
+            args,
+            args.dataset_.data_.no_aggregation_idx_,
+            args.exploration_rate_.data_.no_aggregation_idx_,
+            args.chain_.data_.no_aggregation_idx_,
+            bins);
+    save_aggregate_csv(args, AD_ITERATION, bins);
+}
 
-//void perform_dataset_aggregation(cfg::Arguments_aggregator &args)
-//{
-//    std::vector<unsigned> fv = util::setup_flex_vars(
-//            args.exploration_rate_.data_.no_aggregation_idx_,
-//            args.chain_.data_.no_aggregation_idx_);
-//    std::vector<std::vector<Sample *>> chains;
-//    for(
-//            unsigned dataset_cur = args.dataset_.data_.aggregation_range_.start_idx_;
-//            dataset_cur <= args.dataset_.data_.aggregation_range_.stop_idx_;
-//            dataset_cur += args.dataset_.data_.aggregation_range_.stride_)
-//    {
-//        chains.push_back(std::vector<Sample *>());
-//        load_inference_record(
-//                args.in_folder_,
-//                dataset_cur,
-//                util::IT_METROPOLIS,
-//                fv,
-//                chains[chains.size() - 1]);
-//    }
-//    std::vector<Sample *> out;
-//    aggregate_vector_of_vectors(chains, args.dataset_, out);
-//    save_inference_record(
-//            args.out_folder_,
-//            args.dataset_.data_.aggregation_range_.start_idx_,
-//            util::IT_METROPOLIS,
-//            fv,
-//            out);
-//}
+// Gets the value of every chain along ad at the -l iteration in parallel, then
+// bins them in order.
+void perform_interchain_aggregation(const cfg::Arguments_aggregator &args, Aggregated_dim ad)
+{
+    const cfg::Arguments_aggregator::Possible_aggregation *range;
+    switch(ad)
+    {
+    case AD_DATASET:
+        range = &args.dataset_;
+        break;
+    case AD_EXPLORATION_RATE:
+        range = &args.exploration_rate_;
+        break;
+    case AD_CHAIN:
+        range = &args.chain_;
+        break;
+    default:
+        throw util::Unhandled_enum_value_exception(); //util::err_str(__FILE__, __LINE__);
+    }
+    std::vector<unsigned> idxs = range->get_indices();
+    std::vector<Chain_index_entry> values(idxs.size());
+
+    util::Thread_pool pool(args.num_threads_);
+    pool.parallel_for(idxs.size(), [&](size_t i)
+    {
+        Range_binner iteration(args.chain_sample_);
+        bin_chain(
+                args,
+                ad == AD_DATASET ? idxs[i] : args.dataset_.data_.no_aggregation_idx_,
+                ad == AD_EXPLORATION_RATE ? idxs[i] : args.exploration_rate_.data_.no_aggregation_idx_,
+                ad == AD_CHAIN ? idxs[i] : args.chain_.data_.no_aggregation_idx_,
+                iteration);
+        // the chain is shorter than the iteration
+        if(!iteration.get_bin(0).get_count()) throw util::Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
+        values[i] = iteration.get_bin(0).get();
+        values[i].first_iteration_ = idxs[i];
+        values[i].count_ = 1;
+    });
+
+    Range_binner bins(*range);
+    for(const Chain_index_entry &e : values)
+    {
+        bins.add(e);
+    }
+    save_aggregate_csv(args, ad, bins);
+}
 
 }
 }
@@ -296,23 +185,24 @@ namespace driver_aggregator
 
 int main(int argc, char *argv[])
 {
-//    using namespace fracture;
-//    using namespace fracture::block_2d::driver_aggregator;
-//    cfg::Arguments_aggregator args(argc, argv);
-//    if(args.dataset_.aggregate_)
-//    {
-//        perform_dataset_aggregation(args);
-//    }
-//    else if(args.exploration_rate_.aggregate_)
-//    {
-//        perform_exploration_rate_aggregation(args);
-//    }
-//    else if(args.chain_.aggregate_)
-//    {
-//        perform_chain_aggregation(args);
-//    }
-//    else if(args.chain_sample_.aggregate_)
-//    {
-//        perform_chain_sample_aggregation(args);
-//    }
+    using namespace fracture;
+    using namespace fracture::block_2d::driver_aggregator;
+    cfg::Arguments_aggregator args(argc, argv);
+    if(args.dataset_.aggregate_)
+    {
+        perform_interchain_aggregation(args, AD_DATASET);
+    }
+    else if(args.exploration_rate_.aggregate_)
+    {
+        perform_interchain_aggregation(args, AD_EXPLORATION_RATE);
+    }
+    else if(args.chain_.aggregate_)
+    {
+        perform_interchain_aggregation(args, AD_CHAIN);
+    }
+    else
+    {
+        // a single -l iteration is one bin as well
+        perform_iteration_aggregation(args);
+    }
 }
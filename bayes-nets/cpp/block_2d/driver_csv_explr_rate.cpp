@@ -2,6 +2,8 @@
 
 #include "config.hpp"
 #include "sample.hpp"
+#include "chain_index.hpp"
+#include "csv_writer.hpp"
 
 namespace fracture
 {
@@ -22,10 +24,7 @@ void save_std_differences(
           << "_" << util::INFERENCE_TYPE_STR[util::IT_METROPOLIS]
           << "_expl_rate_comparison.csv";
     sample_instance_path /= fname.str();
-    std::ofstream f(
-            sample_instance_path.string(),
-            std::ios_base::out | std::ios_base::trunc
-    );
+    std::vector<std::string> columns;
     size_t i;
     size_t j;
     for(
@@ -33,18 +32,18 @@ void save_std_differences(
             i < chain_log_probs.size();
             i++, j += args.exploration_rate_.data_.aggregation_range_.stride_)
     {
-        if(i!=0) f << ",";
-        f << "\"Expl. Rate " << j << " Mean\"";
+        columns.push_back("Expl. Rate " + std::to_string(j) + " Mean");
     }
-    f << ",\"True Log Probability\"\n";
+    columns.push_back("True Log Probability");
+    Csv_writer f(sample_instance_path, columns);
     for(size_t j = 0; j < chain_log_probs[0].size(); j++)
     {
         for(size_t i = 0; i < chain_log_probs.size(); i++)
         {
-            if(i!=0) f << ",";
-            f << "\"" << chain_log_probs[i][j] << "\"";
+            f.write(chain_log_probs[i][j]);
         }
-        f<<",\""<<ground_truth_log_prob<<"\"\n";
+        f.write(ground_truth_log_prob);
+        f.end_row();
     }
 }
 
@@ -66,36 +65,39 @@ int main(int argc, char *argv[])
     load_data_record(args.ground_truth_folder_, args.dataset_.data_.no_aggregation_idx_, ground_truth);
     double ground_truth_log_prob = ground_truth.sample_.log_prob();
 
-    std::vector<Inference_record_20191031> results;
-    std::vector<std::vector<std::pair<double, double>>> explr_rate_stats;
-    for(
-            unsigned explr_rate_idx = args.exploration_rate_.data_.aggregation_range_.start_idx_;
-            explr_rate_idx <= args.exploration_rate_.data_.aggregation_range_.stop_idx_;
-            explr_rate_idx += args.exploration_rate_.data_.aggregation_range_.stride_)
+    std::vector<std::vector<unsigned>> explr_rate_flex_vars;
+    for(unsigned explr_rate_idx : args.exploration_rate_.get_indices())
     {
-        std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(
+        explr_rate_flex_vars.push_back(util::setup_mh_flex_vars(
                 explr_rate_idx,
-                args.chain_.data_.no_aggregation_idx_);
-        Inference_record_20191031 ir;
-        load_inference_record(
+                args.chain_.data_.no_aggregation_idx_));
+    }
+    // We want to aggregate multiple chains here, then look at the trends between different
+    // standard deviation values. Only the log probability column of the
+    // sidecars is read.
+    util::Thread_pool pool(args.num_threads_);
+    std::vector<std::vector<double>> cached_log_probs(explr_rate_flex_vars.size());
+    pool.parallel_for(explr_rate_flex_vars.size(), [&](size_t i)
+    {
+        stream_chain_index(
                 args.in_folder_,
                 args.dataset_.data_.no_aggregation_idx_,
                 util::IT_METROPOLIS,
-                flex_vars,
-                ir);
-        results.push_back(ir);
-        // We want to aggregate multiple chains here, then look at the trends between different
-        // standard deviation values.
-        std::vector<std::vector<double>> cached_log_probs;
-        // TODO fix this
-        //cache_log_probs(results, cached_log_probs);
+                explr_rate_flex_vars[i],
+                args.inference_archive_ver_,
+                [&](const Chain_index_entry &run)
+                {
+                    cached_log_probs[i].insert(cached_log_probs[i].end(), run.count_, run.log_prob_);
+                    return true;
+                },
+                IC_LOG_PROB);
+    });
 
-        // We want to keep all other things constant and only look at the chains, in this case,
-        // to get a sense of whether the samples are getting stuck in local minima.
-            // This becomes one table in a CSV.
-        save_std_differences(
-                    args,
-                    cached_log_probs,
-                    ground_truth_log_prob);
-    }
+    // We want to keep all other things constant and only look at the chains, in this case,
+    // to get a sense of whether the samples are getting stuck in local minima.
+    // This becomes one table in a CSV.
+    save_std_differences(
+                args,
+                cached_log_probs,
+                ground_truth_log_prob);
 }
@@ -3,7 +3,9 @@
 #include "config.hpp"
 #include "sample.hpp"
 #include "sample_vector_adapter.hpp"
+#include "chain_index.hpp"
 #include "util.hpp"
+#include "csv_writer.hpp"
 
 namespace fracture
 {
@@ -12,14 +14,13 @@ namespace block_2d
 namespace driver_csv_hidden_rvs
 {
 
-void print_hidden_rvs_csv_record(std::ofstream &f, const Sample &s)
+void print_hidden_rvs_csv_record(util::Csv_writer &f, const Chain_index_entry &e)
 {
-    Sample_vector_adapter sva;
-    for(unsigned col = 0; col < sva.size(&s); col++)
+    for(unsigned col = 0; col < RI_COUNT; col++)
     {
-        if(col != 0) f << ",";
-        f << "\"" << sva.get(&s, col) << "\"";
+        f.write(e.rvs_[col]);
     }
+    f.write(e.log_prob_);
 }
 
 
@@ -28,7 +29,7 @@ void save_csv_hidden_rvs(
         unsigned dataset_idx,
         unsigned explr_rate,
         unsigned chain_idx,
-        const std::vector<Sample *> &chain,
+        const Chain_index &chain,
         const Sample &ground_truth)
 {
     using namespace fracture;
@@ -38,41 +39,35 @@ void save_csv_hidden_rvs(
     std::ostringstream fname;
     fname << pad_unsigned(dataset_idx) << "_" << util::INFERENCE_TYPE_STR[util::IT_METROPOLIS] << "_" << pad_unsigned(explr_rate) << "_" << pad_unsigned(chain_idx) << "_hidden_rvs.csv";
     sample_instance_path /= fname.str();
-    std::ofstream f(
-            sample_instance_path.string(),
-            std::ios_base::out | std::ios_base::trunc
-    );
 
-    Sample_vector_adapter sva;
+    Chain_index_entry ground_truth_entry(ground_truth, ground_truth.log_prob(), 0, 1, false);
 
-    f << "\"Iteration\",";
+    std::vector<std::string> columns(1, "Iteration");
     for(size_t inference_or_gt = 0; inference_or_gt < 2; inference_or_gt++)
     {
-        for(size_t col = 0; col < sva.size(&ground_truth); col++)
-        {
-            if(col > 0) f << ",";
-            f << "\"" << Rvs_idx_str[col] << "\"";
-        }
-        f << ",\"Log Probability\"";
-        if(inference_or_gt == 0) f << ",\"\",";
+        columns.insert(columns.end(), Rvs_idx_str, Rvs_idx_str + RI_COUNT);
+        columns.push_back("Log Probability");
+        if(inference_or_gt == 0) columns.push_back("");
     }
-    f << "\n";
-    for(size_t chain_sample_idx = 0; chain_sample_idx < chain.size(); chain_sample_idx++)
+    Csv_writer f(sample_instance_path, columns);
+    for(const Chain_index_entry &run : chain.entries_)
     {
-        if(chain_sample_idx != 0 && chain[chain_sample_idx] == chain[chain_sample_idx-1]) continue;
-        f << "\"" << chain_sample_idx << "\",";
-
-        print_hidden_rvs_csv_record(f, *chain[chain_sample_idx]);
-        f << ",\"" << chain[chain_sample_idx]->log_prob() << "\"";
+        size_t chain_sample_idx = run.first_iteration_;
+        f.write(chain_sample_idx);
+        print_hidden_rvs_csv_record(f, run);
 
         // put the ground truth somewhere on the spreadsheet
+        f.skip();
         if(chain_sample_idx == 0)
         {
-            f << ",\"\",";
-            print_hidden_rvs_csv_record(f, ground_truth);
-            f << ",\"" << ground_truth.log_prob() << "\"";
+            print_hidden_rvs_csv_record(f, ground_truth_entry);
         }
-        f << "\n";
+        else
+        {
+            // the ground truth's rvs and log probability
+            for(size_t col = 0; col < RI_COUNT + 1; col++) f.skip();
+        }
+        f.end_row();
     }
 }
 
@@ -109,35 +104,24 @@ int main(int argc, char *argv[])
 
     double ground_truth_log_prob = ground_truth.log_prob();
 
-    std::vector<Sample *> results;
-    std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(
+    std::vector<std::vector<unsigned>> flex_vars(1, util::setup_mh_flex_vars(
             args.exploration_rate_.data_.no_aggregation_idx_,
-            args.chain_.data_.no_aggregation_idx_);
-    if(args.inference_archive_ver_ >= 20191031)
-    {
-        Inference_record_20191031 ir;
-        load_inference_record(
-                args.in_folder_,
-                args.dataset_.data_.no_aggregation_idx_,
-                util::IT_METROPOLIS,
-                flex_vars,
-                ir);
-        results = ir.samples_;
-    }
-    else
-    {
-        load_sample_vector(
-                args.in_folder_,
-                args.dataset_.data_.no_aggregation_idx_,
-                util::IT_METROPOLIS,
-                flex_vars,
-                results);
-    }
+            args.chain_.data_.no_aggregation_idx_));
+    util::Thread_pool pool(args.num_threads_);
+    std::vector<Chain_index> results;
+    load_chain_indices(
+            pool,
+            args.in_folder_,
+            args.dataset_.data_.no_aggregation_idx_,
+            util::IT_METROPOLIS,
+            flex_vars,
+            args.inference_archive_ver_,
+            results);
     save_csv_hidden_rvs(
                 args,
                 args.dataset_.data_.no_aggregation_idx_,
                 args.exploration_rate_.data_.no_aggregation_idx_,
                 args.chain_.data_.no_aggregation_idx_,
-                results,
+                results[0],
                 ground_truth);
 }
@@ -1,23 +1,55 @@
+#include <boost/filesystem/operations.hpp>
+
 #include "config.hpp"
 #include "sample.hpp"
+#include "prob.hpp"
+#include "thread_pool.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+namespace driver_data_gen
+{
+
+void generate_dataset(const cfg::Arguments_data_gen &args, unsigned dataset_idx, unsigned rng_seed)
+{
+    prob::seed_sampling_rand(rng_seed);
+
+    Data_record_20191031 r;
+    r.rng_seed_ = rng_seed;
+    r.sample_ = Sample(args.num_ims_, args.im_w_, args.im_h_, args.cam_fps_);
+
+    save_data_record(args.data_folder_, dataset_idx, r, args.binary_);
+}
+
+}
+}
+}
 
 int main(int argc, char *argv[])
 {
     using namespace fracture;
     using namespace block_2d;
+    using namespace driver_data_gen;
 
     cfg::Arguments_data_gen args;
     args.parse(argc, argv);
 
-    kjb::seed_sampling_rand(args.rng_seed_);
-
-    Sample s(args.num_ims_, args.im_w_, args.im_h_, args.cam_fps_);
-
-    Data_record_20191031 r;
-    r.rng_seed_ = args.rng_seed_;
-    r.sample_ = s;
+    if(!args.num_datasets_)
+    {
+        generate_dataset(args, args.dataset_idx_, args.rng_seed_);
+        return 0;
+    }
 
-    save_data_record(args.data_folder_, args.dataset_idx_, r);
+    // get_sample_path only creates the last level, and not safely from several threads
+    boost::filesystem::create_directories(args.data_folder_);
+    util::Thread_pool pool(args.num_threads_);
+    pool.parallel_for(args.num_datasets_, [&args](size_t i)
+    {
+        unsigned dataset_idx = args.dataset_idx_ + unsigned(i);
+        generate_dataset(args, dataset_idx, prob::derive_seed(args.rng_seed_, dataset_idx));
+    });
 
     return 0;
 }
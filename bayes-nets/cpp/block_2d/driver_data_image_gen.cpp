@@ -3,6 +3,8 @@
 #include "config.hpp"
 #include "sample.hpp"
 #include "util.hpp"
+#include "thread_pool.hpp"
+#include "frame_renderer.hpp"
 
 int main(int argc, char *argv[])
 {
@@ -25,34 +27,28 @@ int main(int argc, char *argv[])
         load_sample(args.data_folder_, args.dataset_idx_, s);
     }
 
-    for(unsigned i = 0; i < s.get_num_ims(); i++)
+    unsigned im_w = s.get_camera().get_image_width();
+    unsigned im_h = s.get_camera().get_image_height();
+    util::Thread_pool pool(args.num_threads_);
+    util::render_frames(pool, s.get_num_ims(), [&](unsigned i, std::vector<util::Rendered_image> &out)
     {
-        util::save_center_of_mass_image(
-                s.get_camera().get_image_width(),
-                s.get_camera().get_image_height(),
-                s.get_image_center_of_mass(i),
-                util::get_data_image_path(
-                        args.data_folder_,
-                        args.dataset_idx_,
-                        i,
-                        util::DIT_CENTER_OF_MASS));
-        util::save_endpoint_image(
-                s.get_camera().get_image_width(),
-                s.get_camera().get_image_height(),
-                s.get_image_polygon_actual(i),
-                util::get_data_image_path(
-                        args.data_folder_,
-                        args.dataset_idx_,
-                        i,
-                        util::DIT_ACTUAL_GEOM));
-        util::save_endpoint_image(
-                s.get_camera().get_image_width(),
-                s.get_camera().get_image_height(),
-                s.get_image_polygon_observed(i),
-                util::get_data_image_path(
-                        args.data_folder_,
-                        args.dataset_idx_,
-                        i,
-                        util::DIT_OBSERVED_GEOM));
-    }
+        out.push_back(util::Rendered_image(im_w, im_h, util::get_data_image_path(
+                args.data_folder_,
+                args.dataset_idx_,
+                i,
+                util::DIT_CENTER_OF_MASS)));
+        util::draw_center_of_mass_image(out.back().image_, s.get_image_center_of_mass(i), cfg::COLOR_FOREGROUND);
+        out.push_back(util::Rendered_image(im_w, im_h, util::get_data_image_path(
+                args.data_folder_,
+                args.dataset_idx_,
+                i,
+                util::DIT_ACTUAL_GEOM)));
+        util::draw_endpoint_image(out.back().image_, s.get_image_polygon_actual(i), cfg::COLOR_FOREGROUND);
+        out.push_back(util::Rendered_image(im_w, im_h, util::get_data_image_path(
+                args.data_folder_,
+                args.dataset_idx_,
+                i,
+                util::DIT_OBSERVED_GEOM)));
+        util::draw_endpoint_image(out.back().image_, s.get_image_polygon_observed(i), cfg::COLOR_FOREGROUND);
+    }, args.image_format_, s.get_camera().get_frames_per_second());
 }
@@ -0,0 +1,145 @@
+// Runs a whole experiment in one process: generates the datasets, runs the MH
+// chains on them and writes the chain comparison csvs. That is what
+// scripts/data_gen.sh, inf_mh.sh and csv_chain.sh do through GNU parallel, e.g.
+//      driver_experiment -x scripts/experiment.cfg -d ./data/ -j 24
+// The grid comes from the config file (see cfg::Arguments_experiment).
+//
+// Every dataset, chain and csv is a task of one Task_graph. A dataset's chains
+// start as soon as it is generated, and its csvs as soon as their chains
+// finish. No stage waits for the previous stage as a whole. Datasets stay in
+// memory between the stages, and only the chains' indices outlive the chains.
+//
+// The archives are the ones the per-stage drivers write. The seed of each
+// dataset and chain is derived from the experiment's seed (see
+// prob::derive_seed) and saved in its archive, so a single one can be redone
+// with driver_data_gen -s or driver_inference_mh -s. The csvs are computed
+// from the whole chains, but the inference archives keep only the last sample,
+// as driver_inference_mh's do.
+
+#include <boost/filesystem/operations.hpp>
+
+#include "config.hpp"
+#include "sample.hpp"
+#include "metropolis_hastings.hpp"
+#include "chain_index.hpp"
+#include "task_graph.hpp"
+#include "prob.hpp"
+#include "util.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+namespace driver_experiment
+{
+
+void generate_dataset(
+        const cfg::Arguments_experiment &args,
+        unsigned dataset_idx,
+        Data_record_20191031 &out)
+{
+    out.rng_seed_ = prob::derive_seed(args.rng_seed_, dataset_idx);
+    prob::seed_sampling_rand(out.rng_seed_);
+    out.sample_ = Sample(args.num_ims_, args.im_w_, args.im_h_, args.cam_fps_);
+    save_data_record(args.data_folder_, dataset_idx, out, args.binary_);
+}
+
+void run_chain(
+        const cfg::Arguments_experiment &args,
+        const Data_record_20191031 &data,
+        unsigned dataset_idx,
+        unsigned stds_exp,
+        unsigned chain_idx,
+        Chain_index &out)
+{
+    unsigned rng_seed = prob::derive_seed(prob::derive_seed(data.rng_seed_, stds_exp), chain_idx);
+    prob::seed_sampling_rand(rng_seed);
+    Sample mh_init_sample = get_mh_initial_sample(data.sample_);
+    Metropolis_hastings_resampler mhr(
+            rng_seed,
+            args.chain_len_,
+            mh_init_sample,
+            get_mh_stds(args.stds_multiplier_, stds_exp),
+            new No_annealing_schedule(),
+            args.sample_velocity_ ? Metropolis_hastings_resampler::MRS_VELOCITY : Metropolis_hastings_resampler::MRS_MOMENTUM,
+            args.constrain_ang_vel_);
+    while(mhr.still_resampling()) mhr.resample_once();
+
+    const Inference_record_20261019 &chain = mhr.get_saved_samples();
+    std::vector<double> log_probs;
+    log_probs.reserve(chain.runs_.size());
+    for(const Sample_run &run : chain.runs_)
+    {
+        log_probs.push_back(run.sample_->log_prob());
+    }
+    out = Chain_index(chain, log_probs);
+
+    Inference_record_20261019 to_save;
+    to_save.rng_seed_ = chain.rng_seed_;
+    to_save.runs_.push_back(chain.runs_.back());
+    save_inference_record(
+            args.data_folder_,
+            dataset_idx,
+            util::IT_METROPOLIS,
+            util::setup_mh_flex_vars(stds_exp, chain_idx, 0),
+            to_save);
+}
+
+}
+}
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace fracture;
+    using namespace block_2d;
+    using namespace driver_experiment;
+
+    cfg::Arguments_experiment args(argc, argv);
+    boost::filesystem::create_directories(args.data_folder_);
+
+    std::vector<unsigned> stds_exps;
+    for(unsigned i = 0; i < args.num_stds_exps_; i++)
+    {
+        stds_exps.push_back(args.starting_stds_exp_ + i * args.stds_exp_stride_);
+    }
+
+    // indexed by [dataset][exploration rate][chain], each written by one task
+    std::vector<Data_record_20191031> datasets(args.num_datasets_);
+    std::vector<std::vector<std::vector<Chain_index>>> chains(
+            args.num_datasets_,
+            std::vector<std::vector<Chain_index>>(
+                    stds_exps.size(),
+                    std::vector<Chain_index>(args.num_chains_)));
+
+    util::Task_graph g;
+    for(unsigned d = 0; d < args.num_datasets_; d++)
+    {
+        util::Task_graph::Task_id gen = g.add_task([&args, &datasets, d]()
+        {
+            generate_dataset(args, d, datasets[d]);
+        });
+        for(size_t e = 0; e < stds_exps.size(); e++)
+        {
+            std::vector<util::Task_graph::Task_id> chain_tasks;
+            for(unsigned c = 0; c < args.num_chains_; c++)
+            {
+                chain_tasks.push_back(g.add_task([&args, &datasets, &chains, &stds_exps, d, e, c]()
+                {
+                    run_chain(args, datasets[d], d, stds_exps[e], c, chains[d][e][c]);
+                }, {gen}));
+            }
+            g.add_task([&args, &datasets, &chains, &stds_exps, d, e]()
+            {
+                save_chain_comparison_csv(
+                        args.data_folder_,
+                        d,
+                        stds_exps[e],
+                        chains[d][e],
+                        datasets[d].sample_.log_prob());
+                std::vector<Chain_index>().swap(chains[d][e]);
+            }, chain_tasks);
+        }
+    }
+    g.run(args.num_threads_);
+}
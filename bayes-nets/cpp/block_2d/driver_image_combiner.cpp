@@ -1,74 +1,94 @@
-#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+
+#include "boost/archive/archive_exception.hpp"
 
 #include "i_cpp/i_image.h"
 
 #include "config.hpp"
+#include "sample.hpp"
 #include "util.hpp"
+#include "thread_pool.hpp"
+#include "frame_renderer.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+namespace driver_image_combiner
+{
+
+// Draws every layer of frame im_idx in its own color, back to front: the
+// ground truth polygons and centers of mass, the observed polygons, then the
+// inferred polygons and centers of mass.
+void draw_combined_image(
+        util::Canvas &im,
+        const cfg::Arguments_image_combiner &args,
+        const Sample &ground_truth,
+        const Sample &inferred,
+        unsigned im_idx)
+{
+    util::draw_endpoint_image(im, ground_truth.get_image_polygon_actual(im_idx), args.ground_truth_polygons_color_);
+    util::draw_center_of_mass_image(im, ground_truth.get_image_center_of_mass(im_idx), args.ground_truth_centers_of_mass_color_);
+    util::draw_endpoint_image(im, ground_truth.get_image_polygon_observed(im_idx), args.observation_polygons_color_);
+    util::draw_endpoint_image(im, inferred.get_image_polygon_actual(im_idx), args.inference_polygons_color_);
+    util::draw_center_of_mass_image(im, inferred.get_image_center_of_mass(im_idx), args.inference_centers_of_mass_color_);
+}
+
+}
+}
+}
 
 int main(int argc, char *argv[])
 {
     using namespace fracture;
     using namespace cfg;
+    using namespace block_2d;
+    using namespace driver_image_combiner;
 
     Arguments_image_combiner args(argc, argv);
 
-    std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(args.exploration_rate_, args.chain_idx_, args.chain_sample_idx_);
-
-    std::vector<kjb::Image::Pixel_type> colors(5);
-    colors[0] = args.ground_truth_polygons_color_;
-    colors[1] = args.ground_truth_centers_of_mass_color_;
-    colors[2] = args.observation_polygons_color_;
-    colors[3] = args.inference_polygons_color_;
-    colors[4] = args.inference_centers_of_mass_color_;
+    Sample ground_truth;
+    try
+    {
+        Data_record_20191031 dr;
+        load_data_record(args.in_folder_, args.dataset_idx_, dr);
+        ground_truth = dr.sample_;
+    }
+    catch (const boost::archive::archive_exception &e)
+    {
+        load_sample(args.in_folder_, args.dataset_idx_, ground_truth);
+    }
 
-    for(unsigned i = 0; ; i++)
+    Inference_record_20261019 chain;
+    load_inference_chain(
+            args.in_folder_,
+            args.dataset_idx_,
+            util::IT_METROPOLIS,
+            util::setup_mh_flex_vars(args.exploration_rate_, args.chain_idx_, 0),
+            args.inference_archive_ver_,
+            chain);
+    // Past the end of the chain, such as by default, means its last sample.
+    // An empty chain still throws. The images are still filed under the
+    // iteration asked for, as driver_inference_image_gen files them.
+    Sample inferred = *chain.get_sample_at_iteration(std::min<size_t>(args.chain_sample_idx_, chain.get_num_iterations() - 1));
+    for(Sample_run &run : chain.runs_)
     {
-        boost::filesystem::path ground_truth_polygons_path = util::get_data_image_path(args.in_folder_, args.dataset_idx_, i, util::DIT_ACTUAL_GEOM);
-        // Check if we've iterated over every image
-        if(!boost::filesystem::exists(ground_truth_polygons_path)) break;
-        kjb::Image ground_truth_polygons_im(ground_truth_polygons_path.string());
-        kjb::Image ground_truth_centers_of_mass_im(util::get_data_image_path(
-                args.in_folder_,
-                args.dataset_idx_,
-                i,
-                util::DIT_CENTER_OF_MASS).string());
-        kjb::Image observation_polygons_im(util::get_data_image_path(
-                args.in_folder_,
-                args.dataset_idx_,
-                i,
-                util::DIT_OBSERVED_GEOM).string());
-        kjb::Image inference_centers_of_mass_im(util::get_inference_image_path(
-                args.in_folder_,
-                args.dataset_idx_,
-                util::IT_METROPOLIS,
-                flex_vars,
-                i,
-                util::IIT_CENTER_OF_MASS).string());
-        kjb::Image inference_polygons_im(util::get_inference_image_path(
-                args.in_folder_,
-                args.dataset_idx_,
-                util::IT_METROPOLIS,
-                flex_vars,
-                i,
-                util::IIT_GEOM).string());
-        std::vector<const kjb::Image *> images(5);
-        images[0] = &ground_truth_polygons_im;
-        images[1] = &ground_truth_centers_of_mass_im;
-        images[2] = &observation_polygons_im;
-        images[3] = &inference_polygons_im;
-        images[4] = &inference_centers_of_mass_im;
+        delete run.sample_;
+    }
 
-        kjb::Image out_im(ground_truth_polygons_im.get_num_rows(), ground_truth_polygons_im.get_num_cols(), cfg::COLOR_BACKGROUND.r, cfg::COLOR_BACKGROUND.g, cfg::COLOR_BACKGROUND.b);
-        for(size_t cur_im_idx = 0; cur_im_idx < images.size(); cur_im_idx++)
-        {
-            util::transfer_image_contents(out_im, *images[cur_im_idx], colors[cur_im_idx]);
-        }
-        out_im.write(util::get_inference_image_path(
+    std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(args.exploration_rate_, args.chain_idx_, args.chain_sample_idx_);
+    unsigned im_w = ground_truth.get_camera().get_image_width();
+    unsigned im_h = ground_truth.get_camera().get_image_height();
+    util::Thread_pool pool(args.num_threads_);
+    util::render_frames(pool, ground_truth.get_num_ims(), [&](unsigned i, std::vector<util::Rendered_image> &out)
+    {
+        out.push_back(util::Rendered_image(im_w, im_h, util::get_inference_image_path(
                 args.in_folder_,
                 args.dataset_idx_,
                 util::IT_METROPOLIS,
                 flex_vars,
                 i,
-                util::IIT_COMBINED).string());
-    }
+                util::IIT_COMBINED)));
+        draw_combined_image(out.back().image_, args, ground_truth, inferred, i);
+    }, args.image_format_, ground_truth.get_camera().get_frames_per_second());
 }
@@ -0,0 +1,82 @@
+// Writes the metrics sidecar (see Chain_index) next to each inference archive,
+// so that the csv and aggregation drivers don't need to deserialize the
+// archive or recompute log probabilities again. Takes the same arguments as the
+// csv drivers, e.g.
+//      driver_index_chains -d ./data/ -i 0 -e 5 -c 0-15
+// Chains are indexed in parallel (-j threads), one chain per thread.
+
+#include "config.hpp"
+#include "sample.hpp"
+#include "chain_index.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+namespace driver_index_chains
+{
+
+void index_chain(
+        const cfg::Arguments_aggregator &args,
+        unsigned dataset_idx,
+        const std::vector<unsigned> &flex_vars)
+{
+    Inference_record_20261019 chain;
+    load_inference_chain(
+            args.in_folder_,
+            dataset_idx,
+            util::IT_METROPOLIS,
+            flex_vars,
+            args.inference_archive_ver_,
+            chain);
+    std::vector<double> log_probs;
+    log_probs.reserve(chain.runs_.size());
+    for(const Sample_run &run : chain.runs_)
+    {
+        log_probs.push_back(run.sample_->log_prob());
+    }
+    save_chain_index(
+            args.in_folder_,
+            dataset_idx,
+            util::IT_METROPOLIS,
+            flex_vars,
+            Chain_index(chain, log_probs));
+    for(Sample_run &run : chain.runs_)
+    {
+        delete run.sample_;
+    }
+}
+
+}
+}
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace fracture;
+    using namespace cfg;
+    using namespace block_2d;
+    using namespace driver_index_chains;
+
+    cfg::Arguments_aggregator args(argc, argv);
+
+    std::vector<std::pair<unsigned, std::vector<unsigned>>> chains;
+    for(unsigned dataset_idx : args.dataset_.get_indices())
+    {
+        for(unsigned explr_rate : args.exploration_rate_.get_indices())
+        {
+            for(unsigned chain_idx : args.chain_.get_indices())
+            {
+                chains.push_back(std::make_pair(dataset_idx, util::setup_mh_flex_vars(explr_rate, chain_idx)));
+            }
+        }
+    }
+
+    util::Thread_pool pool(args.num_threads_);
+    pool.parallel_for(chains.size(), [&](size_t i)
+    {
+        index_chain(args, chains[i].first, chains[i].second);
+    });
+}
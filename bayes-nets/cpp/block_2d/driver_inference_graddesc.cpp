@@ -37,7 +37,7 @@ static void run_sample(const cfg::Arguments_inference_mh & args)
     log_file << "data log probability: " << cur_sample.log_prob() << "\n";
     log_file.flush();
 
-    Inference_record_20191031 results;
+    Inference_record_20261019 results;
     results.rng_seed_ = args.rng_seed_;
 
     double exploration_rate = std::pow(args.stds_multiplier_, args.stds_exp_);
@@ -82,7 +82,7 @@ static void run_sample(const cfg::Arguments_inference_mh & args)
     log_file << "chain #: " << args.chain_idx_ << " | iterations: " << i << " | log prob: " << cur_sample.log_prob() << "\n";
     log_file.flush();
 
-    results.samples_.push_back(new Sample(cur_sample));
+    results.push_back(new Sample(cur_sample));
 
     std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(args.stds_exp_, args.chain_idx_, 0);
     save_inference_record(
@@ -105,7 +105,7 @@ int main(int argc, char *argv[])
 
     Arguments_inference_mh args(argc, argv);
 
-    kjb::seed_sampling_rand(args.rng_seed_);
+    prob::seed_sampling_rand(args.rng_seed_);
 
     run_sample(args);
 }
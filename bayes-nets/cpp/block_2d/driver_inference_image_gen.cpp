@@ -3,6 +3,8 @@
 #include "config.hpp"
 #include "sample.hpp"
 #include "util.hpp"
+#include "thread_pool.hpp"
+#include "frame_renderer.hpp"
 
 int main(int argc, char *argv[])
 {
@@ -26,57 +28,41 @@ int main(int argc, char *argv[])
 
     Sample s;
 
-    if(args.inference_archive_ver_ >= 20191031)
-    {
-        Inference_record_20191031 ir;
-        load_inference_record(
-                args.in_folder_,
-                args.dataset_.data_.no_aggregation_idx_,
-                util::IT_METROPOLIS,
-                chain_flex_vars,
-                ir);
-        s = *ir.samples_[args.chain_sample_.data_.no_aggregation_idx_];
-    }
-    else
-    {
-        std::vector<Sample *> vec;
-        load_sample_vector(
-                args.in_folder_,
-                args.dataset_.data_.no_aggregation_idx_,
-                util::IT_METROPOLIS,
-                chain_flex_vars,
-                vec);
-        s = *vec[args.chain_sample_.data_.no_aggregation_idx_];
-    }
+    Inference_record_20261019 ir;
+    load_inference_chain(
+            args.in_folder_,
+            args.dataset_.data_.no_aggregation_idx_,
+            util::IT_METROPOLIS,
+            chain_flex_vars,
+            args.inference_archive_ver_,
+            ir);
+    s = *ir.get_sample_at_iteration(args.chain_sample_.data_.no_aggregation_idx_);
 
     std::vector<unsigned> im_flex_vars = util::setup_mh_flex_vars(
                 args.exploration_rate_.data_.no_aggregation_idx_,
                 args.chain_.data_.no_aggregation_idx_,
                 args.chain_sample_.data_.no_aggregation_idx_);
 
-    for(unsigned i = 0; i < s.get_num_ims(); i++)
+    unsigned im_w = s.get_camera().get_image_width();
+    unsigned im_h = s.get_camera().get_image_height();
+    util::Thread_pool pool(args.num_threads_);
+    util::render_frames(pool, s.get_num_ims(), [&](unsigned i, std::vector<util::Rendered_image> &out)
     {
-        util::save_center_of_mass_image(
-                s.get_camera().get_image_width(),
-                s.get_camera().get_image_height(),
-                s.get_image_center_of_mass(i),
-                util::get_inference_image_path(
-                        args.in_folder_,
-                        args.dataset_.data_.no_aggregation_idx_,
-                        util::IT_METROPOLIS,
-                        im_flex_vars,
-                        i,
-                        IIT_CENTER_OF_MASS));
-        util::save_endpoint_image(
-                s.get_camera().get_image_width(),
-                s.get_camera().get_image_height(),
-                s.get_image_polygon_actual(i),
-                util::get_inference_image_path(
-                        args.in_folder_,
-                        args.dataset_.data_.no_aggregation_idx_,
-                        util::IT_METROPOLIS,
-                        im_flex_vars,
-                        i,
-                        IIT_GEOM));
-    }
+        out.push_back(util::Rendered_image(im_w, im_h, util::get_inference_image_path(
+                args.in_folder_,
+                args.dataset_.data_.no_aggregation_idx_,
+                util::IT_METROPOLIS,
+                im_flex_vars,
+                i,
+                IIT_CENTER_OF_MASS)));
+        util::draw_center_of_mass_image(out.back().image_, s.get_image_center_of_mass(i), cfg::COLOR_FOREGROUND);
+        out.push_back(util::Rendered_image(im_w, im_h, util::get_inference_image_path(
+                args.in_folder_,
+                args.dataset_.data_.no_aggregation_idx_,
+                util::IT_METROPOLIS,
+                im_flex_vars,
+                i,
+                IIT_GEOM)));
+        util::draw_endpoint_image(out.back().image_, s.get_image_polygon_actual(i), cfg::COLOR_FOREGROUND);
+    }, args.image_format_, s.get_camera().get_frames_per_second());
 }
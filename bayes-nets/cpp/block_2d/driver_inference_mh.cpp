@@ -11,6 +11,7 @@
 #include "util.hpp"
 #include "sample.hpp"
 #include "metropolis_hastings.hpp"
+#include "least_squares.hpp"
 
 namespace fracture
 {
@@ -19,52 +20,6 @@ namespace block_2d
 namespace driver_inference_mh
 {
 
-static void init_mh_stds(std::vector<double> &vec, double multiplier, unsigned multiplier_exp)
-{
-    multiplier = std::pow(multiplier, double(multiplier_exp));
-    for(double &elem : vec)
-    {
-        elem *= multiplier;
-    }
-}
-
-
-void draw_and_save_image(const cfg::Arguments_inference_mh & args, const Sample & s, const std::vector<unsigned> & flex_vars, unsigned im_idx)
-{
-    kjb::Image im_com(int(s.get_camera().get_image_height()), int(s.get_camera().get_image_width()), cfg::COLOR_BACKGROUND.r, cfg::COLOR_BACKGROUND.g, cfg::COLOR_BACKGROUND.b);
-    kjb::Image im_inf_geom(int(s.get_camera().get_image_height()), int(s.get_camera().get_image_width()), cfg::COLOR_BACKGROUND.r, cfg::COLOR_BACKGROUND.g, cfg::COLOR_BACKGROUND.b);
-    std::vector<const kjb::Vector_d<3> *> centers_of_mass = s.get_image_center_of_mass(im_idx);
-    for(const kjb::Vector_d<3> *pt : centers_of_mass)
-    {
-        im_com.draw_point((*pt)[0] / (*pt)[2], (*pt)[1] / (*pt)[2], 1, cfg::COLOR_FOREGROUND);
-    }
-    std::vector<const kjb::Matrix_d<3,4> *> polygons = s.get_image_polygon_actual(im_idx);
-    for(const kjb::Matrix_d<3,4> *block : polygons)
-    {
-        util::draw_poly_edges(im_inf_geom, util::static_matrix_to_dynamic_matrix<3,4>(*block), cfg::COLOR_FOREGROUND);
-    }
-    im_com.write(util::get_inference_image_path(
-            args.data_folder_,
-            args.dataset_idx_,
-            util::IT_METROPOLIS,
-            flex_vars,
-            im_idx,
-            util::IIT_CENTER_OF_MASS).string());
-    im_inf_geom.write(util::get_inference_image_path(
-            args.data_folder_,
-            args.dataset_idx_,
-            util::IT_METROPOLIS,
-            flex_vars,
-            im_idx,
-            util::IIT_GEOM).string());
-}
-
-void draw_and_save_images(const cfg::Arguments_inference_mh & args, const Sample & s, const std::vector<unsigned> & flex_vars)
-{
-    for(unsigned j = 0; j < s.get_num_ims(); j++)
-        draw_and_save_image(args, s, flex_vars, j);
-}
-
 static void run_sample(const cfg::Arguments_inference_mh & args)
 {
     using namespace fracture::block_2d;
@@ -80,15 +35,37 @@ static void run_sample(const cfg::Arguments_inference_mh & args)
         load_sample(args.data_folder_, args.dataset_idx_, data_sample);
     }
 
-    std::vector<double> stds = Metropolis_hastings_resampler::DEFAULT_STDS;
-    init_mh_stds(stds, args.stds_multiplier_, args.stds_exp_);
-
-    block_2d::Sample mh_init_sample(data_sample);
-    mh_init_sample.forward_sample_hidden_rvs();
-    // 20191217 experiment: clamp width, height to the known good values to see if we still get local
-    // optima.
-    mh_init_sample.set_block_initial_width(data_sample.get_initial_block_rvs().get_initial_width());
-    mh_init_sample.set_block_initial_height(data_sample.get_initial_block_rvs().get_initial_height());
+    std::vector<double> stds = get_mh_stds(args.stds_multiplier_, args.stds_exp_);
+    std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(args.stds_exp_, args.chain_idx_, 0);
+    block_2d::Sample mh_init_sample;
+    if(args.resume_)
+    {
+        // The last chain saved under these arguments ran on fewer frames.
+        // Its last sample only needs the new ones simulated.
+        Inference_record_20261019 prev;
+        load_inference_chain(
+                args.data_folder_,
+                args.dataset_idx_,
+                util::IT_METROPOLIS,
+                flex_vars,
+                args.inference_archive_ver_,
+                prev);
+        if(prev.runs_.empty()) throw util::Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
+        mh_init_sample = *prev.runs_.back().sample_;
+        for(Sample_run &run : prev.runs_)
+        {
+            delete run.sample_;
+        }
+        mh_init_sample.extend(data_sample);
+    }
+    else if(args.least_squares_init_)
+    {
+        mh_init_sample = get_least_squares_initial_sample(data_sample);
+    }
+    else
+    {
+        mh_init_sample = get_mh_initial_sample(data_sample);
+    }
     // Whether to enable annealing or not. At some point, this should be made a command
     // line parameter or config file variable.
     // start at a temperature of a million. set an alpha such that the temperature is 1 after
@@ -103,20 +80,18 @@ static void run_sample(const cfg::Arguments_inference_mh & args)
             as,
             args.sample_velocity_ ? Metropolis_hastings_resampler::MRS_VELOCITY : Metropolis_hastings_resampler::MRS_MOMENTUM,
             args.constrain_ang_vel_);
-    std::vector<unsigned> flex_vars = util::setup_mh_flex_vars(args.stds_exp_, args.chain_idx_, 0);
     while(mhr.still_resampling()) mhr.resample_once();
     // Only save the last sample. Otherwise, with annealing, the number of saved samples was too long.
     // The last sample is a good heuristic for the best probability in the chain.
-    Inference_record_20191031 to_save;
+    Inference_record_20261019 to_save;
     to_save.rng_seed_ = mhr.get_saved_samples().rng_seed_;
-    to_save.samples_.push_back(mhr.get_saved_samples().samples_[mhr.get_saved_samples().samples_.size() - 1]);
+    to_save.runs_.push_back(mhr.get_saved_samples().runs_.back());
     save_inference_record(
             args.data_folder_,
             args.dataset_idx_,
             util::IT_METROPOLIS,
             flex_vars,
             to_save);
-    delete as;
 }
 
 }
@@ -131,7 +106,7 @@ int main(int argc, char *argv[])
 
     Arguments_inference_mh args(argc, argv);
 
-    kjb::seed_sampling_rand(args.rng_seed_);
+    prob::seed_sampling_rand(args.rng_seed_);
 
     run_sample(args);
 }
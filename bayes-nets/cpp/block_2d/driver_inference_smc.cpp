@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+#include "config.hpp"
+#include "util.hpp"
+#include "sample.hpp"
+#include "sample_vector_adapter.hpp"
+#include "smc.hpp"
+#include "thread_pool.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+namespace driver_inference_smc
+{
+
+static void run_smc(const cfg::Arguments_inference_smc & args)
+{
+    using namespace fracture::block_2d;
+    Sample data_sample;
+    if(args.data_archive_ver_ >= 20191031)
+    {
+        Data_record_20191031 data_record;
+        load_data_record(args.data_folder_, args.dataset_idx_, data_record);
+        data_sample = data_record.sample_;
+    }
+    else if(args.data_archive_ver_ < 20191031)
+    {
+        load_sample(args.data_folder_, args.dataset_idx_, data_sample);
+    }
+
+    util::Thread_pool pool(args.num_threads_);
+    std::vector<unsigned> flex_vars = {args.num_particles_, args.num_moves_};
+    auto start = std::chrono::steady_clock::now();
+    // When streaming, the sampler starts on as few frames as it can, and
+    // the rest come in one at a time.
+    Sample first_frames(data_sample);
+    std::unique_ptr<Smc_sampler> smc;
+    if(args.resume_)
+    {
+        Smc_record prev;
+        load_smc_record(args.data_folder_, args.dataset_idx_, flex_vars, prev);
+        if(args.stream_) first_frames.truncate(prev.cur_frame_);
+        smc.reset(new Smc_sampler(prev, first_frames, args.num_moves_, args.ess_threshold_, pool));
+    }
+    else
+    {
+        if(args.stream_) first_frames.truncate(2);
+        smc.reset(new Smc_sampler(
+                args.rng_seed_,
+                args.num_particles_,
+                first_frames,
+                args.num_moves_,
+                args.ess_threshold_,
+                pool));
+    }
+    smc->assimilate_all();
+    for(unsigned num_ims = first_frames.get_num_ims() + 1; num_ims <= data_sample.get_num_ims(); num_ims++)
+    {
+        auto frame_start = std::chrono::steady_clock::now();
+        Sample frames(data_sample);
+        frames.truncate(num_ims);
+        smc->extend(frames);
+        smc->assimilate_all();
+        std::chrono::duration<double> frame_elapsed = std::chrono::steady_clock::now() - frame_start;
+        std::cout << "frame " << num_ims - 1 << ": " << frame_elapsed.count() << "s" << std::endl;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    save_smc_record(args.data_folder_, args.dataset_idx_, flex_vars, smc->get_record());
+
+    std::cout << "frames: " << smc->get_num_frames()
+              << ", resamples: " << smc->get_num_resamples()
+              << ", acceptance rate: " << smc->get_acceptance_rate()
+              << ", time: " << elapsed.count() << "s" << std::endl;
+    std::cout << "log evidence: " << smc->get_log_evidence() << std::endl;
+    Sample_vector_adapter sva;
+    std::vector<double> means = smc->get_posterior_means();
+    std::vector<double> stds = smc->get_posterior_stds();
+    for(size_t i = 0; i < RI_COUNT; i++)
+    {
+        std::cout << std::setw(18) << Rvs_idx_str[i] << ": "
+                  << means[i] << " +/- " << stds[i]
+                  << " (data: " << sva.get(&data_sample, i) << ")" << std::endl;
+    }
+}
+
+}
+}
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace fracture;
+    using namespace cfg;
+    using namespace fracture::block_2d::driver_inference_smc;
+
+    Arguments_inference_smc args(argc, argv);
+
+    run_smc(args);
+}
@@ -0,0 +1,200 @@
+#include <map>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <thread>
+
+#include "frame_renderer.hpp"
+#include "config.hpp"
+#include "video_writer.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+Rendered_image::Rendered_image(unsigned im_w, unsigned im_h, const boost::filesystem::path &path) :
+        image_(im_w, im_h, cfg::COLOR_BACKGROUND),
+        path_(path)
+{}
+
+namespace
+{
+
+// Rendered frames on their way to the writer, which takes them in frame order.
+// A frame that's early waits here until the ones before it are written.
+class Frame_queue
+{
+public:
+    explicit Frame_queue(size_t max_queued) :
+            max_queued_(max_queued),
+            next_(0),
+            aborted_(false)
+    {}
+
+    // Blocks while the queue is full. The frame the writer waits for is always
+    // let in, since otherwise nothing could be written to make room.
+    void push(unsigned frame, std::vector<Rendered_image> &images)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&]()
+        {
+            return aborted_ || frame == next_ || frames_.size() < max_queued_;
+        });
+        if(aborted_) return;
+        frames_[frame].swap(images);
+        ready_.notify_one();
+    }
+
+    // Waits for the next frame. false if aborted first.
+    bool pop(std::vector<Rendered_image> &images)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [&]() { return aborted_ || frames_.count(next_); });
+        if(aborted_) return false;
+        std::map<unsigned, std::vector<Rendered_image>>::iterator it = frames_.find(next_);
+        images.swap(it->second);
+        frames_.erase(it);
+        next_++;
+        not_full_.notify_all();
+        return true;
+    }
+
+    void abort()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        not_full_.notify_all();
+        ready_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable ready_;
+    std::map<unsigned, std::vector<Rendered_image>> frames_;
+    size_t max_queued_;
+    unsigned next_;
+    bool aborted_;
+};
+
+// Writes each image where render_frames' format says.
+class Image_writer
+{
+public:
+    Image_writer(Image_format format, double fps) :
+            format_(format),
+            fps_(fps)
+    {}
+
+    void write(const Rendered_image &im)
+    {
+        switch(format_)
+        {
+        case IF_TIFF:
+            im.image_.write(im.path_);
+            break;
+        case IF_Y4M:
+            write_video_frame(im);
+            break;
+        default:
+            throw Unhandled_enum_value_exception(); //util::err_str(__FILE__, __LINE__);
+        }
+    }
+
+private:
+    void write_video_frame(const Rendered_image &im)
+    {
+        std::string video_path = get_video_path(im.path_).string();
+        std::map<std::string, std::unique_ptr<Y4m_writer>>::iterator it = videos_.find(video_path);
+        if(it == videos_.end())
+        {
+            it = videos_.insert(std::make_pair(video_path, std::unique_ptr<Y4m_writer>(new Y4m_writer(
+                    video_path,
+                    im.image_.get_num_cols(),
+                    im.image_.get_num_rows(),
+                    fps_)))).first;
+        }
+        // frames can only be appended
+        if(get_video_frame_idx(im.path_) != it->second->get_num_frames())
+        {
+            throw Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
+        }
+        it->second->write_frame(im.image_);
+    }
+
+    Image_format format_;
+    double fps_;
+    std::map<std::string, std::unique_ptr<Y4m_writer>> videos_;
+};
+
+}
+
+void render_frames(
+        Thread_pool &pool,
+        unsigned num_frames,
+        const std::function<void(unsigned, std::vector<Rendered_image> &)> &render_frame,
+        Image_format format,
+        double fps,
+        size_t max_queued_frames)
+{
+    if(!max_queued_frames) max_queued_frames = 2 * size_t(pool.get_num_threads());
+    Frame_queue q(max_queued_frames);
+
+    std::exception_ptr write_error;
+    std::thread writer([&]()
+    {
+        try
+        {
+            Image_writer w(format, fps);
+            for(unsigned i = 0; i < num_frames; i++)
+            {
+                std::vector<Rendered_image> images;
+                if(!q.pop(images)) return;
+                for(const Rendered_image &im : images)
+                {
+                    w.write(im);
+                }
+            }
+        }
+        catch(...)
+        {
+            write_error = std::current_exception();
+            q.abort();
+        }
+    });
+
+    try
+    {
+        // parallel_for hands the frames out in order, so the one the writer
+        // waits for is always already being rendered.
+        pool.parallel_for(num_frames, [&](size_t i)
+        {
+            std::vector<Rendered_image> images;
+            try
+            {
+                render_frame(unsigned(i), images);
+            }
+            catch(...)
+            {
+                // The writer would wait for this frame forever, and the
+                // renderers behind it for room in the queue.
+                q.abort();
+                throw;
+            }
+            q.push(unsigned(i), images);
+        });
+    }
+    catch(...)
+    {
+        q.abort();
+        writer.join();
+        throw;
+    }
+    writer.join();
+    if(write_error) std::rethrow_exception(write_error);
+}
+
+}
+}
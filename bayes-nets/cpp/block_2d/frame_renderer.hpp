@@ -0,0 +1,52 @@
+#ifndef FRAME_RENDERER_HPP
+#define FRAME_RENDERER_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include <boost/filesystem/path.hpp>
+
+#include "canvas.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+// An image of one frame, waiting to be written to path_.
+class Rendered_image
+{
+public:
+    // starts out im_w x im_h and cfg::COLOR_BACKGROUND
+    Rendered_image(unsigned im_w, unsigned im_h, const boost::filesystem::path &path);
+
+    Canvas image_;
+    boost::filesystem::path path_;
+};
+
+// Calls render_frame(i, out) for every frame i in [0, num_frames) on the pool.
+// The call appends the frame's images to out. One writer thread writes the
+// frames in order while the later ones are still being rendered. At most
+// max_queued_frames rendered frames wait for the writer (0 means two per pool
+// thread), so a slow disk holds back the renderers instead of filling memory.
+// Returns once everything is written. The first exception thrown by a render
+// or a write is rethrown here.
+//
+// With IF_Y4M, each image becomes frame get_video_frame_idx(path_) of the
+// video get_video_path(path_) at fps frames per second, so every video gets
+// its frames from exactly one render_frames call, starting at frame 0.
+void render_frames(
+        Thread_pool &pool,
+        unsigned num_frames,
+        const std::function<void(unsigned, std::vector<Rendered_image> &)> &render_frame,
+        Image_format format = IF_TIFF,
+        double fps = 30.0,
+        size_t max_queued_frames = 0);
+
+}
+}
+
+#endif // FRAME_RENDERER_HPP
@@ -57,8 +57,8 @@ public:
     Initial_block_rvs(const Camera & c)
     {
         update_distributions(c);
-        init_x_ = kjb::sample(init_x_dist_);
-        init_y_ = kjb::sample(init_y_dist_);
+        init_x_ = prob::sample(init_x_dist_);
+        init_y_ = prob::sample(init_y_dist_);
         init_w_ = prob::sample(INIT_WIDTH_DIST);
         init_h_ = prob::sample(INIT_HEIGHT_DIST);
     }
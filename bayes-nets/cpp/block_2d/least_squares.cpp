@@ -0,0 +1,389 @@
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "least_squares.hpp"
+#include "sample_vector_adapter.hpp"
+#include "util.hpp"
+
+namespace fracture { namespace block_2d {
+
+// The rvs that get fit. The width and height setters are no-ops (see
+// Sample::set_block_initial_width).
+static const size_t FIT_RVS[] = {RI_C_T, RI_INIT_X, RI_INIT_Y, RI_FRAC_LOC, RI_R_X_MOM, RI_L_ANG_MOM};
+static const size_t NUM_FIT_RVS = sizeof(FIT_RVS) / sizeof(FIT_RVS[0]);
+// Whether each of FIT_RVS has to be nonnegative. Both momenta do (see
+// Fracture_rvs).
+static const bool FIT_RVS_NONNEGATIVE[] = {false, false, false, false, true, true};
+// How far a fragment's angle may go against its spin in one frame, in
+// radians, before it's taken as a turn the other way. For noise.
+static const double BACKWARD_TURN_MARGIN = 0.5;
+
+// Image coordinates of corner col, as a world point divided by the meters
+// per pixel (see Camera::get_camera_matrix): x to the right, y up.
+static void get_scaled_world_corner(const kjb::Matrix_d<3,4> & poly, size_t col, unsigned im_h, double & x, double & y)
+{
+    x = poly(1, col) / poly(2, col);
+    y = double(im_h) - poly(0, col) / poly(2, col);
+}
+
+// Corners 0 -> 1 and 3 -> 2 run along the block's local x axis, and 3 -> 0
+// and 2 -> 1 along its local y axis (see
+// Block_geom::recalculate_local_endpoints). The sums of each pair are
+// twice the width and twice the height.
+static void get_scaled_side_vectors(const kjb::Matrix_d<3,4> & poly, unsigned im_h, double & wx, double & wy, double & hx, double & hy)
+{
+    double c[4][2];
+    for(size_t i = 0; i < 4; i++)
+    {
+        get_scaled_world_corner(poly, i, im_h, c[i][0], c[i][1]);
+    }
+    wx = (c[1][0] - c[0][0]) + (c[2][0] - c[3][0]);
+    wy = (c[1][1] - c[0][1]) + (c[2][1] - c[3][1]);
+    hx = (c[0][0] - c[3][0]) + (c[1][0] - c[2][0]);
+    hy = (c[0][1] - c[3][1]) + (c[1][1] - c[2][1]);
+}
+
+static void get_scaled_center(const kjb::Matrix_d<3,4> & poly, unsigned im_h, double & x, double & y)
+{
+    x = 0.0;
+    y = 0.0;
+    for(size_t i = 0; i < 4; i++)
+    {
+        double cx, cy;
+        get_scaled_world_corner(poly, i, im_h, cx, cy);
+        x += cx / 4.0;
+        y += cy / 4.0;
+    }
+}
+
+static void set_fit_rvs(Sample & s, const std::vector<double> & vals)
+{
+    Sample_vector_adapter sva;
+    for(size_t k = 0; k < NUM_FIT_RVS; k++)
+    {
+        sva.set(&s, FIT_RVS[k], vals[k]);
+    }
+}
+
+static std::vector<double> get_fit_rvs(const Sample & s)
+{
+    Sample_vector_adapter sva;
+    std::vector<double> r(NUM_FIT_RVS);
+    for(size_t k = 0; k < NUM_FIT_RVS; k++)
+    {
+        r[k] = sva.get(&s, FIT_RVS[k]);
+    }
+    return r;
+}
+
+// Observed minus actual image coordinates of every corner of every frame.
+static void get_residuals(const Sample & s, std::vector<double> & out)
+{
+    out.clear();
+    for(unsigned t = 0; t < s.get_num_ims(); t++)
+    {
+        std::vector<const kjb::Matrix_d<3,4> *> actual = s.get_image_polygon_actual(t);
+        std::vector<const kjb::Matrix_d<3,4> *> observed = s.get_image_polygon_observed(t);
+        for(size_t p = 0; p < actual.size(); p++)
+        {
+            for(size_t i = 0; i < 4; i++)
+            {
+                for(size_t j = 0; j < 2; j++)
+                {
+                    out.push_back((*observed[p])(j, i) - (*actual[p])(j, i) / (*actual[p])(2, i));
+                }
+            }
+        }
+    }
+}
+
+static double sum_of_squares(const std::vector<double> & v)
+{
+    double r = 0.0;
+    for(double d : v)
+    {
+        r += d * d;
+    }
+    return r;
+}
+
+// Solves a x = b in place by Gaussian elimination with partial pivoting.
+// Returns false if a is singular.
+static bool solve(std::vector<std::vector<double>> a, std::vector<double> & b)
+{
+    size_t n = b.size();
+    for(size_t col = 0; col < n; col++)
+    {
+        size_t pivot = col;
+        for(size_t row = col + 1; row < n; row++)
+        {
+            if(std::abs(a[row][col]) > std::abs(a[pivot][col])) pivot = row;
+        }
+        if(a[pivot][col] == 0.0) return false;
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for(size_t row = col + 1; row < n; row++)
+        {
+            double f = a[row][col] / a[col][col];
+            for(size_t k = col; k < n; k++)
+            {
+                a[row][k] -= f * a[col][k];
+            }
+            b[row] -= f * b[col];
+        }
+    }
+    for(size_t i = n; i > 0; i--)
+    {
+        size_t row = i - 1;
+        for(size_t k = row + 1; k < n; k++)
+        {
+            b[row] -= a[row][k] * b[k];
+        }
+        b[row] /= a[row][row];
+    }
+    return true;
+}
+
+// The closed form estimates. s has at least 2 frames.
+static void fit_closed_form(Sample & s)
+{
+    const Camera & c = s.get_camera();
+    unsigned im_h = c.get_image_height();
+    double fps = c.get_frames_per_second();
+    double w = s.get_initial_block_rvs().get_initial_width();
+    double h = s.get_initial_block_rvs().get_initial_height();
+
+    // Frame 0: the parent hasn't turned yet, so its sides are the box's.
+    const kjb::Matrix_d<3,4> & parent = *s.get_image_polygon_observed(0)[0];
+    double corners[4][2];
+    for(size_t i = 0; i < 4; i++)
+    {
+        get_scaled_world_corner(parent, i, im_h, corners[i][0], corners[i][1]);
+    }
+    double w_px = (std::hypot(corners[1][0] - corners[0][0], corners[1][1] - corners[0][1])
+            + std::hypot(corners[2][0] - corners[3][0], corners[2][1] - corners[3][1])) / 2.0;
+    double h_px = (std::hypot(corners[0][0] - corners[3][0], corners[0][1] - corners[3][1])
+            + std::hypot(corners[1][0] - corners[2][0], corners[1][1] - corners[2][1])) / 2.0;
+    double meters_per_pixel = (w * w_px + h * h_px) / (w_px * w_px + h_px * h_px);
+    double x0, y0;
+    get_scaled_center(parent, im_h, x0, y0);
+    x0 *= meters_per_pixel;
+    y0 *= meters_per_pixel;
+
+    // Later frames: each fragment moves at a constant x velocity and
+    // angular velocity from the fracture on, so position and angle are
+    // lines through frame 0. Their slopes are fit through the origin.
+    double width_px[2] = {0.0, 0.0};
+    double sum_t_angle[2] = {0.0, 0.0};
+    double sum_t_x[2] = {0.0, 0.0};
+    double prev_angle[2] = {0.0, 0.0};
+    // The left fragment spins counterclockwise and the right one clockwise
+    // (see Fracture_rvs), so a turn between frames is unwrapped into most
+    // of a full turn in that direction rather than half a turn either way.
+    const double spin[2] = {1.0, -1.0};
+    double sum_t = 0.0;
+    double sum_tt = 0.0;
+    for(unsigned t = 1; t < s.get_num_ims(); t++)
+    {
+        std::vector<const kjb::Matrix_d<3,4> *> fragments = s.get_image_polygon_observed(t);
+        for(size_t f = 0; f < 2; f++)
+        {
+            double wx, wy, hx, hy;
+            get_scaled_side_vectors(*fragments[f], im_h, wx, wy, hx, hy);
+            width_px[f] += std::hypot(wx, wy) / 2.0;
+            // The height turned back a quarter turn points along the width.
+            // Adding the two lets the longer sides, whose direction the
+            // noise moves the least, count the most.
+            double turn = spin[f] * (std::atan2(wy - hx, wx + hy) - prev_angle[f]);
+            turn -= 2.0 * M_PI * std::floor((turn + BACKWARD_TURN_MARGIN) / (2.0 * M_PI));
+            double angle = prev_angle[f] + spin[f] * turn;
+            prev_angle[f] = angle;
+            sum_t_angle[f] += double(t) * angle;
+            double x, y;
+            get_scaled_center(*fragments[f], im_h, x, y);
+            sum_t_x[f] += double(t) * x * meters_per_pixel;
+        }
+        sum_t += double(t);
+        sum_tt += double(t) * double(t);
+    }
+
+    double frac_loc = w * width_px[Block_geom::FS_LEFT] / (width_px[Block_geom::FS_LEFT] + width_px[Block_geom::FS_RIGHT]);
+    frac_loc = std::min(std::max(frac_loc, 0.01 * w), 0.99 * w);
+    Block_geom left_geom(frac_loc, h);
+    Block_geom right_geom(w - frac_loc, h);
+    Block_geom parent_geom(w, h);
+
+    // A fragment's velocity is its share of the momentum divided by its
+    // volume, per frame. The two fragments' shares have opposite signs, so
+    // each momentum is one least squares fit to both slopes.
+    double left_per_mom = 1.0 / (left_geom.get_volume() * fps);
+    double right_per_mom = 1.0 / (right_geom.get_volume() * fps);
+    double left_x_vel = (sum_t_x[Block_geom::FS_LEFT] - (x0 + left_geom.fracture_x_offset(parent_geom, Block_geom::FS_LEFT)) * sum_t) / sum_tt;
+    double right_x_vel = (sum_t_x[Block_geom::FS_RIGHT] - (x0 + right_geom.fracture_x_offset(parent_geom, Block_geom::FS_RIGHT)) * sum_t) / sum_tt;
+    double r_x_mom = (-left_per_mom * left_x_vel + right_per_mom * right_x_vel)
+            / (left_per_mom * left_per_mom + right_per_mom * right_per_mom);
+    // The smaller fragment spins faster, and may still turn too far
+    // between frames to unwrap, so only the larger one's angles count.
+    double l_ang_mom = left_geom.get_volume() >= right_geom.get_volume()
+            ? sum_t_angle[Block_geom::FS_LEFT] / sum_tt / left_per_mom
+            : -sum_t_angle[Block_geom::FS_RIGHT] / sum_tt / right_per_mom;
+
+    // See FIT_RVS_NONNEGATIVE for the momenta.
+    set_fit_rvs(s, {
+            meters_per_pixel * double(im_h),
+            x0,
+            y0,
+            frac_loc,
+            std::max(r_x_mom, 0.0),
+            std::max(l_ang_mom, 0.0)});
+}
+
+// Levenberg-Marquardt damped Gauss-Newton, with a central difference
+// Jacobian through the Sample's own simulation.
+static void fit_gauss_newton(Sample & s, unsigned num_steps)
+{
+    std::vector<double> vals = get_fit_rvs(s);
+    std::vector<double> residuals;
+    get_residuals(s, residuals);
+    double cost = sum_of_squares(residuals);
+    double damping = 1e-3;
+    for(unsigned step = 0; step < num_steps; step++)
+    {
+        size_t m = residuals.size();
+        std::vector<std::vector<double>> jacobian(NUM_FIT_RVS, std::vector<double>(m));
+        for(size_t k = 0; k < NUM_FIT_RVS; k++)
+        {
+            double delta = 1e-6 * std::max(std::abs(vals[k]), 1e-3);
+            std::vector<double> hi_vals(vals);
+            std::vector<double> lo_vals(vals);
+            hi_vals[k] += delta;
+            lo_vals[k] -= delta;
+            std::vector<double> hi_residuals(residuals);
+            std::vector<double> lo_residuals(residuals);
+            // One sided at the edge of the support.
+            Sample hi(s);
+            try
+            {
+                set_fit_rvs(hi, hi_vals);
+                get_residuals(hi, hi_residuals);
+            }
+            catch(const prob::No_support_exception &e)
+            {
+                hi_vals[k] = vals[k];
+            }
+            Sample lo(s);
+            try
+            {
+                set_fit_rvs(lo, lo_vals);
+                get_residuals(lo, lo_residuals);
+            }
+            catch(const prob::No_support_exception &e)
+            {
+                lo_vals[k] = vals[k];
+            }
+            double run = hi_vals[k] - lo_vals[k];
+            for(size_t i = 0; i < m; i++)
+            {
+                jacobian[k][i] = run > 0.0 ? (hi_residuals[i] - lo_residuals[i]) / run : 0.0;
+            }
+        }
+
+        // The normal equations, J^T J and J^T r.
+        std::vector<std::vector<double>> jtj(NUM_FIT_RVS, std::vector<double>(NUM_FIT_RVS, 0.0));
+        std::vector<double> jtr(NUM_FIT_RVS, 0.0);
+        for(size_t a = 0; a < NUM_FIT_RVS; a++)
+        {
+            for(size_t b = 0; b < NUM_FIT_RVS; b++)
+            {
+                for(size_t i = 0; i < m; i++)
+                {
+                    jtj[a][b] += jacobian[a][i] * jacobian[b][i];
+                }
+            }
+            for(size_t i = 0; i < m; i++)
+            {
+                jtr[a] += jacobian[a][i] * residuals[i];
+            }
+        }
+
+        // Raise the damping, toward gradient descent, until a step lowers
+        // the cost.
+        bool improved = false;
+        for(unsigned attempt = 0; attempt < 10 && !improved; attempt++)
+        {
+            std::vector<std::vector<double>> damped(jtj);
+            for(size_t k = 0; k < NUM_FIT_RVS; k++)
+            {
+                damped[k][k] += damping * jtj[k][k];
+            }
+            // The residuals are observed minus actual, so the step is
+            // -(J^T J)^-1 J^T r.
+            std::vector<double> step_vals(jtr);
+            Sample candidate(s);
+            std::vector<double> new_vals(vals);
+            std::vector<double> new_residuals;
+            if(solve(damped, step_vals))
+            {
+                // Steps past 0 stop there, so that a momentum at 0 doesn't
+                // hold back the others.
+                for(size_t k = 0; k < NUM_FIT_RVS; k++)
+                {
+                    new_vals[k] -= step_vals[k];
+                    if(FIT_RVS_NONNEGATIVE[k]) new_vals[k] = std::max(new_vals[k], 0.0);
+                }
+                try
+                {
+                    set_fit_rvs(candidate, new_vals);
+                    get_residuals(candidate, new_residuals);
+                    improved = sum_of_squares(new_residuals) < cost;
+                }
+                catch(const prob::No_support_exception &e)
+                {
+                }
+            }
+            if(improved)
+            {
+                s = candidate;
+                vals = new_vals;
+                residuals = new_residuals;
+                cost = sum_of_squares(residuals);
+                damping /= 10.0;
+            }
+            else
+            {
+                damping *= 10.0;
+            }
+        }
+        if(!improved) break;
+    }
+}
+
+Sample get_least_squares_initial_sample(const Sample & data_sample, unsigned num_frames, unsigned num_steps)
+{
+    if(data_sample.get_num_ims() < 2) throw util::Index_oob_exception();
+    unsigned last_window = std::min(std::max(num_frames, 2u), data_sample.get_num_ims());
+    Sample first_frames(data_sample);
+    first_frames.truncate(last_window);
+    fit_closed_form(first_frames);
+    std::vector<double> vals = get_fit_rvs(first_frames);
+
+    // An error in a fast spin grows frame by frame, and over many frames the
+    // squared error has minima elsewhere, so the fit starts on a few frames
+    // and takes in twice as many each time.
+    for(unsigned window = std::min(3u, last_window); ; window = std::min(2 * window, last_window))
+    {
+        Sample fit(data_sample);
+        fit.truncate(window);
+        set_fit_rvs(fit, vals);
+        fit_gauss_newton(fit, num_steps);
+        vals = get_fit_rvs(fit);
+        if(window == last_window) break;
+    }
+
+    Sample r(data_sample);
+    set_fit_rvs(r, vals);
+    return r;
+}
+
+}}
@@ -0,0 +1,32 @@
+#ifndef LEAST_SQUARES_HPP
+#define LEAST_SQUARES_HPP
+
+#include "sample.hpp"
+
+namespace fracture { namespace block_2d {
+
+const unsigned LEAST_SQUARES_NUM_FRAMES_DEF = 10;
+const unsigned LEAST_SQUARES_NUM_STEPS_DEF = 10;
+
+// A sample a chain on data_sample can start from instead of a draw from the
+// prior. The hidden rvs are fit to the observed polygons of the first
+// num_frames frames:
+//
+// - the parent's box at frame 0 gives the meters per pixel, so c_t, and its
+//   center gives the initial position,
+// - the fragments' widths give the fracture location,
+// - the slopes of their positions and angles over time give their x
+//   momentum and angular momentum.
+//
+// These closed form estimates then get num_steps damped Gauss-Newton steps
+// on the squared image error, the negative log likelihood up to a constant.
+// The width and height are kept at data_sample's, as get_mh_initial_sample
+// keeps them. Deterministic: nothing is drawn from the sampling rng.
+Sample get_least_squares_initial_sample(
+        const Sample & data_sample,
+        unsigned num_frames = LEAST_SQUARES_NUM_FRAMES_DEF,
+        unsigned num_steps = LEAST_SQUARES_NUM_STEPS_DEF);
+
+}}
+
+#endif // LEAST_SQUARES_HPP
@@ -1,8 +1,11 @@
+#include <cmath>
+
 #include <boost/math/constants/constants.hpp>
 
 #include <prob_cpp/prob_sample.h>
 
 #include "metropolis_hastings.hpp"
+#include "prob.hpp"
 #include "config.hpp"
 #include "util.hpp"
 
@@ -39,7 +42,7 @@ Metropolis_hastings_resampler::Inference_resample_result Metropolis_hastings_res
     if(cur_iter_ >= num_resamples_) throw util::Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
 
     Sample *new_sample = new Sample(*cur_sample_);
-    double uniform = kjb::sample(acceptance_test);
+    double uniform = prob::sample(acceptance_test);
     double log_uniform = std::log(uniform);
 
     for(unsigned i = 0; i < sva_.size(new_sample); i++)
@@ -57,7 +60,7 @@ Metropolis_hastings_resampler::Inference_resample_result Metropolis_hastings_res
                 if(!try_resample_r_x_mom(*new_sample)) goto cleanup_rejected;
                 break;
             default:
-                sva_.set(new_sample, i, sva_.get(new_sample, i) + kjb::sample(resample_dists_[i]));
+                sva_.set(new_sample, i, sva_.get(new_sample, i) + prob::sample(resample_dists_[i]));
                 break;
             }
         }
@@ -111,7 +114,7 @@ cleanup_rejected:
     delete new_sample;
     r = IRR_REJECTED;
 cleanup_common:
-    saved_samples_.samples_.push_back(cur_sample_);
+    saved_samples_.push_back(cur_sample_);
     cur_iter_++;
     return r;
 }
@@ -129,14 +132,14 @@ bool Metropolis_hastings_resampler::try_resample_l_ang_mom(Sample & s)
         sva_.set(
                     &s,
                     RI_L_ANG_MOM,
-                    sva_.get(&s, RI_L_ANG_MOM) + kjb::sample(resample_dists_[RI_L_ANG_MOM])
+                    sva_.get(&s, RI_L_ANG_MOM) + prob::sample(resample_dists_[RI_L_ANG_MOM])
         );
         left_ang_vel_in_frames_new = s.get_left_block().get_state(1).get_hidden_state().get(SV_ANGULAR_VELOCITY);
         left_ang_vel_in_seconds_new = left_ang_vel_in_frames_new * s.get_camera().get_frames_per_second();
         break;
     case MRS_VELOCITY:
         // at this point, resample_dists_[mrs_] should be in terms of velocity already (see constructor).
-        left_ang_vel_in_frames_new = s.get_left_block().get_state(1).get_hidden_state().get(SV_ANGULAR_VELOCITY) + kjb::sample(resample_dists_[RI_L_ANG_MOM]);
+        left_ang_vel_in_frames_new = s.get_left_block().get_state(1).get_hidden_state().get(SV_ANGULAR_VELOCITY) + prob::sample(resample_dists_[RI_L_ANG_MOM]);
         left_ang_vel_in_seconds_new = left_ang_vel_in_frames_new * s.get_camera().get_frames_per_second();
         left_ang_mom_new = left_ang_vel_in_seconds_new * s.get_left_block().get_local_geometry().get_volume();
         sva_.set(&s, RI_L_ANG_MOM, left_ang_mom_new);
@@ -175,10 +178,10 @@ bool Metropolis_hastings_resampler::try_resample_r_x_mom(Sample & s)
     switch(mrs_)
     {
     case MRS_MOMENTUM:
-        sva_.set(&s, RI_R_X_MOM, sva_.get(&s, RI_R_X_MOM) + kjb::sample(resample_dists_[RI_R_X_MOM]));
+        sva_.set(&s, RI_R_X_MOM, sva_.get(&s, RI_R_X_MOM) + prob::sample(resample_dists_[RI_R_X_MOM]));
         break;
     case MRS_VELOCITY:
-        right_x_vel_in_frames_new = s.get_right_block().get_state(1).get_hidden_state().get(SV_X_VELOCITY) + kjb::sample(right_x_vel_dist);
+        right_x_vel_in_frames_new = s.get_right_block().get_state(1).get_hidden_state().get(SV_X_VELOCITY) + prob::sample(right_x_vel_dist);
         right_x_vel_in_seconds_new = right_x_vel_in_frames_new * s.get_camera().get_frames_per_second();
         right_x_mom_new = right_x_vel_in_seconds_new * s.get_right_block().get_local_geometry().get_volume();
         sva_.set(&s, RI_R_X_MOM, right_x_mom_new);
@@ -190,4 +193,26 @@ bool Metropolis_hastings_resampler::try_resample_r_x_mom(Sample & s)
     return true;
 }
 
+std::vector<double> get_mh_stds(double multiplier, unsigned multiplier_exp)
+{
+    std::vector<double> r = Metropolis_hastings_resampler::DEFAULT_STDS;
+    multiplier = std::pow(multiplier, double(multiplier_exp));
+    for(double &elem : r)
+    {
+        elem *= multiplier;
+    }
+    return r;
+}
+
+Sample get_mh_initial_sample(const Sample & data_sample)
+{
+    Sample r(data_sample);
+    r.forward_sample_hidden_rvs();
+    // 20191217 experiment: clamp width, height to the known good values to see if we still get local
+    // optima.
+    r.set_block_initial_width(data_sample.get_initial_block_rvs().get_initial_width());
+    r.set_block_initial_height(data_sample.get_initial_block_rvs().get_initial_height());
+    return r;
+}
+
 }}
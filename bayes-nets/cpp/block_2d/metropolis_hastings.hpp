@@ -45,6 +45,7 @@ public:
             unsigned num_resamples,
             const Sample & initial_sample,
             const std::vector<double> & resample_stds,
+            // the resampler takes ownership of the schedule
             Annealing_schedule * const annealing_schedule,
             enum Movement_resampling_strategy mrs = MRS_MOMENTUM,
             bool constrain_ang_vel = false) :
@@ -58,8 +59,7 @@ public:
             constrain_ang_vel_(constrain_ang_vel)
     {
         saved_samples_.rng_seed_ = rng_seed;
-        saved_samples_.samples_.reserve(num_resamples_ + 1);
-        saved_samples_.samples_.push_back(cur_sample_);
+        saved_samples_.push_back(cur_sample_);
         for(unsigned i = 0; i < RI_COUNT; i++)
         {
             if(mrs == MRS_VELOCITY && i == RI_L_ANG_MOM)
@@ -95,24 +95,20 @@ public:
 
     ~Metropolis_hastings_resampler()
     {
-        Sample *prev = nullptr;
-        for(Sample *s : saved_samples_.samples_)
+        for(Sample_run &run : saved_samples_.runs_)
         {
-            if(s != prev)
-            {
-                prev = s;
-                delete s;
-            }
+            delete run.sample_;
         }
         delete as_;
     }
 
-    Inference_record_20191031 &get_saved_samples() { return saved_samples_; }
+    Inference_record_20261019 &get_saved_samples() { return saved_samples_; }
 
     unsigned get_num_resamples() { return num_resamples_; }
     // Ideally, metropolis hastings wouldn't need to know about what we are doing with the samples
-    // as they are generated. The shared pointers here betray that we are doing some data collation
-    // of the samples, and the samples have a high rejection rate. This saves a lot of allocations.
+    // as they are generated. The samples have a high rejection rate, so the saved chain stores
+    // each distinct sample once along with how many iterations it was kept for. This saves a lot
+    // of allocations.
     const Sample *get_cur_sample() const {return cur_sample_;}
     Sample *get_cur_sample() {return cur_sample_;}
     double get_cur_log_prob() const {return cur_log_prob_;}
@@ -143,7 +139,7 @@ private:
     kjb::Normal_distribution resample_dists_[RI_COUNT];
     unsigned cur_iter_;
     Sample *cur_sample_;
-    Inference_record_20191031 saved_samples_;
+    Inference_record_20261019 saved_samples_;
     double cur_log_prob_;
     Sample_vector_adapter sva_;
 
@@ -152,6 +148,14 @@ private:
     bool constrain_ang_vel_;
 };
 
+// DEFAULT_STDS scaled by multiplier^multiplier_exp, i.e. the proposal stds of
+// exploration rate multiplier_exp.
+std::vector<double> get_mh_stds(double multiplier, unsigned multiplier_exp);
+
+// The sample a chain on data_sample starts from. Draws from the sampling rng,
+// so seed it first.
+Sample get_mh_initial_sample(const Sample & data_sample);
+
 }
 }
 
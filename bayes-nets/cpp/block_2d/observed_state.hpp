@@ -14,6 +14,7 @@
 #include <prob_cpp/prob_sample.h>
 
 #include "hidden_state.hpp"
+#include "prob.hpp"
 
 namespace fracture { namespace block_2d {
 
@@ -36,7 +37,7 @@ public:
                 // Ensure the noise is added in a consistent way by dividing by the homogeneous
                 // component first.
                 image_polygon_obs_(j, i) /= image_polygon_obs_(2, i);
-                image_polygon_obs_(j, i) += kjb::sample(image_noise_dist);
+                image_polygon_obs_(j, i) += prob::sample(image_noise_dist);
             }
             image_polygon_obs_(2, i) = 1.0;
         }
@@ -9,6 +9,7 @@
 #include <boost/math/distributions.hpp>
 #include <boost/random/discrete_distribution.hpp>
 
+#include <prob_cpp/prob_distribution.h>
 #include <prob_cpp/prob_sample.h>
 
 
@@ -71,6 +72,19 @@ double pdf(const Truncated_normal_distribution & dist, double p);
 double log_pdf(const Truncated_normal_distribution & dist, double p);
 double sample(const Truncated_normal_distribution & dist);
 
+// kjb::sample draws from one generator shared by the whole process, so two
+// threads sampling at once race on it, and neither result can be reproduced
+// from its seed. These draw from a generator owned by the calling thread
+// instead. Each thread must seed its own generator before sampling.
+void seed_sampling_rand(unsigned seed);
+double sample(const kjb::Normal_distribution & dist);
+double sample(const kjb::Uniform_distribution & dist);
+
+// Derives the seed of a sub-task (a dataset, a chain, ...) from the seed of
+// the experiment and the sub-task's index, so that sub-tasks get unrelated
+// streams no matter which thread or process runs them.
+unsigned derive_seed(unsigned base_seed, unsigned key);
+
 class No_support_exception : std::exception
 {
 //public:
@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <cctype>
+
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
 
 #include "config.hpp"
 #include "sample.hpp"
@@ -131,8 +136,8 @@ void Sample::forward_sample_hidden_rvs()
     // We want to update the data structure in one shot, but essentially are doing so 8
     // times and propagating those calculated values.
     set_camera_top(prob::sample(Camera::C_T_DIST));
-    set_block_initial_x(kjb::sample(init_block_rvs_.get_initial_x_distribution()));
-    set_block_initial_y(kjb::sample(init_block_rvs_.get_initial_y_distribution()));
+    set_block_initial_x(prob::sample(init_block_rvs_.get_initial_x_distribution()));
+    set_block_initial_y(prob::sample(init_block_rvs_.get_initial_y_distribution()));
     set_block_initial_width(prob::sample(Initial_block_rvs::INIT_WIDTH_DIST));
     set_block_initial_height(prob::sample(Initial_block_rvs::INIT_HEIGHT_DIST));
     set_fracture_location(prob::sample(frac_rvs_.get_fracture_location_distribution()));
@@ -170,18 +175,6 @@ Block Sample::init_child_block(Block_geom::Fragment_side fs, unsigned num_ims)
             bg.momentum_to_velocity(ang_mom) / cam_.get_frames_per_second());
     return Block(cam_, bg, s, 1, num_ims);
 }
-std::tuple<std::shared_ptr<Sample>, double, unsigned> aggregate_samples(const std::vector<std::tuple<std::shared_ptr<Sample>, double, unsigned>> & vec, size_t first, size_t last)
-{
-    double log_prob = 0.0;
-    unsigned number_acceptances = 0;
-    for(size_t i = first; i < last; i++)
-    {
-        log_prob += std::get<1>(vec[i]);
-        number_acceptances += std::get<2>(vec[i]);
-    }
-    log_prob /= (last - first);
-    return std::tuple<std::shared_ptr<Sample>, double, unsigned>(std::get<0>(vec[(first + last) / 2]), log_prob, number_acceptances);
-}
 
 void Sample::recalculate_values()
 {
@@ -192,6 +185,23 @@ void Sample::recalculate_values()
     right_block_.recalculate_child_values(cam_, init_block_rvs_, parent_block_.get_local_geometry(), parent_block_.get_state(0).get_hidden_state(), frac_rvs_, Block_geom::FS_RIGHT);
 }
 
+void Sample::extend(const Sample & data)
+{
+    if(data.num_ims_ < num_ims_) throw util::Index_oob_exception();
+    left_block_.extend(cam_, data.left_block_);
+    right_block_.extend(cam_, data.right_block_);
+    num_ims_ = data.num_ims_;
+}
+
+void Sample::truncate(unsigned num_ims)
+{
+    // The fragments start at frame 1, so they need it.
+    if(num_ims < 2 || num_ims > num_ims_) throw util::Index_oob_exception();
+    left_block_.truncate(num_ims);
+    right_block_.truncate(num_ims);
+    num_ims_ = num_ims;
+}
+
 bool Sample::operator==(const Sample &other) const
 {
     return (num_ims_ == other.num_ims_)
@@ -250,8 +260,21 @@ void load_sample(
 void save_data_record(
         const std::string &data_dir,
         unsigned data_idx,
-        const Data_record_20191031 &in)
+        const Data_record_20191031 &in,
+        bool binary)
 {
+    if(binary)
+    {
+        std::ofstream ar_f(
+                util::get_data_archive_path(
+                        data_dir,
+                        data_idx).string(),
+                std::ios_base::out | std::ios_base::trunc | std::ios_base::binary
+        );
+        boost::archive::binary_oarchive ar_far(ar_f);
+        ar_far << in;
+        return;
+    }
     std::ofstream ar_f(
             util::get_data_archive_path(
                     data_dir,
@@ -267,9 +290,21 @@ void load_data_record(
         unsigned data_idx,
         Data_record_20191031 &out)
 {
-    std::ifstream ar_file(util::get_data_archive_path(data_dir, data_idx).string());
-    boost::archive::text_iarchive ar(ar_file);
-    ar >> out;
+    std::ifstream ar_file(
+            util::get_data_archive_path(data_dir, data_idx).string(),
+            std::ios_base::in | std::ios_base::binary);
+    // A text archive starts with the decimal length of its signature, a binary
+    // one with the length itself.
+    if(std::isdigit(ar_file.peek()))
+    {
+        boost::archive::text_iarchive ar(ar_file);
+        ar >> out;
+    }
+    else
+    {
+        boost::archive::binary_iarchive ar(ar_file);
+        ar >> out;
+    }
 }
 
 void save_sample_vector(
@@ -351,7 +386,137 @@ void load_inference_record(
     ar_far >> out;
 }
 
-static std::string get_csv_attr(
+void save_inference_record(
+        const std::string &data_dir,
+        unsigned data_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        const Inference_record_20261019 &in)
+{
+    std::ofstream ar_file(
+            util::get_inference_archive_path(
+                    data_dir,
+                    data_idx,
+                    it,
+                    flex_vars).string(),
+            std::ios_base::out | std::ios_base::trunc
+    );
+    boost::archive::text_oarchive ar_far(ar_file);
+    ar_far << in;
+}
+
+void load_inference_record(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        Inference_record_20261019 &out)
+{
+    std::string p = util::get_inference_archive_path(
+                data_dir,
+                dataset_idx,
+                it,
+                flex_vars).string();
+    std::ifstream ar_file(
+            p,
+            std::ios_base::in
+    );
+    boost::archive::text_iarchive ar_far(ar_file);
+    ar_far >> out;
+}
+
+void load_inference_chain(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        unsigned archive_ver,
+        Inference_record_20261019 &out)
+{
+    if(archive_ver >= 20261019)
+    {
+        load_inference_record(data_dir, dataset_idx, it, flex_vars, out);
+    }
+    else if(archive_ver >= 20191031)
+    {
+        Inference_record_20191031 ir;
+        load_inference_record(data_dir, dataset_idx, it, flex_vars, ir);
+        out = Inference_record_20261019(ir);
+    }
+    else
+    {
+        Inference_record_20191031 ir;
+        load_sample_vector(data_dir, dataset_idx, it, flex_vars, ir.samples_);
+        ir.rng_seed_ = 0;
+        out = Inference_record_20261019(ir);
+    }
+}
+
+void load_inference_chains(
+        util::Thread_pool &pool,
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<std::vector<unsigned>> &flex_vars,
+        unsigned archive_ver,
+        std::vector<Inference_record_20261019> &out)
+{
+    out.clear();
+    out.resize(flex_vars.size());
+    pool.parallel_for(flex_vars.size(), [&](size_t i)
+    {
+        load_inference_chain(data_dir, dataset_idx, it, flex_vars[i], archive_ver, out[i]);
+    });
+}
+
+Inference_record_20261019::Inference_record_20261019(const Inference_record_20191031 &old) :
+        rng_seed_(old.rng_seed_)
+{
+    // boost tracks pointers, so the repeated entries of a rejected move come
+    // back from the archive as the same pointer.
+    for(Sample *s : old.samples_)
+    {
+        push_back(s);
+    }
+}
+
+void Inference_record_20261019::push_back(Sample *s)
+{
+    if(!runs_.empty() && runs_.back().sample_ == s)
+    {
+        runs_.back().count_++;
+    }
+    else
+    {
+        runs_.push_back(Sample_run(s, 1));
+    }
+}
+
+size_t Inference_record_20261019::get_num_iterations() const
+{
+    size_t r = 0;
+    for(const Sample_run &run : runs_)
+    {
+        r += run.count_;
+    }
+    return r;
+}
+
+Sample *Inference_record_20261019::get_sample_at_iteration(size_t iteration) const
+{
+    for(const Sample_run &run : runs_)
+    {
+        if(iteration < run.count_)
+        {
+            return run.sample_;
+        }
+        iteration -= run.count_;
+    }
+    throw util::Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
+}
+
+static void write_csv_attr(
+        util::Csv_writer &f,
         util::Csv_record_attrs cra,
         unsigned row_num,
         const block_2d::Sample &s,
@@ -362,40 +527,40 @@ static std::string get_csv_attr(
     switch(cra)
     {
     case util::CRA_ROW_NUM:
-        return std::to_string(row_num);
+        f.write(row_num);
         break;
     case util::CRA_CAM_TOP:
-        return std::to_string(s.get_camera().get_camera_top());
+        f.write(s.get_camera().get_camera_top());
         break;
     case util::CRA_INIT_X_POS:
-        return std::to_string(s.get_initial_block_rvs().get_initial_x());
+        f.write(s.get_initial_block_rvs().get_initial_x());
         break;
     case util::CRA_INIT_Y_POS:
-        return std::to_string(s.get_initial_block_rvs().get_initial_y());
+        f.write(s.get_initial_block_rvs().get_initial_y());
         break;
     case util::CRA_INIT_WIDTH:
-        return std::to_string(s.get_initial_block_rvs().get_initial_width());
+        f.write(s.get_initial_block_rvs().get_initial_width());
         break;
     case util::CRA_INIT_HEIGHT:
-        return std::to_string(s.get_initial_block_rvs().get_initial_height());
+        f.write(s.get_initial_block_rvs().get_initial_height());
         break;
     case util::CRA_RIGHT_MOMENTUM:
-        return std::to_string(s.get_fracture_rvs().get_right_x_momentum());
+        f.write(s.get_fracture_rvs().get_right_x_momentum());
         break;
     case util::CRA_LEFT_ANGULAR_MOMENTUM:
-        return std::to_string(s.get_fracture_rvs().get_left_angular_momentum());
+        f.write(s.get_fracture_rvs().get_left_angular_momentum());
         break;
     case util::CRA_FRAC_LOC:
-        return std::to_string(s.get_fracture_rvs().get_fracture_location());
+        f.write(s.get_fracture_rvs().get_fracture_location());
         break;
     case util::CRA_LOG_PROB:
-        return std::to_string(log_prob);
+        f.write(log_prob);
         break;
     case util::CRA_ACCEPTED:
-        return std::to_string(accepted);
+        f.write(accepted);
         break;
     case util::CRA_FORWARD_SAMPLE_LOG_PROB:
-        return std::to_string(forward_sample_log_prob);
+        f.write(forward_sample_log_prob);
         break;
     default:
         throw util::Unhandled_enum_value_exception(); //util::err_str(__FILE__, __LINE__);
@@ -412,10 +577,7 @@ void save_csv(
         const std::vector<bool> &accepted,
         double forward_sample_log_prob)
 {
-    boost::filesystem::path p = util::get_csv_path(data_dir, data_idx, it, flex_vars);
-    std::ofstream f(p.string(), std::ios_base::out | std::ios_base::trunc);
-    util::write_csv_header(f);
-    f << "\n";
+    util::Csv_writer f(util::get_csv_path(data_dir, data_idx, it, flex_vars), util::get_csv_columns());
     for(unsigned i = 0; i < s.size(); i++)
     {
         write_csv_line(
@@ -429,50 +591,53 @@ void save_csv(
 }
 
 void write_csv_line(
-        std::ofstream & f,
+        util::Csv_writer &f,
         unsigned row_num,
         const block_2d::Sample &s,
         double log_prob,
         bool accepted,
         double forward_sample_log_prob)
 {
-    bool written = false;
     for(unsigned i = 0; i < util::CRA_COUNT; i++)
     {
         if(!util::RECORD_ATTRS_TO_WRITE[i])
         {
             continue;
         }
-        if(written)
-        {
-            f << ",";
-        }
-        f << "\"" << get_csv_attr(
-                 util::Csv_record_attrs(i),
-                 row_num,
-                 s,
-                 log_prob,
-                 accepted,
-                 forward_sample_log_prob) << "\"";
-        written = true;
+        write_csv_attr(
+                f,
+                util::Csv_record_attrs(i),
+                row_num,
+                s,
+                log_prob,
+                accepted,
+                forward_sample_log_prob);
     }
-    f << "\n";
+    f.end_row();
 }
 void cache_log_probs(
-        const std::vector<std::vector<Sample *>> &samples,
+        util::Thread_pool &pool,
+        const std::vector<Inference_record_20261019> &chains,
         std::vector<std::vector<double>> &log_probs)
 {
-    log_probs.clear();
-    log_probs.reserve(samples.size());
-    for(unsigned i = 0; i < samples.size(); i++)
+    // Flatten (chain, run) so that a single long chain is split across
+    // threads as well.
+    std::vector<size_t> chain_offsets;
+    chain_offsets.reserve(chains.size() + 1);
+    chain_offsets.push_back(0);
+    log_probs.assign(chains.size(), std::vector<double>());
+    for(size_t i = 0; i < chains.size(); i++)
     {
-        log_probs.push_back(std::vector<double>());
-        log_probs[i].reserve(samples[0].size());
-        for(unsigned j = 0; j < samples[0].size(); j++)
-        {
-            log_probs[i].push_back(samples[i][j]->log_prob());
-        }
+        log_probs[i].resize(chains[i].runs_.size());
+        chain_offsets.push_back(chain_offsets.back() + chains[i].runs_.size());
     }
+    pool.parallel_for(chain_offsets.back(), [&](size_t flat_idx)
+    {
+        size_t i = size_t(std::upper_bound(chain_offsets.begin(), chain_offsets.end(), flat_idx)
+                - chain_offsets.begin()) - 1;
+        size_t j = flat_idx - chain_offsets[i];
+        log_probs[i][j] = chains[i].runs_[j].sample_->log_prob();
+    }, 64);
 }
 
 }}
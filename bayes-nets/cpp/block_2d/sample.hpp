@@ -15,6 +15,8 @@
 #include "block.hpp"
 #include "block_geom.hpp"
 #include "hidden_state.hpp"
+#include "thread_pool.hpp"
+#include "csv_writer.hpp"
 
 namespace fracture { namespace block_2d {
 
@@ -120,8 +122,39 @@ public:
                 ;
     }
 
+    // The terms of log_prob, for inference that takes in one frame at a
+    // time: log_prob is log_prior plus log_likelihood of every frame.
+    double log_prior() const
+    {
+        return cam_.log_prob() + init_block_rvs_.log_prob() + frac_rvs_.log_prob();
+    }
+    // The observations of frame timestamp alone.
+    double log_likelihood(unsigned timestamp) const
+    {
+        if(timestamp == 0)
+        {
+            return parent_block_.get_state(timestamp).log_prob(cam_.get_image_noise_dist());
+        }
+        return left_block_.get_state(timestamp).log_prob(cam_.get_image_noise_dist())
+                + right_block_.get_state(timestamp).log_prob(cam_.get_image_noise_dist());
+    }
+
     void recalculate_values();
 
+    // For observations that arrive a frame at a time. extend takes in the
+    // frames data has past this sample's last one: the fragments are only
+    // simulated over the new frames, with this sample's own camera, and
+    // their observations come from data. Only data's observations are read,
+    // so its camera and hidden rvs don't matter. It has to be the same
+    // sequence of observations with frames appended: its frames before
+    // get_num_ims() are taken to be the ones already here, which isn't
+    // checked. Throws if data has fewer frames than this sample.
+    //
+    // truncate drops the frames from num_ims on, so that extending back to
+    // the original gives the original.
+    void extend(const Sample & data);
+    void truncate(unsigned num_ims);
+
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
     {
@@ -153,8 +186,6 @@ private:
     Block right_block_;
 };
 
-std::tuple<std::shared_ptr<Sample>, double, unsigned> aggregate_samples(const std::vector<std::tuple<std::shared_ptr<Sample>, double, unsigned>> & vec, size_t first, size_t last);
-
 
 class Data_record_20191031
 {
@@ -184,6 +215,55 @@ public:
     std::vector<Sample *> samples_;
 };
 
+// A run of consecutive chain iterations that stayed on the same sample. The
+// first iteration of a run is the one that accepted the sample (or the
+// initial sample of the chain), and the remaining count_ - 1 iterations are
+// rejections.
+class Sample_run
+{
+    friend class boost::serialization::access;
+public:
+    Sample_run() : sample_(nullptr), count_(0) {}
+    Sample_run(Sample *sample, unsigned count) : sample_(sample), count_(count) {}
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & sample_ & count_;
+    }
+
+    Sample *sample_;
+    unsigned count_;
+};
+
+// Run-length encoded chain. Storage and load time scale with the number of
+// accepted moves rather than the number of iterations.
+class Inference_record_20261019
+{
+    friend class boost::serialization::access;
+public:
+    Inference_record_20261019() : rng_seed_(0) {}
+    // Collapses consecutive duplicate pointers of the older format into runs.
+    explicit Inference_record_20261019(const Inference_record_20191031 &old);
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & rng_seed_ & runs_;
+    }
+
+    // Appends one iteration. Pushing the same pointer as the last iteration
+    // (a rejected move) only increments the last run's count.
+    void push_back(Sample *s);
+    size_t get_num_iterations() const;
+    // The sample the chain was on at the given iteration. Linear in the
+    // number of runs.
+    Sample *get_sample_at_iteration(size_t iteration) const;
+
+    unsigned rng_seed_;
+    std::vector<Sample_run> runs_;
+};
+
 void save_sample(
         const std::string &data_dir,
         unsigned data_idx,
@@ -195,7 +275,11 @@ void load_sample(
 void save_data_record(
         const std::string &data_dir,
         unsigned data_idx,
-        const Data_record_20191031 &in);
+        const Data_record_20191031 &in,
+        // boost's binary archive: smaller and faster than text, but only
+        // readable on machines with the same type sizes and byte order.
+        // load_data_record reads either kind.
+        bool binary = false);
 void load_data_record(
         const std::string &data_dir,
         unsigned data_idx,
@@ -224,6 +308,44 @@ void load_inference_record(
         util::Inference_type it,
         const std::vector<unsigned> &flex_vars,
         Inference_record_20191031 &out);
+void save_inference_record(
+        const std::string &data_dir,
+        unsigned data_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        const Inference_record_20261019 &in);
+void load_inference_record(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        Inference_record_20261019 &out);
+// Loads an inference archive of any version (see
+// cfg::Arguments_aggregator::inference_archive_ver_) as a run-length encoded
+// chain.
+void load_inference_chain(
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<unsigned> &flex_vars,
+        unsigned archive_ver,
+        Inference_record_20261019 &out);
+// Loads one chain per entry of flex_vars concurrently on the pool. out[i]
+// is the chain for flex_vars[i].
+void load_inference_chains(
+        util::Thread_pool &pool,
+        const std::string &data_dir,
+        unsigned dataset_idx,
+        util::Inference_type it,
+        const std::vector<std::vector<unsigned>> &flex_vars,
+        unsigned archive_ver,
+        std::vector<Inference_record_20261019> &out);
+// log_probs[i][j] is the log probability of run j of chain i. Computed
+// concurrently on the pool.
+void cache_log_probs(
+        util::Thread_pool &pool,
+        const std::vector<Inference_record_20261019> &chains,
+        std::vector<std::vector<double>> &log_probs);
 
 // TODO these are related to inference results, and should probably be
 // put somewhere else. Sample really should be agnostic to inference.
@@ -238,7 +360,7 @@ void save_csv(
         double forward_sample_log_prob);
 
 void write_csv_line(
-        std::ofstream &f,
+        util::Csv_writer &f,
         unsigned row_num,
         const block_2d::Sample &s,
         double log_prob,
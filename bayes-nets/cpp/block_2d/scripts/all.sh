@@ -1,6 +1,10 @@
 #!/bin/bash
 
-scripts/data_gen.sh
-scripts/inf_mh.sh
+# Generation, MH inference and the chain comparison csvs, all in one process.
+# The grid is in scripts/experiment.cfg. data_gen.sh, inf_mh.sh and
+# csv_chain.sh still run one stage at a time.
+
+source scripts/shared.sh
+
+./driver_experiment -x scripts/experiment.cfg -d $DATA_FOLDER -j $NUM_JOBS
 #scripts/aggregate.sh
-scripts/csv_chain.sh
@@ -0,0 +1,417 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <fstream>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include <prob_cpp/prob_distribution.h>
+
+#include "smc.hpp"
+#include "metropolis_hastings.hpp"
+#include "prob.hpp"
+
+namespace fracture { namespace block_2d {
+
+void save_smc_record(
+        const std::string &data_dir,
+        unsigned data_idx,
+        const std::vector<unsigned> &flex_vars,
+        const Smc_record &in)
+{
+    std::ofstream ar_file(
+            util::get_inference_archive_path(
+                    data_dir,
+                    data_idx,
+                    util::IT_SMC,
+                    flex_vars).string(),
+            std::ios_base::out | std::ios_base::trunc
+    );
+    boost::archive::text_oarchive ar_far(ar_file);
+    ar_far << in;
+}
+
+void load_smc_record(
+        const std::string &data_dir,
+        unsigned data_idx,
+        const std::vector<unsigned> &flex_vars,
+        Smc_record &out)
+{
+    std::ifstream ar_file(
+            util::get_inference_archive_path(
+                    data_dir,
+                    data_idx,
+                    util::IT_SMC,
+                    flex_vars).string()
+    );
+    boost::archive::text_iarchive ar_far(ar_file);
+    ar_far >> out;
+}
+
+double get_tempered_ess(
+        const std::vector<double> & log_weights,
+        const std::vector<double> & log_likelihoods,
+        double step)
+{
+    double max_log = -std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < log_weights.size(); i++)
+    {
+        max_log = std::max(max_log, log_weights[i] + step * log_likelihoods[i]);
+    }
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for(size_t i = 0; i < log_weights.size(); i++)
+    {
+        double w = std::exp(log_weights[i] + step * log_likelihoods[i] - max_log);
+        sum += w;
+        sum_sq += w * w;
+    }
+    return sum * sum / sum_sq;
+}
+
+double get_tempering_step(
+        const std::vector<double> & log_weights,
+        const std::vector<double> & log_likelihoods,
+        double max_step,
+        double target_ess)
+{
+    // Any positive step takes the particles without likelihood out, so
+    // max_step tells whether some are left.
+    double max_log = -std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < log_weights.size(); i++)
+    {
+        max_log = std::max(max_log, log_weights[i] + max_step * log_likelihoods[i]);
+    }
+    if(max_log == -std::numeric_limits<double>::infinity()) throw prob::No_support_exception(); //util::err_str(__FILE__, __LINE__);
+
+    if(get_tempered_ess(log_weights, log_likelihoods, max_step) >= target_ess) return max_step;
+    // Bisect for the step that brings the ess down to the target.
+    double lo = 0.0;
+    double hi = max_step;
+    for(unsigned i = 0; i < 50; i++)
+    {
+        double mid = 0.5 * (lo + hi);
+        if(get_tempered_ess(log_weights, log_likelihoods, mid) >= target_ess) lo = mid;
+        else hi = mid;
+    }
+    return std::max(lo, std::min(MIN_TEMPERING_STEP, max_step));
+}
+
+Smc_sampler::Smc_sampler(
+        unsigned rng_seed,
+        unsigned num_particles,
+        const Sample & data,
+        unsigned num_moves,
+        double ess_threshold,
+        util::Thread_pool & pool) :
+    rng_seed_(rng_seed),
+    num_frames_(data.get_num_ims()),
+    num_moves_(num_moves),
+    ess_threshold_(ess_threshold),
+    pool_(pool),
+    cur_frame_(0),
+    particles_(num_particles),
+    log_weights_(num_particles, -std::log(double(num_particles))),
+    log_targets_(num_particles),
+    log_evidence_(0.0),
+    num_steps_(0),
+    num_resamples_(0),
+    num_moves_proposed_(0),
+    num_moves_accepted_(0)
+{
+    if(num_particles == 0) throw util::Index_oob_exception();
+    pool_.parallel_for(num_particles, [&](size_t i)
+    {
+        prob::seed_sampling_rand(get_seed(0, unsigned(i)));
+        particles_[i] = get_mh_initial_sample(data);
+        log_targets_[i] = particles_[i].log_prior();
+    });
+}
+
+Smc_sampler::Smc_sampler(
+        const Smc_record & record,
+        const Sample & data,
+        unsigned num_moves,
+        double ess_threshold,
+        util::Thread_pool & pool) :
+    rng_seed_(record.rng_seed_),
+    num_frames_(record.cur_frame_),
+    num_moves_(num_moves),
+    ess_threshold_(ess_threshold),
+    pool_(pool),
+    cur_frame_(record.cur_frame_),
+    particles_(record.particles_),
+    log_weights_(record.log_weights_),
+    log_targets_(record.log_targets_),
+    log_evidence_(record.log_evidence_),
+    ess_(record.ess_),
+    num_steps_(record.num_steps_),
+    num_resamples_(0),
+    num_moves_proposed_(0),
+    num_moves_accepted_(0)
+{
+    if(particles_.empty()) throw util::Index_oob_exception();
+    extend(data);
+}
+
+void Smc_sampler::extend(const Sample & data)
+{
+    if(data.get_num_ims() < num_frames_) throw util::Index_oob_exception();
+    pool_.parallel_for(particles_.size(), [&](size_t i)
+    {
+        particles_[i].extend(data);
+    });
+    num_frames_ = data.get_num_ims();
+}
+
+void Smc_sampler::assimilate_once()
+{
+    if(!still_assimilating()) throw util::Index_oob_exception();
+    size_t n = particles_.size();
+    std::vector<double> log_likelihoods(n);
+    unsigned frame = cur_frame_;
+    pool_.parallel_for(n, [&](size_t i)
+    {
+        log_likelihoods[i] = particles_[i].log_likelihood(frame);
+        // A likelihood that can't be evaluated gives the particle no support.
+        if(std::isnan(log_likelihoods[i])) log_likelihoods[i] = -std::numeric_limits<double>::infinity();
+    });
+
+    double temperature = 0.0;
+    while(temperature < 1.0)
+    {
+        double next = get_next_temperature(log_likelihoods, temperature);
+        reweight(log_likelihoods, next - temperature);
+        temperature = next;
+        if(temperature < 1.0)
+        {
+            // The step was chosen to bring the ess down to the threshold.
+            rejuvenate(temperature, log_likelihoods);
+        }
+    }
+    ess_.push_back(get_ess());
+    if(ess_.back() < ess_threshold_ * double(n))
+    {
+        rejuvenate(1.0, log_likelihoods);
+    }
+    cur_frame_++;
+}
+
+double Smc_sampler::get_ess() const
+{
+    double sum_sq = 0.0;
+    for(double lw : log_weights_)
+    {
+        sum_sq += std::exp(2.0 * lw);
+    }
+    return 1.0 / sum_sq;
+}
+
+double Smc_sampler::get_acceptance_rate() const
+{
+    return num_moves_proposed_ ? double(num_moves_accepted_) / double(num_moves_proposed_) : 0.0;
+}
+
+std::vector<double> Smc_sampler::get_posterior_means() const
+{
+    std::vector<double> r(RI_COUNT, 0.0);
+    for(size_t i = 0; i < particles_.size(); i++)
+    {
+        double w = std::exp(log_weights_[i]);
+        for(size_t k = 0; k < RI_COUNT; k++)
+        {
+            r[k] += w * sva_.get(&particles_[i], k);
+        }
+    }
+    return r;
+}
+
+std::vector<double> Smc_sampler::get_posterior_stds() const
+{
+    std::vector<double> means = get_posterior_means();
+    std::vector<double> r(RI_COUNT, 0.0);
+    for(size_t i = 0; i < particles_.size(); i++)
+    {
+        double w = std::exp(log_weights_[i]);
+        for(size_t k = 0; k < RI_COUNT; k++)
+        {
+            double d = sva_.get(&particles_[i], k) - means[k];
+            r[k] += w * d * d;
+        }
+    }
+    for(double &v : r)
+    {
+        v = std::sqrt(v);
+    }
+    return r;
+}
+
+Smc_record Smc_sampler::get_record() const
+{
+    Smc_record r;
+    r.rng_seed_ = rng_seed_;
+    r.cur_frame_ = cur_frame_;
+    r.num_steps_ = num_steps_;
+    r.log_evidence_ = log_evidence_;
+    r.ess_ = ess_;
+    r.particles_ = particles_;
+    r.log_weights_ = log_weights_;
+    r.log_targets_ = log_targets_;
+    return r;
+}
+
+unsigned Smc_sampler::get_seed(unsigned step, unsigned particle_idx) const
+{
+    return prob::derive_seed(prob::derive_seed(rng_seed_, step), particle_idx);
+}
+
+double Smc_sampler::get_next_temperature(const std::vector<double> & log_likelihoods, double temperature) const
+{
+    double target = ess_threshold_ * double(log_likelihoods.size());
+    return temperature + get_tempering_step(log_weights_, log_likelihoods, 1.0 - temperature, target);
+}
+
+void Smc_sampler::reweight(const std::vector<double> & log_likelihoods, double d_temperature)
+{
+    // The evidence of the step is the weighted mean of the tempered
+    // likelihoods. Subtract the max before exponentiating.
+    size_t n = particles_.size();
+    double max_log = -std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < n; i++)
+    {
+        max_log = std::max(max_log, log_weights_[i] + d_temperature * log_likelihoods[i]);
+    }
+    double sum = 0.0;
+    for(size_t i = 0; i < n; i++)
+    {
+        sum += std::exp(log_weights_[i] + d_temperature * log_likelihoods[i] - max_log);
+    }
+    double log_step_evidence = max_log + std::log(sum);
+    log_evidence_ += log_step_evidence;
+    for(size_t i = 0; i < n; i++)
+    {
+        log_weights_[i] += d_temperature * log_likelihoods[i] - log_step_evidence;
+        log_targets_[i] += d_temperature * log_likelihoods[i];
+    }
+}
+
+void Smc_sampler::rejuvenate(double temperature, std::vector<double> & log_likelihoods)
+{
+    // Size the proposals before the resample throws away the spread. The
+    // weighted std of an rv all the particles agree on can still round to
+    // something above 0.
+    std::vector<double> stds = get_posterior_stds();
+    for(size_t k = 0; k < RI_COUNT; k++)
+    {
+        bool agree = true;
+        for(size_t i = 1; agree && i < particles_.size(); i++)
+        {
+            agree = sva_.get(&particles_[i], k) == sva_.get(&particles_[0], k);
+        }
+        if(agree) stds[k] = 0.0;
+    }
+    num_steps_++;
+    resample(log_likelihoods);
+    move_particles(stds, temperature, log_likelihoods);
+}
+
+void Smc_sampler::resample(std::vector<double> & log_likelihoods)
+{
+    size_t n = particles_.size();
+    // One uniform offset for the whole comb. It gets a seed of its own, past
+    // the particles' ones.
+    double u = (double(get_seed(num_steps_, unsigned(n))) + 0.5) / 4294967296.0;
+    std::vector<Sample> resampled;
+    std::vector<double> log_targets;
+    std::vector<double> resampled_log_likelihoods;
+    resampled.reserve(n);
+    log_targets.reserve(n);
+    resampled_log_likelihoods.reserve(n);
+    double cumulative = std::exp(log_weights_[0]);
+    size_t src = 0;
+    for(size_t i = 0; i < n; i++)
+    {
+        double tooth = (double(i) + u) / double(n);
+        while(tooth > cumulative && src + 1 < n)
+        {
+            src++;
+            cumulative += std::exp(log_weights_[src]);
+        }
+        resampled.push_back(particles_[src]);
+        log_targets.push_back(log_targets_[src]);
+        resampled_log_likelihoods.push_back(log_likelihoods[src]);
+    }
+    particles_.swap(resampled);
+    log_targets_.swap(log_targets);
+    log_likelihoods.swap(resampled_log_likelihoods);
+    std::fill(log_weights_.begin(), log_weights_.end(), -std::log(double(n)));
+    num_resamples_++;
+}
+
+void Smc_sampler::move_particles(
+        const std::vector<double> & stds,
+        double temperature,
+        std::vector<double> & log_likelihoods)
+{
+    size_t n = particles_.size();
+    // Random walk proposals on the rvs that vary across the population, each
+    // with a std in proportion to its spread. The rvs the initial samples
+    // clamp (see get_mh_initial_sample) have none and are left alone.
+    std::vector<size_t> free_rvs;
+    for(size_t k = 0; k < RI_COUNT; k++)
+    {
+        if(stds[k] > 0.0) free_rvs.push_back(k);
+    }
+    if(free_rvs.empty()) return;
+    // The usual scaling for random walk Metropolis in d dimensions.
+    double scale = 2.38 / std::sqrt(double(free_rvs.size()));
+
+    std::vector<unsigned> num_accepted(n, 0);
+    unsigned frame = cur_frame_;
+    unsigned step = num_steps_;
+    pool_.parallel_for(n, [&](size_t i)
+    {
+        static const kjb::Uniform_distribution ACCEPTANCE_TEST;
+        prob::seed_sampling_rand(get_seed(step, unsigned(i)));
+        for(unsigned m = 0; m < num_moves_; m++)
+        {
+            Sample proposal(particles_[i]);
+            double log_uniform = std::log(prob::sample(ACCEPTANCE_TEST));
+            double new_log_target;
+            double new_log_likelihood;
+            try
+            {
+                for(size_t k : free_rvs)
+                {
+                    sva_.set(&proposal, k, sva_.get(&proposal, k) + prob::sample(kjb::Normal_distribution(0.0, scale * stds[k])));
+                }
+                new_log_target = proposal.log_prior();
+                for(unsigned t = 0; t < frame; t++)
+                {
+                    new_log_target += proposal.log_likelihood(t);
+                }
+                new_log_likelihood = proposal.log_likelihood(frame);
+                new_log_target += temperature * new_log_likelihood;
+            }
+            catch(const prob::No_support_exception &e)
+            {
+                continue;
+            }
+            if(new_log_target > log_targets_[i] || log_uniform < new_log_target - log_targets_[i])
+            {
+                particles_[i] = proposal;
+                log_targets_[i] = new_log_target;
+                log_likelihoods[i] = new_log_likelihood;
+                num_accepted[i]++;
+            }
+        }
+    });
+    num_moves_proposed_ += unsigned(n) * num_moves_;
+    for(unsigned a : num_accepted)
+    {
+        num_moves_accepted_ += a;
+    }
+}
+
+}}
@@ -0,0 +1,202 @@
+#ifndef SMC_HPP
+#define SMC_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "sample.hpp"
+#include "sample_vector_adapter.hpp"
+#include "thread_pool.hpp"
+
+namespace fracture
+{
+namespace block_2d
+{
+
+// What an SMC run leaves behind: the final particle population, with its
+// weights, and the estimate of the evidence. Enough to resume the run once
+// more frames come in.
+class Smc_record
+{
+    friend class boost::serialization::access;
+public:
+    Smc_record() : rng_seed_(0), cur_frame_(0), num_steps_(0), log_evidence_(0.0) {}
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & rng_seed_ & cur_frame_ & num_steps_ & log_evidence_ & ess_ & particles_ & log_weights_ & log_targets_;
+    }
+
+    unsigned rng_seed_;
+    unsigned cur_frame_;
+    unsigned num_steps_;
+    // An estimate of log p(observations), with the hidden rvs integrated
+    // out over the prior. Unbiased in p rather than in log p.
+    double log_evidence_;
+    // ess_[t] is the effective sample size once frame t was weighted in,
+    // before any resampling.
+    std::vector<double> ess_;
+    std::vector<Sample> particles_;
+    // Normalized, so that they exp-sum to 1.
+    std::vector<double> log_weights_;
+    // Each particle's log prior plus the log likelihood of frames
+    // [0, cur_frame_).
+    std::vector<double> log_targets_;
+};
+
+void save_smc_record(
+        const std::string &data_dir,
+        unsigned data_idx,
+        const std::vector<unsigned> &flex_vars,
+        const Smc_record &in);
+
+void load_smc_record(
+        const std::string &data_dir,
+        unsigned data_idx,
+        const std::vector<unsigned> &flex_vars,
+        Smc_record &out);
+
+// Below this, tempering a frame that leaves too few particles any likelihood
+// at all would never finish.
+const double MIN_TEMPERING_STEP = 1e-6;
+
+// The effective sample size of the weights log_weights + step *
+// log_likelihoods, which need not be normalized.
+double get_tempered_ess(
+        const std::vector<double> & log_weights,
+        const std::vector<double> & log_likelihoods,
+        double step);
+
+// The largest step up to max_step that keeps the tempered effective sample
+// size at target_ess or above. It is never below MIN_TEMPERING_STEP, unless
+// max_step is: when too few particles have any likelihood, no step keeps the
+// ess up, and the resample after the smallest one drops the rest. Throws
+// prob::No_support_exception when no weighted particle has any likelihood.
+double get_tempering_step(
+        const std::vector<double> & log_weights,
+        const std::vector<double> & log_likelihoods,
+        double max_step,
+        double target_ess);
+
+// Sequential Monte Carlo over the frames of one dataset. The hidden rvs are
+// all drawn at frame 0 and the rest of the sequence is deterministic, so the
+// particles are whole Samples, and frame t moves the population from the
+// posterior given frames [0, t) to the posterior given frames [0, t]: each
+// particle is weighted by the likelihood of frame t alone. One frame can be
+// enough to collapse the population onto a single particle, so its
+// likelihood is raised to a temperature that climbs from 0 to 1, with every
+// step as large as the effective sample size allows. After every step, the
+// population is resampled and every particle is rejuvenated with a few
+// Metropolis-Hastings moves targeting the tempered posterior, with proposal
+// stds scaled to the spread of the population.
+//
+// Particles are weighted and moved on the pool. Every particle draws from a
+// stream seeded with prob::derive_seed of rng_seed, the step and its index, so
+// a run is reproducible whatever the number of threads.
+class Smc_sampler
+{
+public:
+    // The particles are drawn as get_mh_initial_sample(data) draws them.
+    // A resample happens when the effective sample size drops below
+    // ess_threshold * num_particles.
+    Smc_sampler(
+            unsigned rng_seed,
+            unsigned num_particles,
+            const Sample & data,
+            unsigned num_moves,
+            double ess_threshold,
+            util::Thread_pool & pool);
+    // Resumes the run record was taken from, with the frames data has past
+    // the particles' extended onto them.
+    Smc_sampler(
+            const Smc_record & record,
+            const Sample & data,
+            unsigned num_moves,
+            double ess_threshold,
+            util::Thread_pool & pool);
+
+    // Takes in the frames data has past the particles' last one, as
+    // Sample::extend does. Only the new frames are simulated, and
+    // assimilating picks up where it left off.
+    void extend(const Sample & data);
+
+    unsigned get_num_frames() const { return num_frames_; }
+    // How many frames have been weighted in.
+    unsigned get_cur_frame() const { return cur_frame_; }
+    bool still_assimilating() const { return cur_frame_ < num_frames_; }
+
+    // Weighs in the next frame. Its likelihood is tempered in over as many
+    // steps as it takes to keep the effective sample size at the threshold,
+    // and the particles are resampled and moved after each of them. Throws
+    // prob::No_support_exception, with nothing weighted in, when no particle
+    // gives the frame any likelihood.
+    void assimilate_once();
+    void assimilate_all()
+    {
+        while(still_assimilating()) assimilate_once();
+    }
+
+    const std::vector<Sample> & get_particles() const { return particles_; }
+    const std::vector<double> & get_log_weights() const { return log_weights_; }
+    double get_log_evidence() const { return log_evidence_; }
+    double get_ess() const;
+    // Tempering steps, over all frames.
+    unsigned get_num_steps() const { return num_steps_; }
+    unsigned get_num_resamples() const { return num_resamples_; }
+    double get_acceptance_rate() const;
+
+    // The weighted mean and std of every hidden rv, indexed by Rvs_idx.
+    std::vector<double> get_posterior_means() const;
+    std::vector<double> get_posterior_stds() const;
+
+    Smc_record get_record() const;
+private:
+    // The seed of particle_idx's stream during step. Step 0 draws the
+    // particles, and every later one resamples and moves them.
+    unsigned get_seed(unsigned step, unsigned particle_idx) const;
+    // The highest temperature up to 1 that keeps the ess at the threshold,
+    // as get_tempering_step finds it.
+    double get_next_temperature(const std::vector<double> & log_likelihoods, double temperature) const;
+    // Weighs in the current frame's likelihoods at d_temperature more, and
+    // adds the normalizer to the evidence.
+    void reweight(const std::vector<double> & log_likelihoods, double d_temperature);
+    // Resamples, then moves the particles on the posterior given the frames
+    // before the current one and the current one's at temperature. The
+    // current frame's likelihoods follow the particles.
+    void rejuvenate(double temperature, std::vector<double> & log_likelihoods);
+    // Systematic resampling.
+    void resample(std::vector<double> & log_likelihoods);
+    void move_particles(
+            const std::vector<double> & stds,
+            double temperature,
+            std::vector<double> & log_likelihoods);
+
+    unsigned rng_seed_;
+    unsigned num_frames_;
+    unsigned num_moves_;
+    double ess_threshold_;
+    util::Thread_pool & pool_;
+    Sample_vector_adapter sva_;
+
+    unsigned cur_frame_;
+    std::vector<Sample> particles_;
+    std::vector<double> log_weights_;
+    // Each particle's log prior plus the log likelihood of the frames so
+    // far, which the moves target.
+    std::vector<double> log_targets_;
+    double log_evidence_;
+    std::vector<double> ess_;
+    unsigned num_steps_;
+    unsigned num_resamples_;
+    unsigned num_moves_proposed_;
+    unsigned num_moves_accepted_;
+};
+
+}
+}
+
+#endif // SMC_HPP
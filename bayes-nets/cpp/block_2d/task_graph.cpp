@@ -0,0 +1,180 @@
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+Task_graph::Task_id Task_graph::add_task(
+        const std::function<void()> &fn,
+        const std::vector<Task_id> &deps)
+{
+    Task_id r = tasks_.size();
+    for(Task_id dep : deps)
+    {
+        if(dep >= r) throw Index_oob_exception(); //util::err_str(__FILE__, __LINE__);
+    }
+    Task t;
+    t.fn_ = fn;
+    t.num_deps_ = unsigned(deps.size());
+    tasks_.push_back(t);
+    for(Task_id dep : deps)
+    {
+        tasks_[dep].dependents_.push_back(r);
+    }
+    return r;
+}
+
+namespace
+{
+
+struct Worker_queue
+{
+    std::mutex mutex_;
+    std::deque<Task_graph::Task_id> tasks_;
+};
+
+}
+
+void Task_graph::run(unsigned num_threads)
+{
+    if(tasks_.empty()) return;
+    if(!num_threads) num_threads = default_num_threads();
+
+    std::vector<std::unique_ptr<Worker_queue>> queues;
+    for(unsigned i = 0; i < num_threads; i++)
+    {
+        queues.push_back(std::unique_ptr<Worker_queue>(new Worker_queue()));
+    }
+    std::unique_ptr<std::atomic<unsigned>[]> num_deps_left(new std::atomic<unsigned>[tasks_.size()]);
+    for(size_t i = 0; i < tasks_.size(); i++)
+    {
+        num_deps_left[i] = tasks_[i].num_deps_;
+    }
+    std::atomic<size_t> num_unfinished(tasks_.size());
+
+    // Idle workers sleep on idle_cv until something is queued or everything is
+    // done. num_queued only goes up under idle_mutex, so no wake-up is lost.
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    std::atomic<size_t> num_queued(0);
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed(false);
+
+    auto push = [&](unsigned worker, Task_id id)
+    {
+        // Counted before it is visible, so that the count never drops below 0.
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            num_queued++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex_);
+            queues[worker]->tasks_.push_back(id);
+        }
+        idle_cv.notify_one();
+    };
+
+    auto try_pop = [&](unsigned worker, Task_id &id)
+    {
+        // own work first, newest first
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex_);
+            if(!queues[worker]->tasks_.empty())
+            {
+                id = queues[worker]->tasks_.back();
+                queues[worker]->tasks_.pop_back();
+                num_queued--;
+                return true;
+            }
+        }
+        // then steal, oldest first
+        for(unsigned i = 1; i < num_threads; i++)
+        {
+            Worker_queue &victim = *queues[(worker + i) % num_threads];
+            std::lock_guard<std::mutex> lock(victim.mutex_);
+            if(!victim.tasks_.empty())
+            {
+                id = victim.tasks_.front();
+                victim.tasks_.pop_front();
+                num_queued--;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto work = [&](unsigned worker)
+    {
+        while(true)
+        {
+            Task_id id;
+            if(!try_pop(worker, id))
+            {
+                std::unique_lock<std::mutex> lock(idle_mutex);
+                idle_cv.wait(lock, [&]() { return num_queued > 0 || num_unfinished == 0; });
+                if(num_unfinished == 0) return;
+                continue;
+            }
+            if(!failed)
+            {
+                try
+                {
+                    tasks_[id].fn_();
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if(!error) error = std::current_exception();
+                    failed = true;
+                }
+            }
+            for(Task_id dependent : tasks_[id].dependents_)
+            {
+                if(--num_deps_left[dependent] == 0) push(worker, dependent);
+            }
+            if(--num_unfinished == 0)
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                idle_cv.notify_all();
+            }
+        }
+    };
+
+    // Deal the initially ready tasks out round robin.
+    unsigned next_worker = 0;
+    for(Task_id id = 0; id < tasks_.size(); id++)
+    {
+        if(tasks_[id].num_deps_ == 0)
+        {
+            push(next_worker, id);
+            next_worker = (next_worker + 1) % num_threads;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < num_threads; i++)
+    {
+        threads.push_back(std::thread(work, i));
+    }
+    for(std::thread &t : threads)
+    {
+        t.join();
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+}
+}
@@ -0,0 +1,53 @@
+#ifndef TASK_GRAPH_HPP
+#define TASK_GRAPH_HPP
+
+#include <vector>
+#include <functional>
+
+namespace fracture
+{
+namespace util
+{
+
+// A set of tasks, each of which may depend on tasks added before it, so the
+// graph can't have cycles. run() executes every task once all of its
+// dependencies have finished.
+//
+// Scheduling is work stealing: every worker has its own deque of ready tasks.
+// A worker pops its newest task. When a task finishes, the dependents it makes
+// ready go onto its worker's own deque. A worker that runs out of tasks steals
+// the oldest one from another worker's deque. So the tasks that follow a task
+// tend to stay on its thread, and a slow task never holds back a whole stage.
+class Task_graph
+{
+public:
+    typedef size_t Task_id;
+
+    // deps must be ids returned by earlier calls.
+    Task_id add_task(
+            const std::function<void()> &fn,
+            const std::vector<Task_id> &deps = std::vector<Task_id>());
+
+    size_t size() const { return tasks_.size(); }
+
+    // Runs all tasks on num_threads workers (0 means one per hardware thread)
+    // and returns once they are done. If a task throws, the tasks not started
+    // yet are skipped, and the first exception is rethrown here once the
+    // running ones have finished.
+    void run(unsigned num_threads = 0);
+
+private:
+    struct Task
+    {
+        std::function<void()> fn_;
+        std::vector<Task_id> dependents_;
+        unsigned num_deps_;
+    };
+
+    std::vector<Task> tasks_;
+};
+
+}
+}
+
+#endif // TASK_GRAPH_HPP
@@ -0,0 +1,108 @@
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <boost/math/constants/constants.hpp>
+
+#include "aggregation.hpp"
+
+using namespace fracture;
+using namespace block_2d;
+
+// the fraction of values below x
+static double rank_of(const std::vector<double> &sorted, double x)
+{
+    return double(std::lower_bound(sorted.begin(), sorted.end(), x) - sorted.begin()) / double(sorted.size());
+}
+
+int main(int argc, char *argv[])
+{
+    const double median_rank_bound = boost::math::constants::pi<double>() / (2.0 * T_digest::COMPRESSION_DEF);
+
+    // the exact types, with repeated values
+    std::vector<double> values = {3.0, -1.0, 4.0, 1.0, 5.0};
+    for(unsigned at = 0; at < cfg::Arguments_aggregator::AT_COUNT; at++)
+    {
+        Accumulator whole = Accumulator(cfg::Arguments_aggregator::Aggregation_type(at));
+        for(size_t i = 0; i < values.size(); i++)
+        {
+            whole.add(values[i], unsigned(i + 1));
+        }
+        assert(whole.get_count() == 15);
+    }
+    Accumulator first(cfg::Arguments_aggregator::AT_FIRST);
+    Accumulator last(cfg::Arguments_aggregator::AT_LAST);
+    Accumulator max(cfg::Arguments_aggregator::AT_MAX);
+    Accumulator min(cfg::Arguments_aggregator::AT_MIN);
+    for(double v : values)
+    {
+        first.add(v);
+        last.add(v);
+        max.add(v);
+        min.add(v);
+    }
+    assert(first.get() == 3.0 && last.get() == 5.0 && max.get() == 5.0 && min.get() == -1.0);
+    Accumulator mean(cfg::Arguments_aggregator::AT_MEAN);
+    mean.add(1.0, 3);
+    mean.add(5.0);
+    assert(mean.get() == 2.0);
+    // -1 3 3 1 1 1 1 4 4 4 5 5 5 5 5
+    Accumulator median(cfg::Arguments_aggregator::AT_MEDIAN);
+    median.add(3.0, 2);
+    median.add(-1.0);
+    median.add(4.0, 3);
+    median.add(1.0, 4);
+    median.add(5.0, 5);
+    assert(median.get() == 4.0);
+
+    // a long run of one value stays that value
+    T_digest run;
+    run.add(2.0, 1e6);
+    run.add(1.0);
+    run.add(7.0, 10.0);
+    assert(run.quantile(0.5) == 2.0);
+    // as does a run of rejected -inf log probabilities
+    T_digest inf_run;
+    inf_run.add(-INFINITY, 1000.0);
+    inf_run.add(-INFINITY, 10.0);
+    inf_run.add(0.0);
+    assert(inf_run.quantile(0.5) == -INFINITY);
+
+    // continuous values
+    std::mt19937 gen(42);
+    std::normal_distribution<double> normal(-3.0, 2.0);
+    std::vector<double> stream(1000000);
+    T_digest whole;
+    for(size_t i = 0; i < stream.size(); i++)
+    {
+        stream[i] = normal(gen);
+        whole.add(stream[i]);
+    }
+    std::sort(stream.begin(), stream.end());
+    assert(whole.get_weight() == double(stream.size()));
+    assert(std::abs(rank_of(stream, whole.quantile(0.5)) - 0.5) <= median_rank_bound);
+    assert(whole.quantile(0.0) == stream.front() && whole.quantile(1.0) == stream.back());
+    // half a centroid, which is narrower in the tails
+    double tail_rank_bound = 2.0 * median_rank_bound * std::sqrt(0.01 * 0.99);
+    assert(std::abs(rank_of(stream, whole.quantile(0.01)) - 0.01) <= tail_rank_bound);
+
+    // bins of 4 over 2-11, every third index: 2 5 | 8 | 11
+    cfg::Arguments_aggregator::Possible_aggregation range(2, 11, cfg::Arguments_aggregator::AT_MEAN, 3, 4);
+    Range_binner bins(range);
+    assert(bins.get_num_bins() == 3);
+    Chain_index_entry e;
+    e.log_prob_ = 0.0;
+    std::fill(e.rvs_, e.rvs_ + RI_COUNT, 0.0);
+    e.first_iteration_ = 0;
+    e.count_ = 6;
+    assert(bins.add(e));
+    e.log_prob_ = 1.0;
+    e.first_iteration_ = 6;
+    e.count_ = 100;
+    assert(!bins.add(e));
+    assert(bins.get_bin(0).get_count() == 2 && bins.get_bin(0).get().log_prob_ == 0.0);
+    assert(bins.get_bin(1).get_count() == 1 && bins.get_bin(1).get().log_prob_ == 1.0);
+    assert(bins.get_bin(2).get_count() == 1 && bins.get_bin_start(2) == 10 && bins.get_bin_stop(2) == 11);
+}
@@ -4,6 +4,7 @@
 
 #include "config.hpp"
 #include "sample.hpp"
+#include "chain_index.hpp"
 
 int main(int argc, char *argv[])
 {
@@ -27,7 +28,7 @@ int main(int argc, char *argv[])
     for(size_t i = 0; i < num_samples; i++)
     {
         // Data archive
-        kjb::seed_sampling_rand(++cur_rng_seed);
+        prob::seed_sampling_rand(++cur_rng_seed);
         Data_record_20191031 data_record_out;
         data_record_out.rng_seed_ = cur_rng_seed;
         data_record_out.sample_ = Sample(args.num_ims_, args.im_w_, args.im_h_, args.cam_fps_);
@@ -37,6 +38,12 @@ int main(int argc, char *argv[])
         assert(data_record_out.rng_seed_ == data_record_in.rng_seed_);
         assert(data_record_out.sample_ == data_record_in.sample_);
         assert(data_record_out.sample_.log_prob() == data_record_in.sample_.log_prob());
+        // and as a binary archive
+        save_data_record(args.data_folder_, i, data_record_out, true);
+        Data_record_20191031 binary_record_in;
+        load_data_record(args.data_folder_, i, binary_record_in);
+        assert(data_record_out.rng_seed_ == binary_record_in.rng_seed_);
+        assert(data_record_out.sample_ == binary_record_in.sample_);
 
         Sample *s_ptr = new Sample(data_record_out.sample_);
         for(size_t j = 0; j < consecutive_samples; j++)
@@ -56,5 +63,56 @@ int main(int argc, char *argv[])
         assert(inference_record_out.samples_[i]->log_prob() == inference_record_in.samples_[i]->log_prob());
     }
 
+    // Run-length encoded inference archive, converted from the older format
+    Inference_record_20261019 rle_record_out(inference_record_out);
+    assert(rle_record_out.runs_.size() == num_samples);
+    assert(rle_record_out.get_num_iterations() == num_samples * consecutive_samples);
+    save_inference_record(args.data_folder_, 1, util::IT_METROPOLIS, flex_vars, rle_record_out);
+    Inference_record_20261019 rle_record_in;
+    load_inference_record(args.data_folder_, 1, util::IT_METROPOLIS, flex_vars, rle_record_in);
+    assert(rle_record_out.rng_seed_ == rle_record_in.rng_seed_);
+    assert(rle_record_out.runs_.size() == rle_record_in.runs_.size());
+    for(size_t i = 0; i < num_samples; i++)
+    {
+        assert(rle_record_out.runs_[i].count_ == rle_record_in.runs_[i].count_);
+        assert(*rle_record_out.runs_[i].sample_ == *rle_record_in.runs_[i].sample_);
+    }
+    for(size_t i = 0; i < num_samples * consecutive_samples; i++)
+    {
+        assert(*rle_record_in.get_sample_at_iteration(i) == *inference_record_out.samples_[i]);
+    }
+
+    // Older archives load as runs as well
+    Inference_record_20261019 converted_in;
+    load_inference_chain(args.data_folder_, 0, util::IT_METROPOLIS, flex_vars, 20191031, converted_in);
+    assert(converted_in.runs_.size() == num_samples);
+    assert(converted_in.get_num_iterations() == num_samples * consecutive_samples);
+
+    // Metrics sidecar
+    std::vector<double> log_probs;
+    for(const Sample_run &run : rle_record_out.runs_)
+    {
+        log_probs.push_back(run.sample_->log_prob());
+    }
+    Chain_index index_out(rle_record_out, log_probs);
+    save_chain_index(args.data_folder_, 1, util::IT_METROPOLIS, flex_vars, index_out);
+    assert(has_chain_index(args.data_folder_, 1, util::IT_METROPOLIS, flex_vars));
+    Chain_index index_in;
+    index_in.load(util::get_inference_index_path(args.data_folder_, 1, util::IT_METROPOLIS, flex_vars));
+    assert(index_in.rng_seed_ == index_out.rng_seed_);
+    assert(index_in.get_num_iterations() == num_samples * consecutive_samples);
+    assert(index_in.entries_.size() == num_samples);
+    for(size_t i = 0; i < num_samples; i++)
+    {
+        assert(index_in.entries_[i].first_iteration_ == i * consecutive_samples);
+        assert(index_in.entries_[i].count_ == consecutive_samples);
+        assert(index_in.entries_[i].accepted_ == (i != 0));
+        assert(index_in.entries_[i].log_prob_ == log_probs[i]);
+        for(size_t j = 0; j < RI_COUNT; j++)
+        {
+            assert(index_in.entries_[i].rvs_[j] == index_out.entries_[i].rvs_[j]);
+        }
+    }
+
     return 0;
 }
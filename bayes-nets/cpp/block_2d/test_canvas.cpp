@@ -0,0 +1,82 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "canvas.hpp"
+#include "config.hpp"
+
+int main(int argc, char *argv[])
+{
+    using namespace fracture;
+
+    unsigned im_w = 40;
+    unsigned im_h = 30;
+    util::Canvas im(im_w, im_h, cfg::COLOR_BACKGROUND);
+    assert(im.get_num_colors() == 1);
+
+    // one pixel per step along the longer axis, endpoints included, and no
+    // gaps along the shorter one
+    im.draw_line_segment(2, 3, 12, 23, cfg::COLOR_FOREGROUND);
+    assert(im.get_num_colors() == 2);
+    assert(im(2, 3) == 1 && im(12, 23) == 1);
+    unsigned line_ct = 0;
+    for(unsigned row = 0; row < im_h; row++)
+    {
+        unsigned row_ct = 0;
+        for(unsigned col = 0; col < im_w; col++)
+        {
+            if(im(row, col)) row_ct++;
+        }
+        assert((row >= 2 && row <= 12) == (row_ct > 0));
+        line_ct += row_ct;
+    }
+    assert(line_ct == 21);
+
+    // drawing with the same color again reuses its palette entry
+    im.clear();
+    im.draw_line_segment(0, 0, 0, int(im_w) - 1, cfg::COLOR_FOREGROUND);
+    im.draw_point(10.4, 10.6, 1, cfg::COLOR_INFERENCE_POLYGONS);
+    assert(im.get_num_colors() == 3);
+    for(unsigned col = 0; col < im_w; col++) assert(im(0, col) == 1);
+    unsigned point_ct = 0;
+    for(unsigned row = 0; row < im_h; row++)
+    {
+        for(unsigned col = 0; col < im_w; col++)
+        {
+            if(im(row, col) == 2)
+            {
+                assert(row >= 9 && row <= 11 && col >= 10 && col <= 12);
+                point_ct++;
+            }
+        }
+    }
+    assert(point_ct == 9);
+
+    // clipped, including lines that leave and come back
+    im.clear();
+    im.draw_line_segment(-1000000, -5, -1000000, 1000000, cfg::COLOR_FOREGROUND);
+    im.draw_line_segment(-10, 5, 40, 5, cfg::COLOR_FOREGROUND);
+    im.draw_point(-1.0, -1.0, 1, cfg::COLOR_FOREGROUND);
+    for(unsigned row = 0; row < im_h; row++) assert(im(row, 5) == 1);
+    assert(im(0, 0) == 1 && im(1, 1) == 0);
+
+    // an 8-bit palette TIFF with the pixels as its last strip
+    const char *path = "./test_canvas_tmp.tiff";
+    im.write(path);
+    std::ifstream f(path, std::ios_base::binary);
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    f.close();
+    std::remove(path);
+    assert(bytes[0] == 'I' && bytes[1] == 'I' && bytes[2] == 42 && bytes[3] == 0);
+    size_t pixels_offset = bytes.size() - size_t(im_w) * im_h;
+    for(unsigned row = 0; row < im_h; row++)
+    {
+        for(unsigned col = 0; col < im_w; col++)
+        {
+            assert(bytes[pixels_offset + size_t(row) * im_w + col] == im(row, col));
+        }
+    }
+}
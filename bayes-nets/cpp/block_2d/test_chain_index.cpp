@@ -0,0 +1,160 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "chain_index.hpp"
+
+using namespace fracture;
+using namespace block_2d;
+
+static bool same_bits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool same_entry(const Chain_index_entry &a, const Chain_index_entry &b)
+{
+    if(a.first_iteration_ != b.first_iteration_ || a.count_ != b.count_ || a.accepted_ != b.accepted_) return false;
+    if(!same_bits(a.log_prob_, b.log_prob_)) return false;
+    for(size_t i = 0; i < RI_COUNT; i++)
+    {
+        if(!same_bits(a.rvs_[i], b.rvs_[i])) return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // an MH-like chain: each accepted move nudges one latent
+    std::mt19937 gen(3);
+    std::geometric_distribution<unsigned> run_length(0.3);
+    std::uniform_int_distribution<size_t> rv(0, RI_COUNT - 1);
+    std::normal_distribution<double> step(0.0, 0.01);
+    Chain_index index;
+    index.rng_seed_ = 12345;
+    Chain_index_entry e;
+    e.first_iteration_ = 0;
+    e.accepted_ = false;
+    e.log_prob_ = -1000.0;
+    for(size_t i = 0; i < RI_COUNT; i++)
+    {
+        e.rvs_[i] = 1.0 + double(i);
+    }
+    for(size_t i = 0; i < 3 * Chain_index::BLOCK_SIZE + 17; i++)
+    {
+        e.count_ = run_length(gen) + 1;
+        e.rvs_[rv(gen)] += step(gen);
+        e.log_prob_ += std::abs(step(gen));
+        index.entries_.push_back(e);
+        e.first_iteration_ += e.count_;
+        e.accepted_ = true;
+    }
+    // values that have to come back bit for bit
+    index.entries_[5].log_prob_ = -std::numeric_limits<double>::infinity();
+    index.entries_[6].log_prob_ = std::numeric_limits<double>::quiet_NaN();
+    index.entries_[7].rvs_[0] = -0.0;
+    index.entries_[8].rvs_[0] = std::numeric_limits<double>::denorm_min();
+    index.entries_[9].accepted_ = false;
+
+    const char *path = "./test_chain_index_tmp.idx";
+    index.save(path);
+    size_t uncompressed_size = index.entries_.size() * (4 + 4 + 1 + 8 * (1 + RI_COUNT));
+    assert(boost::filesystem::file_size(path) * 3 < uncompressed_size);
+
+    Chain_index loaded;
+    loaded.load(path);
+    assert(loaded.rng_seed_ == index.rng_seed_ && loaded.entries_.size() == index.entries_.size());
+    assert(loaded.get_num_iterations() == index.get_num_iterations());
+    for(size_t i = 0; i < index.entries_.size(); i++)
+    {
+        assert(same_entry(loaded.entries_[i], index.entries_[i]));
+    }
+
+    // one column at a time
+    Chain_index_reader column(path, Index_column(IC_RVS + RI_INIT_Y));
+    size_t i = 0;
+    while(column.next(e))
+    {
+        assert(e.first_iteration_ == index.entries_[i].first_iteration_ && e.count_ == index.entries_[i].count_);
+        assert(same_bits(e.rvs_[RI_INIT_Y], index.entries_[i].rvs_[RI_INIT_Y]));
+        i++;
+    }
+    assert(i == index.entries_.size());
+
+    // an empty chain
+    Chain_index empty;
+    empty.save(path);
+    Chain_index_reader empty_reader(path);
+    assert(empty_reader.get_num_entries() == 0 && !empty_reader.next(e));
+
+    // the uncompressed version 1 layout is still read
+    {
+        std::ofstream f(path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+        uint32_t header[2] = {1, 7};
+        uint64_t num_entries = 1;
+        f.write(Chain_index::MAGIC, sizeof(Chain_index::MAGIC));
+        f.write(reinterpret_cast<const char *>(header), sizeof(header));
+        f.write(reinterpret_cast<const char *>(&num_entries), sizeof(num_entries));
+        uint32_t iterations[2] = {0, 10};
+        uint8_t accepted = 0;
+        f.write(reinterpret_cast<const char *>(iterations), sizeof(iterations));
+        f.write(reinterpret_cast<const char *>(&accepted), sizeof(accepted));
+        f.write(reinterpret_cast<const char *>(&index.entries_[0].log_prob_), sizeof(double));
+        f.write(reinterpret_cast<const char *>(index.entries_[0].rvs_), sizeof(index.entries_[0].rvs_));
+    }
+    Chain_index v1;
+    v1.load(path);
+    index.entries_[0].count_ = 10;
+    assert(v1.rng_seed_ == 7 && v1.entries_.size() == 1 && same_entry(v1.entries_[0], index.entries_[0]));
+    std::remove(path);
+
+    // chains of unequal run counts and lengths: one row per acceptance of
+    // either, a chain that ended keeps its last log probability, and an empty
+    // one is left blank
+    {
+        const unsigned a_counts[] = {3, 4, 3};
+        const unsigned b_counts[] = {5, 1, 2, 0, 6};
+        std::vector<Chain_index> chains(3);
+        for(unsigned c : a_counts)
+        {
+            e.count_ = c;
+            e.log_prob_ = -1.0 - double(chains[0].entries_.size());
+            chains[0].entries_.push_back(e);
+        }
+        for(unsigned c : b_counts)
+        {
+            e.count_ = c;
+            e.log_prob_ = -10.0 - double(chains[1].entries_.size());
+            chains[1].entries_.push_back(e);
+        }
+        const char *data_dir = "./test_chain_index_tmp_data";
+        save_chain_comparison_csv(data_dir, 0, 0, chains, 1.0);
+        std::ifstream f(util::get_sample_path(data_dir, 0).string() + "/000000000000_metropolis_000000000000_chain_comparison.csv");
+        assert(f);
+        std::vector<std::string> rows;
+        std::string row;
+        std::getline(f, row);
+        while(std::getline(f, row))
+        {
+            rows.push_back(row);
+        }
+        const std::vector<std::string> expected = {
+            "\"0\",\"-1\",\"-10\",\"\",\"1\"",
+            "\"3\",\"-2\",\"-10\",\"\",\"1\"",
+            "\"5\",\"-2\",\"-11\",\"\",\"1\"",
+            "\"6\",\"-2\",\"-12\",\"\",\"1\"",
+            "\"7\",\"-3\",\"-12\",\"\",\"1\"",
+            "\"8\",\"-3\",\"-14\",\"\",\"1\""};
+        assert(rows == expected);
+        boost::filesystem::remove_all(data_dir);
+    }
+}
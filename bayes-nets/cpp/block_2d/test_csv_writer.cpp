@@ -0,0 +1,69 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "csv_writer.hpp"
+
+using namespace fracture;
+
+static double round_trip(double v)
+{
+    char s[33];
+    s[util::Csv_writer::format_double(v, s)] = '\0';
+    return std::strtod(s, nullptr);
+}
+
+int main(int argc, char *argv[])
+{
+    // doubles read back exactly, and short ones stay short
+    std::mt19937_64 gen(7);
+    std::uniform_real_distribution<double> exponent(-300.0, 300.0);
+    for(size_t i = 0; i < 100000; i++)
+    {
+        double v = std::pow(10.0, exponent(gen)) * (i % 2 ? -1.0 : 1.0);
+        assert(round_trip(v) == v);
+    }
+    assert(round_trip(std::numeric_limits<double>::denorm_min()) == std::numeric_limits<double>::denorm_min());
+    assert(std::isinf(round_trip(-INFINITY)) && round_trip(-INFINITY) < 0.0);
+    char s[32];
+    assert(std::string(s, util::Csv_writer::format_double(0.1, s)) == "0.1");
+    assert(std::string(s, util::Csv_writer::format_double(-2.5, s)) == "-2.5");
+
+    // a tiny buffer, so that rows span several writes out
+    const char *path = "./test_csv_writer_tmp.csv";
+    {
+        util::Csv_writer f(path, {"A", "Say \"B\"", "C"}, 16);
+        assert(f.get_num_columns() == 3);
+        f.write(-12);
+        f.write(std::string(100, 'x'));
+        f.write(0.25);
+        f.end_row();
+        f.write(18446744073709551615ULL);
+        f.skip();
+        f.write(true);
+        bool threw = false;
+        try { f.write(1.0); } catch(util::Csv_writer::Row_size_exception &) { threw = true; }
+        assert(threw);
+        f.end_row();
+        f.write(1u);
+        threw = false;
+        try { f.end_row(); } catch(util::Csv_writer::Row_size_exception &) { threw = true; }
+        assert(threw);
+    }
+    std::ifstream in(path, std::ios_base::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(path);
+    assert(contents ==
+            "\"A\",\"Say \"\"B\"\"\",\"C\"\n"
+            "\"-12\",\"" + std::string(100, 'x') + "\",\"0.25\"\n"
+            "\"18446744073709551615\",\"\",\"1\"\n"
+            "\"1\"");
+}
@@ -19,7 +19,7 @@ int main(int argc, char *argv[])
     size_t im_h = 480;
     double c_fps = 30.0;
 
-    kjb::seed_sampling_rand(args.rng_seed_);
+    prob::seed_sampling_rand(args.rng_seed_);
 
     std::vector<double> stds = Metropolis_hastings_resampler::DEFAULT_STDS;
     double multiplier = std::pow(args.stds_multiplier_, double(args.stds_exp_));
@@ -45,12 +45,16 @@ int main(int argc, char *argv[])
         mhr.resample_all();
         assert(!mhr.still_resampling());
         double prev_log_prob = double(-INFINITY);
-        for(Sample *s : mhr.get_saved_samples().samples_)
+        size_t num_iterations = 0;
+        for(const Sample_run &run : mhr.get_saved_samples().runs_)
         {
-            double cur_log_prob = s->log_prob();
+            assert(run.count_ > 0);
+            double cur_log_prob = run.sample_->log_prob();
             assert(cur_log_prob >= prev_log_prob);
             if(cur_log_prob > prev_log_prob) prev_log_prob = cur_log_prob;
+            num_iterations += run.count_;
         }
-        delete as;
+        // the initial sample plus one entry per resample
+        assert(num_iterations == args.chain_len_ + 1);
     }
 }
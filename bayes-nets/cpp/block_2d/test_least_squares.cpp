@@ -0,0 +1,54 @@
+#include <cassert>
+#include <cmath>
+
+#include "least_squares.hpp"
+#include "metropolis_hastings.hpp"
+#include "sample.hpp"
+#include "sample_vector_adapter.hpp"
+
+int main(int argc, char *argv[])
+{
+    using namespace fracture;
+    using namespace block_2d;
+
+    size_t num_data_samples = 64;
+    size_t num_ims = 30;
+    size_t im_w = 640;
+    size_t im_h = 480;
+    double c_fps = 30.0;
+
+    prob::seed_sampling_rand(42);
+
+    Sample_vector_adapter sva;
+    size_t num_close = 0;
+    for(size_t data_idx = 0; data_idx < num_data_samples; data_idx++)
+    {
+        Sample data(num_ims, im_w, im_h, c_fps);
+        Sample init = get_least_squares_initial_sample(data);
+        Sample prior = get_mh_initial_sample(data);
+
+        // deterministic, and the observations are data's
+        assert(get_least_squares_initial_sample(data) == init);
+        assert(init.get_num_ims() == data.get_num_ims());
+        for(unsigned t = 0; t < num_ims; t++)
+        {
+            std::vector<const kjb::Matrix_d<3,4> *> a = init.get_image_polygon_observed(t);
+            std::vector<const kjb::Matrix_d<3,4> *> b = data.get_image_polygon_observed(t);
+            for(size_t p = 0; p < a.size(); p++)
+            {
+                assert(*a[p] == *b[p]);
+            }
+        }
+        assert(sva.get(&init, RI_INIT_W) == sva.get(&data, RI_INIT_W));
+        assert(sva.get(&init, RI_INIT_H) == sva.get(&data, RI_INIT_H));
+
+        // far closer to the mode than a draw from the prior
+        assert(init.log_prob() > prior.log_prob());
+
+        // Fragments that spin more than a turn between frames can't be
+        // told apart from slower ones, so only most fits come near the
+        // data's own rvs.
+        if(init.log_prob() > data.log_prob() - 1000.0) num_close++;
+    }
+    assert(num_close >= num_data_samples * 9 / 10);
+}
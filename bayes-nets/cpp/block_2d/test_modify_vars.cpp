@@ -19,7 +19,7 @@ int main(int argc, char *argv[])
     double delta = 0.00001;
     double nudge_val = 4.0;
 
-    kjb::seed_sampling_rand(args.rng_seed_);
+    prob::seed_sampling_rand(args.rng_seed_);
 
     for(size_t i = 0; i < num_samples; i++)
     {
@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "sample.hpp"
+#include "smc.hpp"
+#include "thread_pool.hpp"
+
+int main(int argc, char *argv[])
+{
+    using namespace fracture;
+    using namespace block_2d;
+
+    unsigned rng_seed = 42;
+    size_t num_data_samples = 4;
+    unsigned num_particles = 64;
+    unsigned num_moves = 3;
+    double ess_threshold = 0.5;
+    size_t num_ims = 10;
+    size_t im_w = 640;
+    size_t im_h = 480;
+    double c_fps = 30.0;
+
+    prob::seed_sampling_rand(rng_seed);
+
+    // a frame no particle explains stops the tempering instead of stalling
+    // it, and one only a few explain still moves it
+    {
+        double inf = std::numeric_limits<double>::infinity();
+        std::vector<double> log_weights(num_particles, -std::log(double(num_particles)));
+        std::vector<double> log_likelihoods(num_particles, -inf);
+        bool threw = false;
+        try
+        {
+            get_tempering_step(log_weights, log_likelihoods, 1.0, ess_threshold * num_particles);
+        }
+        catch(const prob::No_support_exception &)
+        {
+            threw = true;
+        }
+        assert(threw);
+        log_likelihoods[0] = -1000.0;
+        double step = get_tempering_step(log_weights, log_likelihoods, 1.0, ess_threshold * num_particles);
+        assert(step >= MIN_TEMPERING_STEP && step <= 1.0);
+        assert(get_tempering_step(log_weights, log_likelihoods, 0.5 * MIN_TEMPERING_STEP, ess_threshold * num_particles)
+                == 0.5 * MIN_TEMPERING_STEP);
+    }
+
+    util::Thread_pool serial_pool(1);
+    util::Thread_pool parallel_pool(4);
+    for(size_t data_idx = 0; data_idx < num_data_samples; data_idx++)
+    {
+        Sample data(num_ims, im_w, im_h, c_fps);
+        Smc_sampler serial(rng_seed, num_particles, data, num_moves, ess_threshold, serial_pool);
+        Smc_sampler parallel(rng_seed, num_particles, data, num_moves, ess_threshold, parallel_pool);
+
+        double prior_log_prob = 0.0;
+        for(const Sample &s : serial.get_particles())
+        {
+            prior_log_prob += s.log_prob() / double(num_particles);
+        }
+
+        serial.assimilate_once();
+        assert(serial.get_cur_frame() == 1);
+        serial.assimilate_all();
+        parallel.assimilate_all();
+        assert(!serial.still_assimilating());
+        assert(serial.get_cur_frame() == num_ims);
+
+        // the same run whatever the number of threads
+        assert(serial.get_log_evidence() == parallel.get_log_evidence());
+        assert(serial.get_log_weights() == parallel.get_log_weights());
+        assert(serial.get_num_resamples() == parallel.get_num_resamples());
+
+        assert(std::isfinite(serial.get_log_evidence()));
+        double weight_sum = 0.0;
+        for(double lw : serial.get_log_weights())
+        {
+            weight_sum += std::exp(lw);
+        }
+        assert(std::abs(weight_sum - 1.0) < 1e-9);
+        Smc_record r = serial.get_record();
+        assert(r.ess_.size() == num_ims);
+        for(double ess : r.ess_)
+        {
+            assert(ess >= 1.0 - 1e-9 && ess <= double(num_particles) + 1e-9);
+        }
+
+        // the posterior explains the data better than the prior draws do
+        double posterior_log_prob = 0.0;
+        for(size_t i = 0; i < num_particles; i++)
+        {
+            posterior_log_prob += std::exp(serial.get_log_weights()[i]) * serial.get_particles()[i].log_prob();
+        }
+        assert(posterior_log_prob > prior_log_prob);
+
+        // extending a truncated sample simulates the same frames again
+        Sample first_frames(data);
+        first_frames.truncate(num_ims / 2);
+        assert(first_frames.get_num_ims() == num_ims / 2);
+        assert(!(first_frames == data));
+        first_frames.extend(data);
+        assert(first_frames == data);
+
+        // frames that come in later, whether to the same sampler or to one
+        // resumed from its record, end the same way
+        first_frames.truncate(num_ims / 2);
+        Smc_sampler streamed(rng_seed, num_particles, first_frames, num_moves, ess_threshold, parallel_pool);
+        streamed.assimilate_all();
+        Smc_sampler resumed(streamed.get_record(), data, num_moves, ess_threshold, serial_pool);
+        streamed.extend(data);
+        assert(streamed.still_assimilating());
+        streamed.assimilate_all();
+        resumed.assimilate_all();
+        assert(streamed.get_cur_frame() == num_ims);
+        assert(streamed.get_particles()[0].get_num_ims() == num_ims);
+        assert(std::isfinite(streamed.get_log_evidence()));
+        assert(streamed.get_log_evidence() == resumed.get_log_evidence());
+        assert(streamed.get_log_weights() == resumed.get_log_weights());
+        assert(streamed.get_particles() == resumed.get_particles());
+    }
+}
@@ -0,0 +1,94 @@
+#include <atomic>
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+unsigned default_num_threads()
+{
+    unsigned r = std::thread::hardware_concurrency();
+    // hardware_concurrency() is allowed to return 0 if it can't tell.
+    return r ? r : 1;
+}
+
+Thread_pool::Thread_pool(unsigned num_threads) :
+        stopping_(false)
+{
+    if(!num_threads) num_threads = default_num_threads();
+    threads_.reserve(num_threads);
+    for(unsigned i = 0; i < num_threads; i++)
+    {
+        threads_.push_back(std::thread(&Thread_pool::work, this));
+    }
+}
+
+Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for(std::thread &t : threads_)
+    {
+        t.join();
+    }
+}
+
+void Thread_pool::work()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            // drain the queue before stopping
+            if(tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void Thread_pool::parallel_for(size_t n, const std::function<void(size_t)> &fn, size_t grain)
+{
+    if(!n) return;
+    if(!grain) grain = 1;
+    std::atomic<size_t> next(0);
+    size_t num_workers = std::min(size_t(get_num_threads()), (n + grain - 1) / grain);
+    std::vector<std::future<void>> workers;
+    workers.reserve(num_workers);
+    for(size_t i = 0; i < num_workers; i++)
+    {
+        workers.push_back(submit([&next, &fn, n, grain]()
+        {
+            size_t start;
+            while((start = next.fetch_add(grain)) < n)
+            {
+                size_t stop = std::min(start + grain, n);
+                for(size_t j = start; j < stop; j++)
+                {
+                    fn(j);
+                }
+            }
+        }));
+    }
+    // Wait for every worker before rethrowing, since they reference locals.
+    for(std::future<void> &w : workers)
+    {
+        w.wait();
+    }
+    for(std::future<void> &w : workers)
+    {
+        w.get();
+    }
+}
+
+}
+}
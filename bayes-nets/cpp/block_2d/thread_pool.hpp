@@ -0,0 +1,76 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace fracture
+{
+namespace util
+{
+
+// A fixed number of worker threads pulling tasks off a shared FIFO queue.
+// The number of threads bounds how much work (and, for the archive loaders,
+// how many deserialized chains) is in flight at once.
+//
+// Tasks must not block on other tasks of the same pool. parallel_for waits on
+// the pool, so it must only be called from outside of it.
+class Thread_pool
+{
+public:
+    // 0 means one thread per hardware thread.
+    explicit Thread_pool(unsigned num_threads = 0);
+    ~Thread_pool();
+
+    Thread_pool(const Thread_pool &) = delete;
+    Thread_pool &operator=(const Thread_pool &) = delete;
+
+    unsigned get_num_threads() const { return unsigned(threads_.size()); }
+
+    // Queues f to be run on some worker. Exceptions thrown by f are rethrown
+    // by the future's get().
+    template<class F>
+    std::future<typename std::result_of<F()>::type> submit(F f);
+
+    // Calls fn(i) for every i in [0, n), handing out chunks of grain indices
+    // at a time, and returns once all calls are done. The first exception
+    // thrown by fn is rethrown here.
+    void parallel_for(size_t n, const std::function<void(size_t)> &fn, size_t grain = 1);
+
+private:
+    void work();
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+};
+
+template<class F>
+std::future<typename std::result_of<F()>::type> Thread_pool::submit(F f)
+{
+    typedef typename std::result_of<F()>::type R;
+    // std::function requires a copyable target, so the task is shared.
+    std::shared_ptr<std::packaged_task<R()>> task(new std::packaged_task<R()>(std::move(f)));
+    std::future<R> r = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back([task]() { (*task)(); });
+    }
+    cv_.notify_one();
+    return r;
+}
+
+unsigned default_num_threads();
+
+}
+}
+
+#endif // THREAD_POOL_HPP
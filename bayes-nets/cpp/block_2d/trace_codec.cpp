@@ -0,0 +1,188 @@
+#include <cstring>
+#include <algorithm>
+
+#include "trace_codec.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+void Bit_writer::write(uint64_t bits, unsigned num_bits)
+{
+    while(num_bits)
+    {
+        unsigned bit_in_byte = unsigned(num_bits_ % 8);
+        if(!bit_in_byte) bytes_.push_back(0);
+        unsigned room = 8 - bit_in_byte;
+        unsigned n = std::min(room, num_bits);
+        uint8_t chunk = uint8_t((bits >> (num_bits - n)) & ((1u << n) - 1));
+        bytes_.back() |= uint8_t(chunk << (room - n));
+        num_bits -= n;
+        num_bits_ += n;
+    }
+}
+
+void Bit_writer::write_varint(uint64_t v)
+{
+    num_bits_ = bytes_.size() * 8;
+    do
+    {
+        uint8_t b = uint8_t(v & 0x7f);
+        v >>= 7;
+        bytes_.push_back(v ? uint8_t(b | 0x80) : b);
+    } while(v);
+    num_bits_ = bytes_.size() * 8;
+}
+
+void Bit_writer::clear()
+{
+    bytes_.clear();
+    num_bits_ = 0;
+}
+
+uint64_t Bit_reader::read(unsigned num_bits)
+{
+    if(bit_pos_ + num_bits > num_bytes_ * 8) throw Trace_codec_exception(); //util::err_str(__FILE__, __LINE__);
+    uint64_t r = 0;
+    while(num_bits)
+    {
+        unsigned bit_in_byte = unsigned(bit_pos_ % 8);
+        unsigned room = 8 - bit_in_byte;
+        unsigned n = std::min(room, num_bits);
+        uint64_t chunk = (bytes_[bit_pos_ / 8] >> (room - n)) & ((1u << n) - 1);
+        r = (r << n) | chunk;
+        num_bits -= n;
+        bit_pos_ += n;
+    }
+    return r;
+}
+
+uint64_t Bit_reader::read_varint()
+{
+    bit_pos_ = (bit_pos_ + 7) / 8 * 8;
+    uint64_t r = 0;
+    for(unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if(bit_pos_ / 8 >= num_bytes_) break;
+        uint8_t b = bytes_[bit_pos_ / 8];
+        bit_pos_ += 8;
+        r |= uint64_t(b & 0x7f) << shift;
+        if(!(b & 0x80)) return r;
+    }
+    throw Trace_codec_exception(); //util::err_str(__FILE__, __LINE__);
+}
+
+// the number of bits to encode the count of leading zeros, so at most 31
+static const unsigned XOR_LEADING_BITS = 5;
+// the number of meaningful bits, minus one (from 1 to 64)
+static const unsigned XOR_LENGTH_BITS = 6;
+
+void Xor_encoder::write(double v)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    if(!num_values_++)
+    {
+        out_.write(bits, 64);
+        prev_ = bits;
+        // no window yet
+        leading_ = 64;
+        trailing_ = 0;
+        return;
+    }
+    uint64_t x = bits ^ prev_;
+    prev_ = bits;
+    if(!x)
+    {
+        out_.write(0, 1);
+        return;
+    }
+    unsigned leading = std::min(unsigned(__builtin_clzll(x)), (1u << XOR_LEADING_BITS) - 1);
+    unsigned trailing = unsigned(__builtin_ctzll(x));
+    if(leading >= leading_ && trailing >= trailing_)
+    {
+        // fits in the last window
+        out_.write(2, 2);
+        out_.write(x >> trailing_, 64 - leading_ - trailing_);
+    }
+    else
+    {
+        unsigned len = 64 - leading - trailing;
+        out_.write(3, 2);
+        out_.write(leading, XOR_LEADING_BITS);
+        out_.write(len - 1, XOR_LENGTH_BITS);
+        out_.write(x >> trailing, len);
+        leading_ = leading;
+        trailing_ = trailing;
+    }
+}
+
+double Xor_decoder::read()
+{
+    uint64_t bits;
+    if(!num_values_++)
+    {
+        bits = in_.read(64);
+        leading_ = 64;
+        trailing_ = 0;
+    }
+    else if(!in_.read(1))
+    {
+        bits = prev_;
+    }
+    else
+    {
+        if(in_.read(1))
+        {
+            leading_ = unsigned(in_.read(XOR_LEADING_BITS));
+            unsigned len = unsigned(in_.read(XOR_LENGTH_BITS)) + 1;
+            if(leading_ + len > 64) throw Trace_codec_exception(); //util::err_str(__FILE__, __LINE__);
+            trailing_ = 64 - leading_ - len;
+        }
+        else if(leading_ + trailing_ >= 64)
+        {
+            // a window that was never set
+            throw Trace_codec_exception(); //util::err_str(__FILE__, __LINE__);
+        }
+        bits = prev_ ^ (in_.read(64 - leading_ - trailing_) << trailing_);
+    }
+    prev_ = bits;
+    double r;
+    std::memcpy(&r, &bits, sizeof(r));
+    return r;
+}
+
+void encode_flag_runs(const std::vector<bool> &flags, Bit_writer &out)
+{
+    bool cur = false;
+    uint64_t run = 0;
+    for(bool f : flags)
+    {
+        if(f != cur)
+        {
+            out.write_varint(run);
+            cur = f;
+            run = 0;
+        }
+        run++;
+    }
+    out.write_varint(run);
+}
+
+void decode_flag_runs(Bit_reader &in, size_t num_flags, std::vector<bool> &out)
+{
+    out.clear();
+    out.reserve(num_flags);
+    bool cur = false;
+    while(out.size() < num_flags)
+    {
+        uint64_t run = in.read_varint();
+        if(run > num_flags - out.size()) throw Trace_codec_exception(); //util::err_str(__FILE__, __LINE__);
+        out.insert(out.end(), size_t(run), cur);
+        cur = !cur;
+    }
+}
+
+}
+}
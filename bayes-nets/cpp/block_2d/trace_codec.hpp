@@ -0,0 +1,104 @@
+#ifndef TRACE_CODEC_HPP
+#define TRACE_CODEC_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace fracture
+{
+namespace util
+{
+
+// Lossless encodings for the columns of a chain's trace (see Chain_index).
+// An MH chain's consecutive values of one variable are mostly equal (the
+// move changed another variable) or close, which all of these exploit.
+
+class Trace_codec_exception : std::exception {};
+
+// Appends bits to a byte buffer, most significant bit first.
+class Bit_writer
+{
+public:
+    Bit_writer() : num_bits_(0) {}
+
+    // the low num_bits bits of bits, num_bits <= 64
+    void write(uint64_t bits, unsigned num_bits);
+    // LEB128: 7 bits per byte, low bits first, on a byte boundary
+    void write_varint(uint64_t v);
+
+    const std::vector<uint8_t> &get_bytes() const { return bytes_; }
+    void clear();
+
+private:
+    std::vector<uint8_t> bytes_;
+    size_t num_bits_;
+};
+
+// Reads what a Bit_writer wrote. Throws Trace_codec_exception past the end.
+class Bit_reader
+{
+public:
+    Bit_reader(const uint8_t *bytes, size_t num_bytes) :
+            bytes_(bytes), num_bytes_(num_bytes), bit_pos_(0)
+    {}
+
+    uint64_t read(unsigned num_bits);
+    uint64_t read_varint();
+
+private:
+    const uint8_t *bytes_;
+    size_t num_bytes_;
+    size_t bit_pos_;
+};
+
+// Gorilla XOR compression of a stream of doubles (Pelkonen et al.,
+// "Gorilla: A Fast, Scalable, In-Memory Time Series Database"). Each value
+// is XORed with the one before it. A repeated value takes one bit; one that
+// differs in a few mantissa bits takes those bits and, when the changed bits
+// move outside the last window, 11 bits to describe the new window. Bit
+// exact, including nans and infinities.
+class Xor_encoder
+{
+public:
+    explicit Xor_encoder(Bit_writer &out) :
+            out_(out), prev_(0), num_values_(0), leading_(0), trailing_(0)
+    {}
+
+    void write(double v);
+
+private:
+    Bit_writer &out_;
+    uint64_t prev_;
+    size_t num_values_;
+    // the window of the last XOR that was written out, in bits
+    unsigned leading_;
+    unsigned trailing_;
+};
+
+class Xor_decoder
+{
+public:
+    explicit Xor_decoder(Bit_reader &in) :
+            in_(in), prev_(0), num_values_(0), leading_(0), trailing_(0)
+    {}
+
+    double read();
+
+private:
+    Bit_reader &in_;
+    uint64_t prev_;
+    size_t num_values_;
+    unsigned leading_;
+    unsigned trailing_;
+};
+
+// Run-length encoding of a stream of flags: the lengths of the alternating
+// runs, as varints, starting with a (possibly empty) run of false.
+void encode_flag_runs(const std::vector<bool> &flags, Bit_writer &out);
+void decode_flag_runs(Bit_reader &in, size_t num_flags, std::vector<bool> &out);
+
+}
+}
+
+#endif // TRACE_CODEC_HPP
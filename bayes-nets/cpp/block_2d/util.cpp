@@ -82,37 +82,6 @@ bool double_eq(double a, double b, double delta)
     }
 }
 
-void draw_poly_edges(kjb::Image &im, const kjb::Matrix &poly, const kjb::Image::Pixel_type &color)
-{
-    for(unsigned k = 0; k < unsigned(poly.get_num_cols()); k++)
-    {
-        unsigned next = (k + 1) % unsigned(poly.get_num_cols());
-        im.draw_line_segment(
-                int(poly(0, int(k)) / poly(2, int(k))),
-                int(poly(1, int(k)) / poly(2, int(k))),
-                int(poly(0, int(next)) / poly(2, int(next))),
-                int(poly(1, int(next)) / poly(2, int(next))),
-                0,
-                color);
-    }
-}
-
-void transfer_image_contents(kjb::Image &out, const kjb::Image &in, const kjb::Image::Pixel_type &color)
-{
-    assert(out.get_num_cols() == in.get_num_cols() && out.get_num_rows() == in.get_num_rows());
-    for(unsigned x = 0; x < out.get_num_cols(); x++)
-    {
-        for(unsigned y = 0; y < out.get_num_rows(); y++)
-        {
-            const kjb::Image::Pixel_type &pixel = in(y, x);
-            if(pixel.r != 0.0 || pixel.g != 0.0 || pixel.b != 0.0)
-            {
-                out(y, x) = color;
-            }
-        }
-    }
-}
-
 kjb::Matrix homo_col_vecs_to_non_homo_col_vecs(const kjb::Matrix & in)
 {
     kjb::Matrix r(in.get_num_rows() - 1, in.get_num_cols());
@@ -188,18 +157,37 @@ boost::filesystem::path get_data_image_path(
     return im_path / cur_im_pname.str();
 }
 
+void draw_center_of_mass_image(
+        Canvas &im,
+        const std::vector<const kjb::Vector_d<3> *> &coms,
+        const kjb::Image::Pixel_type &color)
+{
+    for(const kjb::Vector_d<3> *pt : coms)
+    {
+        im.draw_point((*pt)[0] / (*pt)[2], (*pt)[1] / (*pt)[2], 1, color);
+    }
+}
+
+void draw_endpoint_image(
+        Canvas &im,
+        const std::vector<const kjb::Matrix_d<3,4> *> &polygons,
+        const kjb::Image::Pixel_type &color)
+{
+    for(const kjb::Matrix_d<3,4> *block : polygons)
+    {
+        util::draw_poly_edges(im, *block, color);
+    }
+}
+
 void save_center_of_mass_image(
         unsigned im_w,
         unsigned im_h,
         const std::vector<const kjb::Vector_d<3> *> &coms,
         const boost::filesystem::path &p)
 {
-    kjb::Image im(im_h, im_w, cfg::COLOR_BACKGROUND.r, cfg::COLOR_BACKGROUND.g, cfg::COLOR_BACKGROUND.b);
-    for(const kjb::Vector_d<3> *pt : coms)
-    {
-        im.draw_point((*pt)[0] / (*pt)[2], (*pt)[1] / (*pt)[2], 1, cfg::COLOR_FOREGROUND);
-    }
-    im.write(p.string());
+    Canvas im(im_w, im_h, cfg::COLOR_BACKGROUND);
+    draw_center_of_mass_image(im, coms, cfg::COLOR_FOREGROUND);
+    im.write(p);
 }
 
 void save_endpoint_image(
@@ -208,15 +196,9 @@ void save_endpoint_image(
         const std::vector<const kjb::Matrix_d<3,4> *> &polygons,
         const boost::filesystem::path &p)
 {
-    kjb::Image im(im_h, im_w, cfg::COLOR_BACKGROUND.r, cfg::COLOR_BACKGROUND.g, cfg::COLOR_BACKGROUND.b);
-    for(const kjb::Matrix_d<3,4> *block : polygons)
-    {
-        util::draw_poly_edges(
-                im,
-                util::static_matrix_to_dynamic_matrix<3,4>(*block),
-                cfg::COLOR_FOREGROUND);
-    }
-    im.write(p.string());
+    Canvas im(im_w, im_h, cfg::COLOR_BACKGROUND);
+    draw_endpoint_image(im, polygons, cfg::COLOR_FOREGROUND);
+    im.write(p);
 }
 
 static std::string flex_vars_to_string(std::vector<unsigned> flex_vars)
@@ -242,6 +224,18 @@ boost::filesystem::path get_inference_archive_path(
     return sample_path / ar_fname.str();
 }
 
+boost::filesystem::path get_inference_index_path(
+        const std::string & data_dir,
+        unsigned data_idx,
+        Inference_type it,
+        const std::vector<unsigned> & flex_vars)
+{
+    boost::filesystem::path sample_path = get_sample_path(data_dir, data_idx);
+    std::ostringstream ar_fname;
+    ar_fname << pad_unsigned(data_idx) << "_" << INFERENCE_TYPE_STR[it] << "_" << flex_vars_to_string(flex_vars) << ".idx";
+    return sample_path / ar_fname.str();
+}
+
 boost::filesystem::path get_inference_image_path(
         const std::string & data_dir,
         unsigned data_idx,
@@ -271,6 +265,20 @@ boost::filesystem::path get_inference_image_path(
     return path / oss.str();
 }
 
+boost::filesystem::path get_video_path(const boost::filesystem::path &image_path)
+{
+    boost::filesystem::path r = image_path.parent_path();
+    r += ".y4m";
+    return r;
+}
+
+unsigned get_video_frame_idx(const boost::filesystem::path &image_path)
+{
+    // <dataset index>_<image index>.tiff
+    std::string stem = image_path.stem().string();
+    return unsigned(std::stoul(stem.substr(stem.rfind('_') + 1)));
+}
+
 std::vector<unsigned> setup_mh_flex_vars(unsigned std_exp, unsigned interchain_num, unsigned intrachain_idx)
 {
     std::vector<unsigned> r(3);
@@ -289,23 +297,14 @@ boost::filesystem::path get_csv_path(const std::string & data_dir, unsigned data
     return sample_instance_path;
 }
 
-void write_csv_header(std::ofstream & f)
+std::vector<std::string> get_csv_columns()
 {
-    bool written = false;
+    std::vector<std::string> r;
     for(unsigned i = 0; i < CRA_COUNT; i++)
     {
-        if(!RECORD_ATTRS_TO_WRITE[i])
-        {
-            continue;
-        }
-        if(written)
-        {
-            f << ",";
-        }
-        f << "\"" << CRA_STRS[i] << "\"";
-        written = true;
+        if(RECORD_ATTRS_TO_WRITE[i]) r.push_back(CRA_STRS[i]);
     }
-    f << "\n";
+    return r;
 }
 
 std::string err_str(const char *file, unsigned line)
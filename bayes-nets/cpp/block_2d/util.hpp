@@ -14,6 +14,8 @@
 #include <m_cpp/m_matrix_d.impl.h>
 #include <prob_cpp/prob_distribution.h>
 
+#include "canvas.hpp"
+
 bool operator==(const kjb::Normal_distribution &a, const kjb::Normal_distribution &b);
 std::istringstream &operator>>(std::istringstream &ss, std::pair<unsigned,unsigned> &o);
 
@@ -54,11 +56,28 @@ const std::string INFERENCE_IMAGE_DIRNS[IIT_COUNT] = {
 
 const std::string COMBINED_IMAGE_DIRNS = "combined";
 
+// How the per-frame images are stored. With IF_Y4M, all frames of one image
+// folder go to a single uncompressed video next to it instead (see
+// get_video_path).
+enum Image_format
+{
+    IF_TIFF,
+    IF_Y4M,
+
+    // INSERT OTHER ENTRIES ABOVE
+    IF_COUNT
+};
+const std::string IMAGE_FORMAT_STRS[IF_COUNT] = {
+    "tiff",
+    "y4m"
+};
+
 enum Inference_type
 {
     IT_METROPOLIS,
     IT_HMC,
     IT_GRAD_DESC,
+    IT_SMC,
 
     // INSERT OTHER ENTRIES ABOVE
     IT_COUNT
@@ -66,7 +85,8 @@ enum Inference_type
 const std::string INFERENCE_TYPE_STR[IT_COUNT] = {
     "metropolis",
     "hmc",
-    "gradient_descent"
+    "gradient_descent",
+    "smc"
 };
 
 enum Csv_record_attrs
@@ -268,9 +288,22 @@ kjb::Matrix static_matrix_to_dynamic_matrix(const kjb::Matrix_d<rows, cols> &in)
 kjb::Matrix_d<3,2> stick_length_to_local_endpoints_homo(double len);
 double local_endpoints_homo_to_stick_length(const kjb::Matrix_d<3,2> & in);
 
-void draw_poly_edges(kjb::Image &im, const kjb::Matrix &poly, const kjb::Image::Pixel_type &color);
-
-void transfer_image_contents(kjb::Image &out, const kjb::Image &in, const kjb::Image::Pixel_type &color);
+// poly's columns are the homogeneous image coordinates of its corners, in
+// order around it.
+template<size_t cols>
+void draw_poly_edges(Canvas &im, const kjb::Matrix_d<3, cols> &poly, const kjb::Image::Pixel_type &color)
+{
+    for(size_t k = 0; k < cols; k++)
+    {
+        size_t next = (k + 1) % cols;
+        im.draw_line_segment(
+                int(poly[0][k] / poly[2][k]),
+                int(poly[1][k] / poly[2][k]),
+                int(poly[0][next] / poly[2][next]),
+                int(poly[1][next] / poly[2][next]),
+                color);
+    }
+}
 
 const size_t PAD_LEN_DEF = 12;
 const char PAD_CHAR_DEF = '0';
@@ -289,6 +322,12 @@ boost::filesystem::path get_inference_archive_path(
         unsigned data_idx,
         Inference_type it,
         const std::vector<unsigned> & flex_vars);
+// Sidecar of the inference archive written by driver_index_chains.
+boost::filesystem::path get_inference_index_path(
+        const std::string & data_dir,
+        unsigned data_idx,
+        Inference_type it,
+        const std::vector<unsigned> & flex_vars);
 boost::filesystem::path get_inference_image_path(
         const std::string & data_dir,
         unsigned data_idx,
@@ -296,8 +335,21 @@ boost::filesystem::path get_inference_image_path(
         const std::vector<unsigned> & flex_vars,
         unsigned img_idx,
         Inference_image_type iit);
+// The video that holds the image at image_path (as returned by
+// get_*_image_path) in IF_Y4M mode: the image's folder, with a .y4m
+// extension. The image is frame get_video_frame_idx(image_path) of it.
+boost::filesystem::path get_video_path(const boost::filesystem::path &image_path);
+unsigned get_video_frame_idx(const boost::filesystem::path &image_path);
 boost::filesystem::path get_csv_path(const std::string & data_dir, unsigned data_idx, util::Inference_type it, const std::vector<unsigned> &flex_vars);
 
+void draw_center_of_mass_image(
+        Canvas &im,
+        const std::vector<const kjb::Vector_d<3> *> &coms,
+        const kjb::Image::Pixel_type &color);
+void draw_endpoint_image(
+        Canvas &im,
+        const std::vector<const kjb::Matrix_d<3,4> *> &polygons,
+        const kjb::Image::Pixel_type &color);
 void save_center_of_mass_image(
         unsigned im_w,
         unsigned im_h,
@@ -309,7 +361,8 @@ void save_endpoint_image(
         const std::vector<const kjb::Matrix_d<3,4> *> &polygons,
         const boost::filesystem::path &p);
 
-void write_csv_header(std::ofstream & f);
+// the header of the sample CSVs, CRA_STRS of the RECORD_ATTRS_TO_WRITE
+std::vector<std::string> get_csv_columns();
 
 std::vector<unsigned> setup_mh_flex_vars(
         unsigned std_exp,
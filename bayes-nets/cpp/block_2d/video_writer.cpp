@@ -0,0 +1,79 @@
+#include <cmath>
+#include <algorithm>
+
+#include "video_writer.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+static unsigned char clamp_byte(double v)
+{
+    return (unsigned char)(std::min(255.0, std::max(0.0, std::round(v))));
+}
+
+static unsigned gcd(unsigned a, unsigned b)
+{
+    while(b)
+    {
+        unsigned t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+Y4m_writer::Y4m_writer(const boost::filesystem::path &p, unsigned im_w, unsigned im_h, double fps) :
+        f_(p.string(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary),
+        im_w_(im_w),
+        im_h_(im_h),
+        num_frames_(0),
+        planes_(3 * size_t(im_w) * im_h)
+{
+    // frame rate as a ratio, to a thousandth of a frame per second
+    unsigned fps_num = unsigned(std::round(fps * 1000.0));
+    unsigned fps_den = 1000;
+    unsigned d = gcd(fps_num, fps_den);
+    f_ << "YUV4MPEG2 W" << im_w_ << " H" << im_h_
+            << " F" << fps_num / d << ":" << fps_den / d
+            << " Ip A1:1 C444\n";
+}
+
+void Y4m_writer::write_frame(const Canvas &im)
+{
+    if(im.get_num_cols() != im_w_ || im.get_num_rows() != im_h_)
+    {
+        throw Frame_size_exception(); //util::err_str(__FILE__, __LINE__);
+    }
+    // convert the palette once, then look the pixels up
+    unsigned char yuv[3][Canvas::MAX_NUM_COLORS];
+    for(size_t c = 0; c < im.get_num_colors(); c++)
+    {
+        const kjb::Image::Pixel_type &px = im.get_color((unsigned char)(c));
+        yuv[0][c] = clamp_byte(16.0 + (65.481 * px.r + 128.553 * px.g + 24.966 * px.b) / 255.0);
+        yuv[1][c] = clamp_byte(128.0 + (-37.797 * px.r - 74.203 * px.g + 112.0 * px.b) / 255.0);
+        yuv[2][c] = clamp_byte(128.0 + (112.0 * px.r - 93.786 * px.g - 18.214 * px.b) / 255.0);
+    }
+    size_t plane_size = size_t(im_w_) * im_h_;
+    unsigned char *y = planes_.data();
+    unsigned char *u = y + plane_size;
+    unsigned char *v = u + plane_size;
+    for(unsigned row = 0; row < im_h_; row++)
+    {
+        for(unsigned col = 0; col < im_w_; col++)
+        {
+            unsigned char c = im(row, col);
+            size_t i = size_t(row) * im_w_ + col;
+            y[i] = yuv[0][c];
+            u[i] = yuv[1][c];
+            v[i] = yuv[2][c];
+        }
+    }
+    f_ << "FRAME\n";
+    f_.write(reinterpret_cast<const char *>(planes_.data()), std::streamsize(planes_.size()));
+    num_frames_++;
+}
+
+}
+}
@@ -0,0 +1,43 @@
+#ifndef VIDEO_WRITER_HPP
+#define VIDEO_WRITER_HPP
+
+#include <vector>
+#include <fstream>
+
+#include <boost/filesystem/path.hpp>
+
+#include "canvas.hpp"
+
+namespace fracture
+{
+namespace util
+{
+
+// Appends frames to an uncompressed YUV4MPEG2 (.y4m) video, 8-bit 4:4:4
+// (BT.601, studio range). ffmpeg and most players read it as is, e.g.
+//      ffmpeg -i im_geom.y4m im_geom.mp4
+class Y4m_writer
+{
+public:
+    class Frame_size_exception : std::exception {};
+
+    Y4m_writer(const boost::filesystem::path &p, unsigned im_w, unsigned im_h, double fps);
+
+    // im must be im_w x im_h.
+    void write_frame(const Canvas &im);
+
+    unsigned get_num_frames() const { return num_frames_; }
+
+private:
+    std::ofstream f_;
+    unsigned im_w_;
+    unsigned im_h_;
+    unsigned num_frames_;
+    // one frame's Y, U and V planes
+    std::vector<unsigned char> planes_;
+};
+
+}
+}
+
+#endif // VIDEO_WRITER_HPP
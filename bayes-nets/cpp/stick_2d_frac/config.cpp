@@ -0,0 +1,287 @@
+#include "config.hpp"
+#include "discrete_sample.hpp"
+
+namespace stick_2d_frac {
+namespace cfg {
+
+const std::vector<std::string> Arguments_data_gen::DATASET_IDX_OPT = {"-i", "--index"};
+const std::vector<std::string> Arguments_data_gen::NUM_DATASETS_OPT = {"-n", "--num-datasets"};
+const std::vector<std::string> Arguments_data_gen::DATA_SEED_OPT = {"-s", "--data-seed"};
+const std::vector<std::string> Arguments_data_gen::NUM_IMS_OPT = {"-f", "--num-images"};
+const std::vector<std::string> Arguments_data_gen::DEPTH_OPT = {"-d", "--depth"};
+const std::vector<std::string> Arguments_data_gen::IM_W_OPT = {"-w", "--width"};
+const std::vector<std::string> Arguments_data_gen::IM_H_OPT = {"-h", "--height"};
+const std::vector<std::string> Arguments_data_gen::CAM_FPS_OPT = {"-p", "--fps"};
+const std::vector<std::string> Arguments_data_gen::NUM_THREADS_OPT = {"-t", "--threads"};
+const std::vector<std::string> Arguments_data_gen::OUT_FOLDER_OPT = {"-o", "--out-folder"};
+
+const unsigned Arguments_data_gen::DATASET_IDX_DEF = 0;
+const unsigned Arguments_data_gen::NUM_DATASETS_DEF = 10;
+const unsigned Arguments_data_gen::DATA_SEED_DEF = 0;
+const unsigned Arguments_data_gen::NUM_IMS_DEF = 60;
+const int Arguments_data_gen::DEPTH_DEF = sample::Discrete_sample::DEPTH_DEF;
+const unsigned Arguments_data_gen::IM_W_DEF = 640;
+const unsigned Arguments_data_gen::IM_H_DEF = 480;
+const double Arguments_data_gen::CAM_FPS_DEF = 30.0;
+const unsigned Arguments_data_gen::NUM_THREADS_DEF = 0;
+const std::string Arguments_data_gen::OUT_FOLDER_DEF = "samples/";
+
+Arguments_data_gen::Arguments_data_gen() :
+    dataset_idx_(DATASET_IDX_DEF),
+    num_datasets_(NUM_DATASETS_DEF),
+    data_seed_(DATA_SEED_DEF),
+    num_ims_(NUM_IMS_DEF),
+    depth_(DEPTH_DEF),
+    im_w_(IM_W_DEF),
+    im_h_(IM_H_DEF),
+    cam_fps_(CAM_FPS_DEF),
+    num_threads_(NUM_THREADS_DEF),
+    out_folder_(OUT_FOLDER_DEF)
+{}
+
+Arguments_data_gen::Arguments_data_gen(int argc, const char * const * const argv) :
+        Arguments_data_gen()
+{
+    parse(argc, argv);
+}
+
+void Arguments_data_gen::parse(int argc, const char * const * const argv)
+{
+    for(int i = 0; i + 1 < argc; i++)
+    {
+        if(DATASET_IDX_OPT[0] == argv[i] || DATASET_IDX_OPT[1] == argv[i])
+        {
+            dataset_idx_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_DATASETS_OPT[0] == argv[i] || NUM_DATASETS_OPT[1] == argv[i])
+        {
+            num_datasets_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(DATA_SEED_OPT[0] == argv[i] || DATA_SEED_OPT[1] == argv[i])
+        {
+            data_seed_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_IMS_OPT[0] == argv[i] || NUM_IMS_OPT[1] == argv[i])
+        {
+            num_ims_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(DEPTH_OPT[0] == argv[i] || DEPTH_OPT[1] == argv[i])
+        {
+            depth_ = std::stoi(argv[i + 1]);
+        }
+        else if(IM_W_OPT[0] == argv[i] || IM_W_OPT[1] == argv[i])
+        {
+            im_w_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(IM_H_OPT[0] == argv[i] || IM_H_OPT[1] == argv[i])
+        {
+            im_h_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(CAM_FPS_OPT[0] == argv[i] || CAM_FPS_OPT[1] == argv[i])
+        {
+            cam_fps_ = std::stod(argv[i + 1]);
+        }
+        else if(NUM_THREADS_OPT[0] == argv[i] || NUM_THREADS_OPT[1] == argv[i])
+        {
+            num_threads_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(OUT_FOLDER_OPT[0] == argv[i] || OUT_FOLDER_OPT[1] == argv[i])
+        {
+            out_folder_ = argv[i + 1];
+        }
+        else
+        {
+            continue;
+        }
+        i++;
+    }
+}
+
+const std::vector<std::string> Arguments_benchmark::MIN_DEPTH_OPT = {"-d", "--min-depth"};
+const std::vector<std::string> Arguments_benchmark::MAX_DEPTH_OPT = {"-D", "--max-depth"};
+const std::vector<std::string> Arguments_benchmark::MIN_NUM_IMS_OPT = {"-f", "--min-num-images"};
+const std::vector<std::string> Arguments_benchmark::MAX_NUM_IMS_OPT = {"-F", "--max-num-images"};
+const std::vector<std::string> Arguments_benchmark::NUM_REPEATS_OPT = {"-n", "--num-repeats"};
+const std::vector<std::string> Arguments_benchmark::RNG_SEED_OPT = {"-r", "--rng-seed"};
+
+const int Arguments_benchmark::MIN_DEPTH_DEF = 1;
+const int Arguments_benchmark::MAX_DEPTH_DEF = 10;
+const unsigned Arguments_benchmark::MIN_NUM_IMS_DEF = 60;
+const unsigned Arguments_benchmark::MAX_NUM_IMS_DEF = 480;
+const unsigned Arguments_benchmark::NUM_REPEATS_DEF = 3;
+const unsigned Arguments_benchmark::RNG_SEED_DEF = 0;
+
+Arguments_benchmark::Arguments_benchmark() :
+    min_depth_(MIN_DEPTH_DEF),
+    max_depth_(MAX_DEPTH_DEF),
+    min_num_ims_(MIN_NUM_IMS_DEF),
+    max_num_ims_(MAX_NUM_IMS_DEF),
+    num_repeats_(NUM_REPEATS_DEF),
+    rng_seed_(RNG_SEED_DEF)
+{}
+
+Arguments_benchmark::Arguments_benchmark(int argc, const char * const * const argv) :
+        Arguments_benchmark()
+{
+    parse(argc, argv);
+}
+
+void Arguments_benchmark::parse(int argc, const char * const * const argv)
+{
+    for(int i = 0; i + 1 < argc; i++)
+    {
+        if(MIN_DEPTH_OPT[0] == argv[i] || MIN_DEPTH_OPT[1] == argv[i])
+        {
+            min_depth_ = std::stoi(argv[i + 1]);
+        }
+        else if(MAX_DEPTH_OPT[0] == argv[i] || MAX_DEPTH_OPT[1] == argv[i])
+        {
+            max_depth_ = std::stoi(argv[i + 1]);
+        }
+        else if(MIN_NUM_IMS_OPT[0] == argv[i] || MIN_NUM_IMS_OPT[1] == argv[i])
+        {
+            min_num_ims_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(MAX_NUM_IMS_OPT[0] == argv[i] || MAX_NUM_IMS_OPT[1] == argv[i])
+        {
+            max_num_ims_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_REPEATS_OPT[0] == argv[i] || NUM_REPEATS_OPT[1] == argv[i])
+        {
+            num_repeats_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(RNG_SEED_OPT[0] == argv[i] || RNG_SEED_OPT[1] == argv[i])
+        {
+            rng_seed_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else
+        {
+            continue;
+        }
+        i++;
+    }
+}
+
+const std::vector<std::string> Arguments_inference_mh::DATASET_IDX_OPT = {"-i", "--index"};
+const std::vector<std::string> Arguments_inference_mh::DATA_SEED_OPT = {"-s", "--data-seed"};
+const std::vector<std::string> Arguments_inference_mh::NUM_IMS_OPT = {"-f", "--num-images"};
+const std::vector<std::string> Arguments_inference_mh::DEPTH_OPT = {"-d", "--depth"};
+const std::vector<std::string> Arguments_inference_mh::IM_W_OPT = {"-w", "--width"};
+const std::vector<std::string> Arguments_inference_mh::IM_H_OPT = {"-h", "--height"};
+const std::vector<std::string> Arguments_inference_mh::CAM_FPS_OPT = {"-p", "--fps"};
+const std::vector<std::string> Arguments_inference_mh::RNG_SEED_OPT = {"-r", "--rng-seed"};
+const std::vector<std::string> Arguments_inference_mh::NUM_CHAINS_OPT = {"-n", "--num-chains"};
+const std::vector<std::string> Arguments_inference_mh::CHAIN_LEN_OPT = {"-l", "--length"};
+const std::vector<std::string> Arguments_inference_mh::STDS_MULTIPLIER_OPT = {"-m", "--multiplier"};
+const std::vector<std::string> Arguments_inference_mh::STDS_EXP_OPT = {"-e", "--exponent"};
+const std::vector<std::string> Arguments_inference_mh::NUM_JUMPS_OPT = {"-j", "--jumps"};
+const std::vector<std::string> Arguments_inference_mh::OUT_FOLDER_OPT = {"-o", "--out-folder"};
+
+const unsigned Arguments_inference_mh::DATASET_IDX_DEF = 0;
+const unsigned Arguments_inference_mh::DATA_SEED_DEF = 0;
+const unsigned Arguments_inference_mh::NUM_IMS_DEF = 60;
+const int Arguments_inference_mh::DEPTH_DEF = sample::Discrete_sample::DEPTH_DEF;
+const unsigned Arguments_inference_mh::IM_W_DEF = 640;
+const unsigned Arguments_inference_mh::IM_H_DEF = 480;
+const double Arguments_inference_mh::CAM_FPS_DEF = 30.0;
+const unsigned Arguments_inference_mh::RNG_SEED_DEF = 0;
+const unsigned Arguments_inference_mh::NUM_CHAINS_DEF = 1;
+const unsigned Arguments_inference_mh::CHAIN_LEN_DEF = 10000;
+const double Arguments_inference_mh::STDS_MULTIPLIER_DEF = 1.5;
+const unsigned Arguments_inference_mh::STDS_EXP_DEF = 0;
+const unsigned Arguments_inference_mh::NUM_JUMPS_DEF = 0;
+const std::string Arguments_inference_mh::OUT_FOLDER_DEF = "samples/";
+
+Arguments_inference_mh::Arguments_inference_mh() :
+    dataset_idx_(DATASET_IDX_DEF),
+    data_seed_(DATA_SEED_DEF),
+    num_ims_(NUM_IMS_DEF),
+    depth_(DEPTH_DEF),
+    im_w_(IM_W_DEF),
+    im_h_(IM_H_DEF),
+    cam_fps_(CAM_FPS_DEF),
+    rng_seed_(RNG_SEED_DEF),
+    num_chains_(NUM_CHAINS_DEF),
+    chain_len_(CHAIN_LEN_DEF),
+    stds_multiplier_(STDS_MULTIPLIER_DEF),
+    stds_exp_(STDS_EXP_DEF),
+    num_jumps_(NUM_JUMPS_DEF),
+    out_folder_(OUT_FOLDER_DEF)
+{}
+
+Arguments_inference_mh::Arguments_inference_mh(int argc, const char * const * const argv) :
+        Arguments_inference_mh()
+{
+    parse(argc, argv);
+}
+
+void Arguments_inference_mh::parse(int argc, const char * const * const argv)
+{
+    for(int i = 0; i + 1 < argc; i++)
+    {
+        if(DATASET_IDX_OPT[0] == argv[i] || DATASET_IDX_OPT[1] == argv[i])
+        {
+            dataset_idx_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(DATA_SEED_OPT[0] == argv[i] || DATA_SEED_OPT[1] == argv[i])
+        {
+            data_seed_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_IMS_OPT[0] == argv[i] || NUM_IMS_OPT[1] == argv[i])
+        {
+            num_ims_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(DEPTH_OPT[0] == argv[i] || DEPTH_OPT[1] == argv[i])
+        {
+            depth_ = std::stoi(argv[i + 1]);
+        }
+        else if(IM_W_OPT[0] == argv[i] || IM_W_OPT[1] == argv[i])
+        {
+            im_w_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(IM_H_OPT[0] == argv[i] || IM_H_OPT[1] == argv[i])
+        {
+            im_h_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(CAM_FPS_OPT[0] == argv[i] || CAM_FPS_OPT[1] == argv[i])
+        {
+            cam_fps_ = std::stod(argv[i + 1]);
+        }
+        else if(RNG_SEED_OPT[0] == argv[i] || RNG_SEED_OPT[1] == argv[i])
+        {
+            rng_seed_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_CHAINS_OPT[0] == argv[i] || NUM_CHAINS_OPT[1] == argv[i])
+        {
+            num_chains_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(CHAIN_LEN_OPT[0] == argv[i] || CHAIN_LEN_OPT[1] == argv[i])
+        {
+            chain_len_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(STDS_MULTIPLIER_OPT[0] == argv[i] || STDS_MULTIPLIER_OPT[1] == argv[i])
+        {
+            stds_multiplier_ = std::stod(argv[i + 1]);
+        }
+        else if(STDS_EXP_OPT[0] == argv[i] || STDS_EXP_OPT[1] == argv[i])
+        {
+            stds_exp_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(NUM_JUMPS_OPT[0] == argv[i] || NUM_JUMPS_OPT[1] == argv[i])
+        {
+            num_jumps_ = unsigned(std::stoul(argv[i + 1]));
+        }
+        else if(OUT_FOLDER_OPT[0] == argv[i] || OUT_FOLDER_OPT[1] == argv[i])
+        {
+            out_folder_ = argv[i + 1];
+        }
+        else
+        {
+            continue;
+        }
+        i++;
+    }
+}
+
+}
+}
@@ -0,0 +1,159 @@
+#ifndef STICK_2D_FRAC_CONFIG_HPP
+#define STICK_2D_FRAC_CONFIG_HPP
+
+#include <string>
+#include <vector>
+
+namespace stick_2d_frac {
+namespace cfg {
+
+class Arguments_data_gen
+{
+public:
+    static const std::vector<std::string> DATASET_IDX_OPT;
+    static const std::vector<std::string> NUM_DATASETS_OPT;
+    static const std::vector<std::string> DATA_SEED_OPT;
+    static const std::vector<std::string> NUM_IMS_OPT;
+    static const std::vector<std::string> DEPTH_OPT;
+    static const std::vector<std::string> IM_W_OPT;
+    static const std::vector<std::string> IM_H_OPT;
+    static const std::vector<std::string> CAM_FPS_OPT;
+    static const std::vector<std::string> NUM_THREADS_OPT;
+    static const std::vector<std::string> OUT_FOLDER_OPT;
+
+    static const unsigned DATASET_IDX_DEF;
+    static const unsigned NUM_DATASETS_DEF;
+    static const unsigned DATA_SEED_DEF;
+    static const unsigned NUM_IMS_DEF;
+    static const int DEPTH_DEF;
+    static const unsigned IM_W_DEF;
+    static const unsigned IM_H_DEF;
+    static const double CAM_FPS_DEF;
+    static const unsigned NUM_THREADS_DEF;
+    static const std::string OUT_FOLDER_DEF;
+
+    Arguments_data_gen();
+    Arguments_data_gen(int argc, const char * const * const argv);
+
+    void parse(int argc, const char * const * const argv);
+
+    // Datasets [dataset_idx_, dataset_idx_ + num_datasets_). Dataset i is
+    // seeded with prob::derive_seed(data_seed_, i), as in
+    // Arguments_inference_mh, so the inference driver sees the same data.
+    unsigned dataset_idx_;
+    unsigned num_datasets_;
+    unsigned data_seed_;
+    unsigned num_ims_;
+    // of the stick tree, in levels
+    int depth_;
+    unsigned im_w_;
+    unsigned im_h_;
+    double cam_fps_;
+    // Both for sampling and for rendering. 0 means one per hardware thread.
+    unsigned num_threads_;
+    std::string out_folder_;
+};
+
+class Arguments_benchmark
+{
+public:
+    static const std::vector<std::string> MIN_DEPTH_OPT;
+    static const std::vector<std::string> MAX_DEPTH_OPT;
+    static const std::vector<std::string> MIN_NUM_IMS_OPT;
+    static const std::vector<std::string> MAX_NUM_IMS_OPT;
+    static const std::vector<std::string> NUM_REPEATS_OPT;
+    static const std::vector<std::string> RNG_SEED_OPT;
+
+    static const int MIN_DEPTH_DEF;
+    static const int MAX_DEPTH_DEF;
+    static const unsigned MIN_NUM_IMS_DEF;
+    static const unsigned MAX_NUM_IMS_DEF;
+    static const unsigned NUM_REPEATS_DEF;
+    static const unsigned RNG_SEED_DEF;
+
+    Arguments_benchmark();
+    Arguments_benchmark(int argc, const char * const * const argv);
+
+    void parse(int argc, const char * const * const argv);
+
+    // Every depth in [min_depth_, max_depth_], and the frame counts
+    // min_num_ims_, 2 * min_num_ims_, ... up to max_num_ims_.
+    int min_depth_;
+    int max_depth_;
+    unsigned min_num_ims_;
+    unsigned max_num_ims_;
+    // Samples per configuration, the i-th seeded with
+    // prob::derive_seed(rng_seed_, i).
+    unsigned num_repeats_;
+    unsigned rng_seed_;
+};
+
+class Arguments_inference_mh
+{
+public:
+    static const std::vector<std::string> DATASET_IDX_OPT;
+    static const std::vector<std::string> DATA_SEED_OPT;
+    static const std::vector<std::string> NUM_IMS_OPT;
+    static const std::vector<std::string> DEPTH_OPT;
+    static const std::vector<std::string> IM_W_OPT;
+    static const std::vector<std::string> IM_H_OPT;
+    static const std::vector<std::string> CAM_FPS_OPT;
+    static const std::vector<std::string> RNG_SEED_OPT;
+    static const std::vector<std::string> NUM_CHAINS_OPT;
+    static const std::vector<std::string> CHAIN_LEN_OPT;
+    static const std::vector<std::string> STDS_MULTIPLIER_OPT;
+    static const std::vector<std::string> STDS_EXP_OPT;
+    static const std::vector<std::string> NUM_JUMPS_OPT;
+    static const std::vector<std::string> OUT_FOLDER_OPT;
+
+    static const unsigned DATASET_IDX_DEF;
+    static const unsigned DATA_SEED_DEF;
+    static const unsigned NUM_IMS_DEF;
+    static const int DEPTH_DEF;
+    static const unsigned IM_W_DEF;
+    static const unsigned IM_H_DEF;
+    static const double CAM_FPS_DEF;
+    static const unsigned RNG_SEED_DEF;
+    static const unsigned NUM_CHAINS_DEF;
+    static const unsigned CHAIN_LEN_DEF;
+    static const double STDS_MULTIPLIER_DEF;
+    static const unsigned STDS_EXP_DEF;
+    static const unsigned NUM_JUMPS_DEF;
+    static const std::string OUT_FOLDER_DEF;
+
+    Arguments_inference_mh();
+    Arguments_inference_mh(int argc, const char * const * const argv);
+
+    void parse(int argc, const char * const * const argv);
+
+    // The data is forward sampled, seeded with
+    // prob::derive_seed(data_seed_, dataset_idx_), from these.
+    unsigned dataset_idx_;
+    unsigned data_seed_;
+    unsigned num_ims_;
+    // of the stick tree, in levels
+    int depth_;
+    unsigned im_w_;
+    unsigned im_h_;
+    double cam_fps_;
+
+    // Chain i is seeded with prob::derive_seed(rng_seed_, i). The chains
+    // run in parallel, one thread each.
+    unsigned rng_seed_;
+    unsigned num_chains_;
+    // in sweeps over all of the continuous variables
+    unsigned chain_len_;
+    // The proposal stds are the defaults scaled by
+    // stds_multiplier_^stds_exp_ (see get_mh_stds).
+    double stds_multiplier_;
+    unsigned stds_exp_;
+    // Split/merge jumps over the tree structure per sweep. With none, the
+    // chains keep the data's structure.
+    unsigned num_jumps_;
+    std::string out_folder_;
+};
+
+}
+}
+
+#endif // STICK_2D_FRAC_CONFIG_HPP
@@ -34,24 +34,34 @@ public:
                 initial_len_,
                 *sample_s_0(initial_len_, cam_),
                 cam_,
-                *(prob::new_noise_offset_dist(im_w, im_h)))
+                prob::noise_offset_dist(im_w, im_h))
     {
     }
 
     const Camera & get_camera() const { return cam_; }
     Camera & get_camera() { return cam_; }
-    const Stick_node & get_stick_tree() const { return stick_tree_; }
-    Stick_node & get_stick_tree() { return stick_tree_; }
+    const Stick_tree & get_stick_tree() const { return stick_tree_; }
+    Stick_tree & get_stick_tree() { return stick_tree_; }
 
+    // Use this rather than get_camera().set_camera_top, so that the stick's
+    // states are reprojected.
+    void set_camera_top(double val);
     void set_initial_length(double val);
     void set_fracture_location(size_t idx, double val);
     void set_initial_state_element(sample::Hidden_stick_state::State_variable sv, double val);
+    // Redraws the camera and every hidden variable from their priors, but
+    // keeps the observations, e.g. to start inference on them.
+    void forward_sample_hidden_rvs();
+    // See Stick_tree::split_leaf and merge_leaves.
+    void split_leaf(unsigned id, double frac_loc, const Frag_lifetime_tree & flt, const Observation_source & obs);
+    void merge_leaves(unsigned id, const Frag_lifetime_tree & flt, const Observation_source & obs);
 
     double log_prior() const { return cam_.log_prior() + stick_tree_.log_prior(cam_); }
     double log_likelihood() const
     {
-        std::unique_ptr<kjb::Normal_distribution> offset_dist(prob::new_noise_offset_dist(cam_.get_image_width(), cam_.get_image_height()));
-        return stick_tree_.log_likelihood(*offset_dist);
+        return stick_tree_.log_likelihood(
+                prob::noise_offset_dist(cam_.get_image_width(), cam_.get_image_height()),
+                prob::calc_clutter_log_density(cam_.get_image_height(), cam_.get_image_width()));
     }
     double log_posterior() const
     {
@@ -75,7 +85,7 @@ private:
     // initialization list.
     Stick_length_info initial_len_;
 
-    Stick_node stick_tree_;
+    Stick_tree stick_tree_;
 };
 
 }}
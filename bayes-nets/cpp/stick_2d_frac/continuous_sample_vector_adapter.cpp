@@ -16,6 +16,8 @@ namespace stick_2d_frac {
 //     stick end-points.
 // Let's do the first few addresses first, since they're static.
 
+Continuous_sample_vector_adapter::Continuous_sample_vector_adapter() {}
+
 double Continuous_sample_vector_adapter::get(const sample::Continuous_sample * s, size_t idx) const
 {
     switch(idx)
@@ -25,20 +27,19 @@ double Continuous_sample_vector_adapter::get(const sample::Continuous_sample * s
     case 1:
         return s->get_stick_tree().get_length_info().get_length();
     case 2:
-        return s->get_stick_tree().get_hidden_stick_state(0).get_state_element(sample::Hidden_stick_state::SV_X_POSITION);
+        return s->get_stick_tree().get_hidden_stick_state(sample::Stick_tree_structure::ROOT_ID, 0).get_state_element(sample::Hidden_stick_state::SV_X_POSITION);
     case 3:
-        return s->get_stick_tree().get_hidden_stick_state(0).get_state_element(sample::Hidden_stick_state::SV_Y_POSITION);
+        return s->get_stick_tree().get_hidden_stick_state(sample::Stick_tree_structure::ROOT_ID, 0).get_state_element(sample::Hidden_stick_state::SV_Y_POSITION);
     case 4:
-        return s->get_stick_tree().get_hidden_stick_state(0).get_state_element(sample::Hidden_stick_state::SV_X_VELOCITY);
+        return s->get_stick_tree().get_hidden_stick_state(sample::Stick_tree_structure::ROOT_ID, 0).get_state_element(sample::Hidden_stick_state::SV_X_VELOCITY);
     case 5:
-        return s->get_stick_tree().get_hidden_stick_state(0).get_state_element(sample::Hidden_stick_state::SV_Y_VELOCITY);
+        return s->get_stick_tree().get_hidden_stick_state(sample::Stick_tree_structure::ROOT_ID, 0).get_state_element(sample::Hidden_stick_state::SV_Y_VELOCITY);
     case 6:
-        return s->get_stick_tree().get_hidden_stick_state(0).get_state_element(sample::Hidden_stick_state::SV_ANGLE);
+        return s->get_stick_tree().get_hidden_stick_state(sample::Stick_tree_structure::ROOT_ID, 0).get_state_element(sample::Hidden_stick_state::SV_ANGLE);
     case 7:
-        return s->get_stick_tree().get_hidden_stick_state(0).get_state_element(sample::Hidden_stick_state::SV_ANGULAR_VELOCITY);
+        return s->get_stick_tree().get_hidden_stick_state(sample::Stick_tree_structure::ROOT_ID, 0).get_state_element(sample::Hidden_stick_state::SV_ANGULAR_VELOCITY);
     default:
-        idx -= 8; // Need something to point a reference at.
-        return s->get_stick_tree().get_nonleaf_node_by_index(idx)->get_left()->get_length_info().get_length();
+        return s->get_stick_tree().get_fracture_location(idx - 8);
     }
 }
 
@@ -47,7 +48,7 @@ void Continuous_sample_vector_adapter::set(sample::Continuous_sample * s, size_t
     switch(idx)
     {
     case 0:
-        s->get_camera().set_camera_top(val);
+        s->set_camera_top(val);
         break;
     case 1:
         s->set_initial_length(val);
@@ -22,12 +22,12 @@ public:
     size_t size(const sample::Continuous_sample * s) const;
 };
 
-double continuous_sample_log_posterior(const sample::Continuous_sample & cs)
+inline double continuous_sample_log_posterior(const sample::Continuous_sample & cs)
 {
     return cs.log_posterior();
 }
 
-kjb::Vector continuous_sample_log_gradient(const sample::Continuous_sample & cs)
+inline kjb::Vector continuous_sample_log_gradient(const sample::Continuous_sample & cs)
 {
     Continuous_sample_vector_adapter csva;
     // TODO figure out how to define the deltas
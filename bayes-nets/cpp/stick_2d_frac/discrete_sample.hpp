@@ -3,6 +3,7 @@
 
 #include <boost/serialization/access.hpp>
 
+#include "prob.hpp"
 #include "stick_tree_structure.hpp"
 #include "frag_lifetime_node.hpp"
 
@@ -11,27 +12,52 @@ namespace stick_2d_frac { namespace sample {
 class Discrete_sample {
     friend class boost::serialization::access;
 public:
-    // Uses forward sampling to initialize the object
-    Discrete_sample(unsigned num_ims) :
-        // Let's leave things simpler and stick with a set depth for now.
-        tree_structure_(3),
+    // Forward samples start from a full tree of this depth. Inference can
+    // split and merge leaves from there, anywhere up to
+    // Stick_tree_structure::MAX_DEPTH.
+    static const int DEPTH_DEF = 3;
+
+    // Uses forward sampling to initialize the object. Throws if some
+    // fragment would start after the last frame, which gets likely once
+    // depth approaches num_ims / 2, since every fracture takes at least one
+    // frame.
+    Discrete_sample(unsigned num_ims, int depth = DEPTH_DEF) :
+        tree_structure_(depth),
         // Use the structure to sample the stick fracture times.
         frag_lifetime_tree_(tree_structure_, 0, num_ims) {}
 
     const Stick_tree_structure & get_stick_tree_structure() const { return tree_structure_; }
-    const Frag_lifetime_node & get_frac_lifetime_tree() const { return frag_lifetime_tree_; }
+    const Frag_lifetime_tree & get_frac_lifetime_tree() const { return frag_lifetime_tree_; }
+
+    // The structure's prior is that of the variable depth structures, so
+    // that inference can change it.
+    double log_prior() const
+    {
+        return tree_structure_.log_prior(prob::FRAC_CHANCE) + frag_lifetime_tree_.log_prior(tree_structure_);
+    }
 
-    double log_prior() const { return get_frac_lifetime_tree().log_prior(); }
+    // Fractures the leaf id at fracture_time, or undoes the fracture of a
+    // mergeable id.
+    void split_leaf(unsigned id, unsigned fracture_time)
+    {
+        tree_structure_.split(id);
+        frag_lifetime_tree_.split(id, fracture_time);
+    }
+    void merge_leaves(unsigned id)
+    {
+        tree_structure_.merge(id);
+        frag_lifetime_tree_.merge(id);
+    }
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
         ar & tree_structure_ & frag_lifetime_tree_;
     }
 private:
-    // These are both recursive structures, so they can't be nested easily. Just use
-    // smart pointers in this case.
+    // tree_structure_ has to be constructed first, since frag_lifetime_tree_
+    // is sampled from it.
     Stick_tree_structure tree_structure_;
-    Frag_lifetime_node frag_lifetime_tree_;
+    Frag_lifetime_tree frag_lifetime_tree_;
 };
 
 }}
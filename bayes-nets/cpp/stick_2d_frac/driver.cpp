@@ -1,6 +1,23 @@
 #include "i/i_float.h"
 #include "i_cpp/i_image.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
+#include <thread>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include "config.hpp"
+#include "prob.hpp"
 #include "sample.hpp"
 
 namespace stick_2d_frac {
@@ -32,103 +49,212 @@ const kjb::Image::Pixel_type INFERRED_COLOR =
         .alpha = 1.0
     }
 };
-const std::string SAMPLE_DIR = "samples/";
 const std::string FORWARD_SAMPLING_SUBDIR = "forward_sampling/";
-const std::string INFERENCE_SUBDIR = "inference/";
 const std::string IMAGE_SUBDIR = "images/";
-const unsigned NUM_IMS(60);
-const unsigned IM_W(640);
-const unsigned IM_H(480);
-const double CAM_FPS(30.0);
-const unsigned NUM_SAMPLES(10);
-
-// Basically pass this into the ostream before a number, then again after the number,
-// for easy, consistent formatting.
-class ostream_tickler {
+const std::string IMAGE_TYPE_SUBDIRS[] = {"actual/", "observed/", "both/"};
+// Frames waiting to be rendered, per rendering thread. They only hold the
+// lines, so this mostly bounds how far sampling gets ahead of the disk.
+const size_t MAX_QUEUED_FRAMES_PER_THREAD(16);
+
+std::string get_dataset_path(const cfg::Arguments_data_gen & args, unsigned dataset_idx)
+{
+    std::ostringstream s;
+    s << args.out_folder_ << std::setw(6) << std::setfill('0') << dataset_idx << '/' << FORWARD_SAMPLING_SUBDIR;
+    return s.str();
+}
+
+// The lines of one frame, and where to write its images.
+class Frame_lines
+{
 public:
-    ostream_tickler(): toggle_(false) {}
+    unsigned dataset_idx_;
+    unsigned frame_idx_;
+    std::string image_path_;
+    std::vector<kjb::Matrix> hidden_;
+    std::vector<kjb::Matrix> observed_;
+};
+
+// Frames on their way from the sampling threads to the rendering threads.
+// push blocks while the queue is full, and pop while it is empty until
+// close is called. After abort, both return at once.
+class Frame_queue
+{
+public:
+    explicit Frame_queue(size_t max_queued) :
+        max_queued_(max_queued),
+        closed_(false),
+        aborted_(false)
+    {}
+
+    void push(Frame_lines & f)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&]() { return aborted_ || frames_.size() < max_queued_; });
+        if(aborted_) return;
+        frames_.push_back(Frame_lines());
+        std::swap(frames_.back(), f);
+        not_empty_.notify_one();
+    }
+
+    // false once the queue is closed and empty, or aborted.
+    bool pop(Frame_lines & f)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&]() { return aborted_ || closed_ || !frames_.empty(); });
+        if(aborted_ || frames_.empty()) return false;
+        std::swap(f, frames_.front());
+        frames_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+    bool is_aborted()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return aborted_;
+    }
+
+    void abort()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
 
-    friend std::ostream & operator<<(std::ostream & s, const ostream_tickler & ot);
 private:
-    mutable bool toggle_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<Frame_lines> frames_;
+    size_t max_queued_;
+    bool closed_;
+    bool aborted_;
 };
-std::ostream & operator<<(std::ostream & s, const ostream_tickler & ot)
+
+// Forward samples dataset_idx, saves it, and queues its frames.
+void sample_dataset(const cfg::Arguments_data_gen & args, unsigned dataset_idx, Frame_queue & q)
 {
-    if(!ot.toggle_) {
-        ot.toggle_ = true;
-        return s << std::setw(6) << std::setfill('0') << std::right;
-    } else {
-        ot.toggle_ = false;
-        return s << std::setw(0);
+    prob::seed_sampling_rand(prob::derive_seed(args.data_seed_, dataset_idx));
+    sample::Sample s(args.num_ims_, args.im_w_, args.im_h_, args.cam_fps_, args.depth_);
+
+    std::string path(get_dataset_path(args, dataset_idx));
+    for(const std::string & subdir : IMAGE_TYPE_SUBDIRS)
+    {
+        boost::filesystem::create_directories(path + IMAGE_SUBDIR + subdir);
+    }
+    std::ostringstream ar_filename_stream;
+    ar_filename_stream << path << std::setw(6) << std::setfill('0') << dataset_idx << "_forward_sample.serializedcppobject";
+    {
+        std::ofstream ofs(ar_filename_stream.str());
+        boost::archive::text_oarchive oa(ofs);
+        oa << s;
     }
-}
-const ostream_tickler OT;
 
-void set_format_number(std::ostream & s) { s << std::setw(6) << std::setfill('0') << std::right; }
+    const sample::Stick_tree & tree = s.get_continuous_sample().get_stick_tree();
+    for(unsigned j = 0; j < args.num_ims_; j++)
+    {
+        Frame_lines f;
+        f.dataset_idx_ = dataset_idx;
+        f.frame_idx_ = j;
+        f.image_path_ = path + IMAGE_SUBDIR;
+        tree.get_all_active_hidden_lines(s.get_discrete_sample().get_frac_lifetime_tree(), j, f.hidden_);
+        tree.get_all_active_observed_lines(s.get_discrete_sample().get_frac_lifetime_tree(), j, f.observed_);
+        q.push(f);
+    }
+}
 
-void clear_format_number(std::ostream & s) { s << std::setw(0); }
+void render_frame(const cfg::Arguments_data_gen & args, const Frame_lines & f)
+{
+    kjb::Image im_actual(args.im_w_, args.im_h_, 0, 0, 0);
+    kjb::Image im_observed(args.im_w_, args.im_h_, 0, 0, 0);
+    kjb::Image im_both(args.im_w_, args.im_h_, 0, 0, 0);
+    for(const kjb::Matrix & line : f.hidden_) {
+        im_actual.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, ACTUAL_COLOR);
+        im_both.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, ACTUAL_COLOR);
+    }
+    for(const kjb::Matrix & line : f.observed_) {
+        im_observed.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, OBSERVED_COLOR);
+        im_both.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, OBSERVED_COLOR);
+    }
+    const kjb::Image * ims[] = {&im_actual, &im_observed, &im_both};
+    const char * const suffixes[] = {"_actual.tiff", "_observed.tiff", "_both.tiff"};
+    for(size_t k = 0; k < 3; k++)
+    {
+        std::ostringstream filename_stream;
+        filename_stream << f.image_path_ << IMAGE_TYPE_SUBDIRS[k]
+                << std::setw(6) << std::setfill('0') << f.dataset_idx_ << '_'
+                << std::setw(6) << std::setfill('0') << f.frame_idx_ << suffixes[k];
+        ims[k]->write(filename_stream.str());
+    }
+}
 
 }
 
 int main(int argc, const char ** argv) {
-    // TODO read arguments instead of using globals
     using namespace stick_2d_frac;
-    for(unsigned i = 0; i < NUM_SAMPLES; i++) {
-        // Base path
-        std::ostringstream path_stream;
-        path_stream << SAMPLE_DIR << OT << i << OT << '/' << FORWARD_SAMPLING_SUBDIR;
-
-        // For the archive file
-        std::ostringstream ar_filename_stream(path_stream.str());
-        ar_filename_stream << OT << i << OT << "_forward_sample.serializedcppobject";
-
-        // Image path
-        path_stream << IMAGE_SUBDIR;
-
-        // Forward sample
-        sample::Sample s(NUM_IMS, IM_W, IM_H, CAM_FPS);
-        for(unsigned j = 0; j < NUM_IMS; j++) {
-            // File names
-            std::ostringstream act_im_filename_stream(path_stream.str());
-            act_im_filename_stream << "actual/" << OT << i << OT << '_' << OT << j << OT << "_actual.tiff";
-            std::ostringstream obs_im_filename_stream(path_stream.str());
-            obs_im_filename_stream << "observed/" << OT << i << OT << '_' << OT << j << OT << "_observed.tiff";
-            std::ostringstream both_im_filename_stream(path_stream.str());
-            both_im_filename_stream << "both/" << OT << i << OT << '_' << OT << j << OT << "_both.tiff";
-            kjb::Image im_actual(IM_W, IM_H, 0, 0, 0);
-            kjb::Image im_observed(IM_W, IM_H, 0, 0, 0);
-            kjb::Image im_both(IM_W, IM_H, 0, 0, 0);
-            std::vector<kjb::Matrix> container;
-            s.get_continuous_sample().get_stick_tree().get_all_active_hidden_lines
-            (
-                s.get_discrete_sample().get_frac_lifetime_tree(),
-                j,
-                container
-            );
-            for(const kjb::Matrix & line : container) {
-                im_actual.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, ACTUAL_COLOR);
-                im_both.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, ACTUAL_COLOR);
-            }
-            container.clear();
-            s.get_continuous_sample().get_stick_tree().get_all_active_observed_lines
-            (
-                s.get_discrete_sample().get_frac_lifetime_tree(),
-                j,
-                container
-            );
-            for(const kjb::Matrix & line : container) {
-                im_observed.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, OBSERVED_COLOR);
-                im_both.draw_line_segment(line(0, 0), line(0, 1), line(1, 0), line(1, 1), 1, OBSERVED_COLOR);
-            }
-            im_actual.write(act_im_filename_stream.str());
-            im_observed.write(obs_im_filename_stream.str());
-            im_both.write(both_im_filename_stream.str());
+    cfg::Arguments_data_gen args(argc, argv);
+    unsigned num_threads(args.num_threads_ ? args.num_threads_ : std::max(1u, std::thread::hardware_concurrency()));
+
+    // Each sampling thread takes the next dataset, and each rendering
+    // thread the next frame, so a dataset's images are drawn and written
+    // while the datasets after it are sampled. Only the first error is
+    // kept; the queue is aborted so that every thread stops.
+    Frame_queue q(MAX_QUEUED_FRAMES_PER_THREAD * num_threads);
+    std::atomic<unsigned> next_dataset(0);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto run = [&](const std::function<void()> & work)
+    {
+        try
+        {
+            work();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if(!error) error = std::current_exception();
+            q.abort();
         }
+    };
 
+    std::vector<std::thread> samplers;
+    std::vector<std::thread> renderers;
+    for(unsigned i = 0; i < num_threads; i++)
+    {
+        samplers.push_back(std::thread(run, [&]()
+        {
+            for(unsigned d = next_dataset++; d < args.num_datasets_ && !q.is_aborted(); d = next_dataset++)
+            {
+                sample_dataset(args, args.dataset_idx_ + d, q);
+            }
+        }));
+        renderers.push_back(std::thread(run, [&]()
+        {
+            Frame_lines f;
+            while(q.pop(f))
+            {
+                render_frame(args, f);
+            }
+        }));
     }
-
-
+    for(std::thread & t : samplers)
+    {
+        t.join();
+    }
+    q.close();
+    for(std::thread & t : renderers)
+    {
+        t.join();
+    }
+    if(error) std::rethrow_exception(error);
 
     return 0;
 }
-
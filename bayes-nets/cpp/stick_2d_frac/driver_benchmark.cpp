@@ -0,0 +1,181 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "config.hpp"
+#include "prob.hpp"
+#include "sample.hpp"
+
+namespace stick_2d_frac {
+namespace driver_benchmark {
+
+// The image size and frame rate don't change the amount of work.
+const unsigned IM_W(640);
+const unsigned IM_H(480);
+const double CAM_FPS(30.0);
+
+// Averages over the samples of one configuration, in seconds.
+class Benchmark_result
+{
+public:
+    Benchmark_result() :
+        num_samples_(0),
+        num_attempts_(0),
+        num_nodes_(0),
+        num_states_(0),
+        sample_s_(0.0),
+        log_posterior_s_(0.0),
+        move_s_(0.0)
+    {}
+
+    unsigned num_samples_;
+    unsigned num_attempts_;
+    double num_nodes_;
+    double num_states_;
+    // forward sampling
+    double sample_s_;
+    // evaluating the log posterior from scratch
+    double log_posterior_s_;
+    // moving the deepest fracture location, then evaluating the log
+    // posterior again, as one MH move would
+    double move_s_;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Benchmark_result run(const cfg::Arguments_benchmark & args, int depth, unsigned num_ims)
+{
+    // A deep tree may not fit in few frames (see Discrete_sample), so the
+    // samples that don't are skipped, up to a point.
+    const unsigned MAX_ATTEMPTS_PER_SAMPLE = 10;
+    Benchmark_result r;
+    volatile double sink(0.0);
+    for(unsigned seed_idx = 0;
+            r.num_samples_ < args.num_repeats_ && r.num_attempts_ < MAX_ATTEMPTS_PER_SAMPLE * args.num_repeats_;
+            seed_idx++)
+    {
+        r.num_attempts_++;
+        prob::seed_sampling_rand(prob::derive_seed(args.rng_seed_, seed_idx));
+        std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+        try
+        {
+            sample::Sample s(num_ims, IM_W, IM_H, CAM_FPS, depth);
+            r.sample_s_ += seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            sink = sink + s.log_posterior();
+            r.log_posterior_s_ += seconds_since(start);
+
+            sample::Continuous_sample & cs = s.get_continuous_sample();
+            size_t num_fracs(cs.get_stick_tree().get_num_nonleaf_nodes());
+            if(num_fracs)
+            {
+                start = std::chrono::steady_clock::now();
+                cs.set_fracture_location(num_fracs - 1, 0.5 * cs.get_stick_tree().get_fracture_location(num_fracs - 1));
+                sink = sink + s.log_posterior();
+                r.move_s_ += seconds_since(start);
+            }
+
+            r.num_nodes_ += double(cs.get_stick_tree().get_structure().get_num_nodes());
+            r.num_states_ += double(cs.get_stick_tree().get_total_number_of_states());
+            r.num_samples_++;
+        }
+        catch(const char *)
+        {
+            continue;
+        }
+    }
+    if(r.num_samples_)
+    {
+        r.num_nodes_ /= r.num_samples_;
+        r.num_states_ /= r.num_samples_;
+        r.sample_s_ /= r.num_samples_;
+        r.log_posterior_s_ /= r.num_samples_;
+        r.move_s_ /= r.num_samples_;
+    }
+    return r;
+}
+
+// Runs one configuration in a child process, so that its peak memory can
+// be told apart from the others'. false if the child failed.
+bool run_isolated(
+        const cfg::Arguments_benchmark & args,
+        int depth,
+        unsigned num_ims,
+        Benchmark_result & result,
+        long & peak_rss_kb)
+{
+    int fds[2];
+    if(pipe(fds))
+        return false;
+    pid_t pid(fork());
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if(!pid)
+    {
+        close(fds[0]);
+        Benchmark_result r(run(args, depth, num_ims));
+        bool ok(write(fds[1], &r, sizeof(r)) == ssize_t(sizeof(r)));
+        close(fds[1]);
+        _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    bool ok(read(fds[0], &result, sizeof(result)) == ssize_t(sizeof(result)));
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        return false;
+    // in kilobytes on Linux
+    peak_rss_kb = usage.ru_maxrss;
+    return ok;
+}
+
+}
+}
+
+int main(int argc, const char ** argv)
+{
+    using namespace stick_2d_frac;
+    using namespace stick_2d_frac::driver_benchmark;
+    cfg::Arguments_benchmark args(argc, argv);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "# baseline peak rss: " << usage.ru_maxrss << " kB" << std::endl;
+    std::cout << "depth,num_images,samples,attempts,nodes,states,sample_s,log_posterior_s,move_s,peak_rss_kb" << std::endl;
+    for(int depth = args.min_depth_; depth <= args.max_depth_; depth++)
+    {
+        for(unsigned num_ims = args.min_num_ims_; num_ims && num_ims <= args.max_num_ims_; num_ims *= 2)
+        {
+            Benchmark_result r;
+            long peak_rss_kb(0);
+            if(!run_isolated(args, depth, num_ims, r, peak_rss_kb))
+            {
+                std::cerr << "depth " << depth << ", " << num_ims << " images: failed" << std::endl;
+                continue;
+            }
+            std::cout << depth << ',' << num_ims << ','
+                    << r.num_samples_ << ',' << r.num_attempts_ << ','
+                    << std::fixed << std::setprecision(1)
+                    << r.num_nodes_ << ',' << r.num_states_ << ','
+                    << std::scientific << std::setprecision(3)
+                    << r.sample_s_ << ',' << r.log_posterior_s_ << ',' << r.move_s_ << ','
+                    << peak_rss_kb << std::endl;
+        }
+    }
+    return 0;
+}
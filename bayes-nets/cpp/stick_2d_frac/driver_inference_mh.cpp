@@ -0,0 +1,93 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include "config.hpp"
+#include "prob.hpp"
+#include "sample.hpp"
+#include "metropolis_hastings.hpp"
+
+namespace stick_2d_frac {
+namespace driver_inference_mh {
+
+const std::string INFERENCE_SUBDIR = "inference/";
+
+std::string get_chain_path(const cfg::Arguments_inference_mh & args, unsigned chain_idx)
+{
+    std::ostringstream s;
+    s << args.out_folder_
+            << std::setw(6) << std::setfill('0') << std::right << args.dataset_idx_ << std::setw(0) << '/'
+            << INFERENCE_SUBDIR << "chain_"
+            << std::setw(6) << std::setfill('0') << std::right << chain_idx << std::setw(0)
+            << ".serializedcppobject";
+    return s.str();
+}
+
+void run_chain(
+        const cfg::Arguments_inference_mh & args,
+        const sample::Sample & data,
+        const std::vector<double> & stds,
+        unsigned chain_idx,
+        std::unique_ptr<Metropolis_hastings_resampler> & out)
+{
+    unsigned seed(prob::derive_seed(args.rng_seed_, chain_idx));
+    prob::seed_sampling_rand(seed);
+    out.reset(new Metropolis_hastings_resampler(
+            seed, args.chain_len_, get_mh_initial_sample(data), stds, data.get_observation_source(), args.num_jumps_));
+    out->resample_all();
+}
+
+}
+}
+
+int main(int argc, const char ** argv)
+{
+    using namespace stick_2d_frac;
+    using namespace stick_2d_frac::driver_inference_mh;
+    cfg::Arguments_inference_mh args(argc, argv);
+
+    prob::seed_sampling_rand(prob::derive_seed(args.data_seed_, args.dataset_idx_));
+    const sample::Sample data(args.num_ims_, args.im_w_, args.im_h_, args.cam_fps_, args.depth_);
+    std::vector<double> stds(get_mh_stds(args.stds_multiplier_, args.stds_exp_));
+
+    std::vector<std::unique_ptr<Metropolis_hastings_resampler>> chains(args.num_chains_);
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < args.num_chains_; i++)
+    {
+        threads.push_back(std::thread(run_chain, std::cref(args), std::cref(data), std::cref(stds), i, std::ref(chains[i])));
+    }
+    for(std::thread & t : threads)
+    {
+        t.join();
+    }
+
+    for(unsigned i = 0; i < args.num_chains_; i++)
+    {
+        boost::filesystem::path p(get_chain_path(args, i));
+        boost::filesystem::create_directories(p.parent_path());
+        std::ofstream ofs(p.string());
+        boost::archive::text_oarchive oa(ofs);
+        oa << chains[i]->get_saved_samples();
+
+        std::cout << "chain " << i << ": log posterior " << chains[i]->get_cur_log_prob() << std::endl;
+        for(size_t pk = 0; pk < Metropolis_hastings_resampler::PK_COUNT; pk++)
+        {
+            std::cout << "    " << Metropolis_hastings_resampler::PK_STRS[pk] << " acceptance rate: "
+                    << chains[i]->get_acceptance_rate(Metropolis_hastings_resampler::Proposal_kind(pk)) << std::endl;
+        }
+        for(size_t jk = 0; args.num_jumps_ > 0 && jk < Metropolis_hastings_resampler::JK_COUNT; jk++)
+        {
+            std::cout << "    " << Metropolis_hastings_resampler::JK_STRS[jk] << " acceptance rate: "
+                    << chains[i]->get_acceptance_rate(Metropolis_hastings_resampler::Jump_kind(jk)) << std::endl;
+        }
+        std::cout << "    fractures: " << chains[i]->get_cur_sample().get_discrete_sample().get_stick_tree_structure().get_num_nonleaf_nodes() << std::endl;
+    }
+    return 0;
+}
@@ -1,68 +1,115 @@
+#include <algorithm>
+
 #include <prob_cpp/prob_sample.h>
 
 #include "frag_lifetime_node.hpp"
+#include "prob.hpp"
 
 namespace stick_2d_frac { namespace sample {
 
-// Additional fractures tend to happen soon after the initial fracture.
-static const kjb::Geometric_distribution frac_time_i_dist(0.5);
-Frag_lifetime_node::Frag_lifetime_node(
+Frag_lifetime_tree::Frag_lifetime_tree(
         const Stick_tree_structure & structure,
-        unsigned subtree_start_time,
-        unsigned subtree_end_time):
-    start_t_(subtree_start_time)
+        unsigned start_time,
+        unsigned end_time):
+    nodes_(structure.get_max_id_in_tree() + 1)
 {
-    if(subtree_start_time >= subtree_end_time)
-        throw "subtree_start_time >= subtree_end_time";
-    if(structure.is_leaf())
+    nodes_[Stick_tree_structure::ROOT_ID].start_t_ = start_time;
+    // Parents come first, so every node's start time is set by the time we
+    // get to it.
+    for(unsigned id : structure.get_preorder_ids())
     {
-        end_t_ = subtree_end_time;
-        l_ = nullptr;
-        r_ = nullptr;
+        Frag_lifetime_node & node = nodes_[id];
+        if(node.start_t_ >= end_time)
+            throw "subtree_start_time >= subtree_end_time";
+        if(structure.is_leaf(id))
+        {
+            node.end_t_ = end_time;
+        }
+        else
+        {
+            // Additional fractures tend to happen soon after the initial
+            // fracture. end_t_ is excluded, so the offset is at least one
+            // frame, and the stick lives for at least one frame.
+            node.end_t_ = prob::fr_t_sample(node.start_t_);
+            nodes_[Stick_tree_structure::get_left_id(id)].start_t_ = node.end_t_;
+            nodes_[Stick_tree_structure::get_right_id(id)].start_t_ = node.end_t_;
+        }
     }
-    else
-    {
-        // The underlying implementation of kjb::Geometric_distribution is
-        // boost::math::Geometric_distribution, which does not use integers
-        // for its underlying calculations. We need to cast this to an int.
-        // This may very rarely overflow, since geometric distributions are
-        // unbounded, but I think this chance is so astronomically small
-        // that we don't need to worry about.
+    build_active_index();
+}
 
-        // The reason we add 1.0 here is that end_t_ is excluded, so, for the
-        // stick to have a life time of at least one frame, we need to ensure
-        // that end_t_ is at least 1.
-        end_t_ = subtree_start_time + unsigned(kjb::sample(frac_time_i_dist) + 1);
-        l_ = new Frag_lifetime_node(
-                *structure.get_left(),
-                end_t_,
-                subtree_end_time);
-        r_ = new Frag_lifetime_node(
-                *structure.get_right(),
-                end_t_,
-                subtree_end_time);
+void Frag_lifetime_tree::split(unsigned id, unsigned fracture_time)
+{
+    if(nodes_.size() <= Stick_tree_structure::get_right_id(id))
+        nodes_.resize(Stick_tree_structure::get_right_id(id) + 1);
+    Frag_lifetime_node & node = nodes_[id];
+    if(fracture_time <= node.start_t_ || fracture_time >= node.end_t_)
+        throw "fracture_time outside of the fragment's lifetime";
+    for(unsigned child_id : {Stick_tree_structure::get_left_id(id), Stick_tree_structure::get_right_id(id)})
+    {
+        nodes_[child_id].start_t_ = fracture_time;
+        nodes_[child_id].end_t_ = node.end_t_;
+    }
+    node.end_t_ = fracture_time;
+    // The children's ids come right after each other, so they go in
+    // together where the id was.
+    unsigned left_id(Stick_tree_structure::get_left_id(id));
+    for(unsigned t = fracture_time; t < nodes_[left_id].end_t_; t++)
+    {
+        std::vector<unsigned> & ids = active_ids_[t];
+        ids.erase(std::lower_bound(ids.begin(), ids.end(), id));
+        std::vector<unsigned>::iterator it(std::lower_bound(ids.begin(), ids.end(), left_id));
+        unsigned children[] = {left_id, left_id + 1};
+        ids.insert(it, children, children + 2);
     }
-    lifetime_ = end_t_ - start_t_;
 }
 
-Frag_lifetime_node::~Frag_lifetime_node()
+void Frag_lifetime_tree::merge(unsigned id)
 {
-    if(l_) {
-        delete l_;
-        delete r_;
+    unsigned left_id(Stick_tree_structure::get_left_id(id));
+    for(unsigned t = nodes_[id].end_t_; t < nodes_[left_id].end_t_; t++)
+    {
+        std::vector<unsigned> & ids = active_ids_[t];
+        std::vector<unsigned>::iterator it(std::lower_bound(ids.begin(), ids.end(), left_id));
+        ids.erase(it, it + 2);
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
     }
+    nodes_[id].end_t_ = nodes_[left_id].end_t_;
+    nodes_[Stick_tree_structure::get_left_id(id)] = Frag_lifetime_node();
+    nodes_[Stick_tree_structure::get_right_id(id)] = Frag_lifetime_node();
+    // As in Stick_tree_structure, keep the last id in the tree.
+    while(nodes_.back().get_lifetime() == 0)
+        nodes_.pop_back();
 }
 
-double Frag_lifetime_node::log_prior() const
+void Frag_lifetime_tree::build_active_index()
 {
-    if(!l_)
+    // Going through the ids in order keeps every frame's ids sorted.
+    unsigned num_frames(0);
+    for(const Frag_lifetime_node & node : nodes_)
+    {
+        num_frames = std::max(num_frames, node.end_t_);
+    }
+    active_ids_.assign(num_frames, std::vector<unsigned>());
+    for(unsigned id = 0; id < nodes_.size(); id++)
     {
-        return 0; // No fracture time for leaves, so don't modify the result.
+        for(unsigned t = nodes_[id].start_t_; t < nodes_[id].end_t_; t++)
+        {
+            active_ids_[t].push_back(id);
+        }
     }
-    else
+}
+
+double Frag_lifetime_tree::log_prior(const Stick_tree_structure & structure) const
+{
+    // No fracture time for leaves, so they don't modify the result.
+    double result(0.0);
+    for(size_t i = 0; i < structure.get_num_nonleaf_nodes(); i++)
     {
-        return kjb::pdf(frac_time_i_dist, double(lifetime_)) + l_->log_prior() + r_->log_prior();
+        const Frag_lifetime_node & node = nodes_[structure.get_nonleaf_id(i)];
+        result += prob::fr_t_log_prior(node.start_t_, node.end_t_);
     }
+    return result;
 }
 
 }}
@@ -1,43 +1,94 @@
 #ifndef FRAC_LIFETIME_NODE_HPP
 #define FRAC_LIFETIME_NODE_HPP
 
-#include <memory>
+#include <vector>
 
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include "stick_tree_structure.hpp"
 
 namespace stick_2d_frac { namespace sample {
 
+// The frames during which one fragment exists, from start_t_ up to, but not
+// including, end_t_.
 class Frag_lifetime_node {
     friend class boost::serialization::access;
+    friend class Frag_lifetime_tree;
 public:
-    // Forward sample
-    Frag_lifetime_node(const Stick_tree_structure & structure, unsigned subtree_start_time, unsigned subtree_end_time);
-    ~Frag_lifetime_node();
+    Frag_lifetime_node() : start_t_(0), end_t_(0) {}
 
     unsigned get_start_time() const { return start_t_; }
     unsigned get_end_time() const { return end_t_; }
-    unsigned get_lifetime() const { return lifetime_; }
-    bool is_leaf() const { return !l_; }
-    // May return null if we're a leaf.
-    const Frag_lifetime_node * get_left() const { return l_; }
-    const Frag_lifetime_node * get_right() const { return r_; }
-
-    double log_prior() const;
+    unsigned get_lifetime() const { return end_t_ - start_t_; }
+    bool is_active(unsigned timestamp) const { return start_t_ <= timestamp && timestamp < end_t_; }
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
-        ar & l_ & r_ & start_t_ & end_t_ & lifetime_;
+        ar & start_t_ & end_t_;
     }
 private:
-    // May be nullptr if we're a leaf.
-    Frag_lifetime_node * l_;
-    Frag_lifetime_node * r_;
-
     unsigned start_t_;
     unsigned end_t_;
-    unsigned lifetime_;
+};
+
+// A contiguous run of node ids, for range-based for.
+class Id_range {
+public:
+    Id_range(const unsigned * begin, const unsigned * end) : begin_(begin), end_(end) {}
+    const unsigned * begin() const { return begin_; }
+    const unsigned * end() const { return end_; }
+    size_t size() const { return size_t(end_ - begin_); }
+    bool empty() const { return begin_ == end_; }
+private:
+    const unsigned * begin_;
+    const unsigned * end_;
+};
+
+// The lifetimes of all of the fragments of a Stick_tree_structure, indexed
+// by node id. A fragment starts when its parent fractures.
+class Frag_lifetime_tree {
+    friend class boost::serialization::access;
+public:
+    // Forward sample
+    Frag_lifetime_tree(const Stick_tree_structure & structure, unsigned start_time, unsigned end_time);
+
+    const Frag_lifetime_node & get_node(unsigned id) const { return nodes_[id]; }
+
+    // The ids of the fragments active at timestamp, in increasing order.
+    // Empty past the last frame.
+    Id_range get_active_ids(unsigned timestamp) const
+    {
+        if(timestamp >= active_ids_.size())
+            return Id_range(nullptr, nullptr);
+        const std::vector<unsigned> & ids(active_ids_[timestamp]);
+        return Id_range(ids.data(), ids.data() + ids.size());
+    }
+
+    double log_prior(const Stick_tree_structure & structure) const;
+
+    // Keep up with Stick_tree_structure::split and merge. A split leaf
+    // fractures at fracture_time, and its fragments live for the rest of its
+    // lifetime. A merge gives the fragments' lifetime back to their parent.
+    // Only the frames the fragments live for are reindexed.
+    void split(unsigned id, unsigned fracture_time);
+    void merge(unsigned id);
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int) {
+        ar & nodes_;
+        if(Archive::is_loading::value)
+            build_active_index();
+    }
+private:
+    void build_active_index();
+
+    // Ids that aren't in the tree are left default constructed.
+    std::vector<Frag_lifetime_node> nodes_;
+    // The ids active at each timestamp, sorted. Kept per frame rather than
+    // in one flat array, so that a split or merge only touches the frames of
+    // the fragments it changes.
+    std::vector<std::vector<unsigned>> active_ids_;
 };
 
 }}
@@ -1,78 +1,80 @@
 #include <cmath>
 
+#include <m_cpp/m_matrix_d.h>
+// For who knows why m_matrix_d.impl.h is not included in m_matrix_d.h
+#include <m_cpp/m_matrix_d.impl.h>
+
 #include "hidden_stick_state.hpp"
 
 namespace stick_2d_frac { namespace sample {
 
-Hidden_stick_state::Static::Static() : state_transition_(7, 7)
+static kjb::Matrix_d<Hidden_stick_state::SV_COUNT, Hidden_stick_state::SV_COUNT> init_state_transition()
 {
-    state_transition_(SV_X_POSITION, SV_X_POSITION) = 1;
-    state_transition_(SV_X_POSITION, SV_X_VELOCITY) = 1;
+    typedef Hidden_stick_state H;
+    kjb::Matrix_d<H::SV_COUNT, H::SV_COUNT> r(0.0);
+    r(H::SV_X_POSITION, H::SV_X_POSITION) = 1;
+    r(H::SV_X_POSITION, H::SV_X_VELOCITY) = 1;
 
-    state_transition_(SV_Y_POSITION, SV_Y_POSITION) = 1;
-    state_transition_(SV_Y_POSITION, SV_Y_VELOCITY) = 1;
+    r(H::SV_Y_POSITION, H::SV_Y_POSITION) = 1;
+    r(H::SV_Y_POSITION, H::SV_Y_VELOCITY) = 1;
 
-    state_transition_(SV_X_VELOCITY, SV_X_VELOCITY) = 1;
+    r(H::SV_X_VELOCITY, H::SV_X_VELOCITY) = 1;
 
-    state_transition_(SV_Y_VELOCITY, SV_Y_VELOCITY) = 1;
-    state_transition_(SV_Y_VELOCITY, SV_Y_ACCELERATION) = 1;
+    r(H::SV_Y_VELOCITY, H::SV_Y_VELOCITY) = 1;
+    r(H::SV_Y_VELOCITY, H::SV_Y_ACCELERATION) = 1;
 
-    state_transition_(SV_Y_ACCELERATION, SV_Y_ACCELERATION) = 1;
+    r(H::SV_Y_ACCELERATION, H::SV_Y_ACCELERATION) = 1;
 
-    state_transition_(SV_ANGLE, SV_ANGLE) = 1;
-    state_transition_(SV_ANGLE, SV_ANGULAR_VELOCITY) = 1;
+    r(H::SV_ANGLE, H::SV_ANGLE) = 1;
+    r(H::SV_ANGLE, H::SV_ANGULAR_VELOCITY) = 1;
 
-    state_transition_(SV_ANGULAR_VELOCITY, SV_ANGULAR_VELOCITY) = 1;
+    r(H::SV_ANGULAR_VELOCITY, H::SV_ANGULAR_VELOCITY) = 1;
+    return r;
 }
 
+const kjb::Matrix_d<Hidden_stick_state::SV_COUNT, Hidden_stick_state::SV_COUNT> Hidden_stick_state::STATE_TRANSITION = init_state_transition();
+
 Hidden_stick_state::Hidden_stick_state(
         const Hidden_stick_state &prev_stick_state,
         const Stick_length_info & local_endpoints_homo,
         const Camera & c,
         int num_steps) :
-    data_(7, 0.0)
+    data_(prev_stick_state.data_)
 {
-    kjb::Matrix t = kjb::create_identity_matrix(7);
-    // Matrix exponentiation. We should use square and multiply algorithm for
-    // better efficiency, but I think that since we must calculate the value
-    // for each time step, sequential is okay for now.
+    // One step at a time. num_steps is almost always 1, and this is cheaper
+    // than raising the matrix to a power.
     for(int i(0); i < num_steps; i++) {
-        t = t * STATIC.get_state_transition();
+        data_ = STATE_TRANSITION * data_;
     }
-    data_ = t * prev_stick_state.data_;
     update_data_dependents(local_endpoints_homo.get_local_endpoints_homo(), c);
 }
 
 Hidden_stick_state::Hidden_stick_state(
         const Hidden_stick_state & parent_prev_state,
-        const Stick_length_info & parent_len,
+        const Stick_length_info & my_len,
         const Camera & c,
-        double frac_loc,
         Fragment_side fs)
 {
-    std::unique_ptr<kjb::Vector> ad(parent_prev_state.calculate_new_fracture_addend());
-    Stick_length_info my_len(0.0);
+    kjb::Vector_d<SV_COUNT> ad(parent_prev_state.calculate_new_fracture_addend());
     double offset;
     switch(fs)
     {
     case FS_LEFT:
-        my_len = Stick_length_info(parent_len.get_length() - frac_loc);
         offset = -0.5 * my_len.get_length();
         break;
     case FS_RIGHT:
-        my_len = Stick_length_info(frac_loc);
         offset = 0.5 * my_len.get_length();
         break;
     default:
         throw "unknown fracture side";
     }
-    data_ = STATIC.get_state_transition() * (parent_prev_state.data_ + offset * (*ad));
+    data_ = STATE_TRANSITION * (parent_prev_state.data_ + offset * ad);
     update_data_dependents(my_len.get_local_endpoints_homo(), c);
 }
 
-void Hidden_stick_state::update_data_dependents(const kjb::Matrix & local_endpoints_homo, const Camera & c)
+void Hidden_stick_state::update_data_dependents(const kjb::Matrix_d<3,2> & local_endpoints_homo, const Camera & c)
 {
-    kjb::Matrix world_transformation_matrix(3,3);
+    kjb::Matrix_d<3,3> world_transformation_matrix;
     world_transformation_matrix(0, 0) = std::cos(data_[SV_ANGLE]); world_transformation_matrix(0, 1) = -std::sin(data_[SV_ANGLE]); world_transformation_matrix(0, 2) = data_[SV_X_POSITION];
     world_transformation_matrix(1, 0) = std::sin(data_[SV_ANGLE]); world_transformation_matrix(1, 1) =  std::cos(data_[SV_ANGLE]); world_transformation_matrix(1, 2) = data_[SV_Y_POSITION];
     world_transformation_matrix(2, 0) =                       0.0; world_transformation_matrix(2, 1) =                        0.0; world_transformation_matrix(2, 2) =                  1.0;
@@ -80,8 +82,8 @@ void Hidden_stick_state::update_data_dependents(const kjb::Matrix & local_endpoi
     image_endpoints_homo_ = c.get_camera_matrix() * world_endpoints_homo_;
 }
 
-std::unique_ptr<kjb::Vector> Hidden_stick_state::calculate_new_fracture_addend() const {
-    double d[7];
+kjb::Vector_d<Hidden_stick_state::SV_COUNT> Hidden_stick_state::calculate_new_fracture_addend() const {
+    kjb::Vector_d<SV_COUNT> d;
     d[SV_X_POSITION] = std::cos(data_[SV_ANGLE]);
     d[SV_Y_POSITION] = std::sin(data_[SV_ANGLE]);
     d[SV_X_VELOCITY] = std::cos(data_[SV_ANGLE] + data_[SV_ANGULAR_VELOCITY]) - std::cos(data_[SV_ANGLE]);
@@ -89,7 +91,7 @@ std::unique_ptr<kjb::Vector> Hidden_stick_state::calculate_new_fracture_addend()
     d[SV_Y_ACCELERATION] = 0;
     d[SV_ANGLE] = 0;
     d[SV_ANGULAR_VELOCITY] = 0;
-    return std::unique_ptr<kjb::Vector>(new kjb::Vector(7, d));
+    return d;
 }
 
 }}
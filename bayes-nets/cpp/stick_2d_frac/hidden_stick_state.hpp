@@ -6,7 +6,8 @@
 
 #include <boost/serialization/access.hpp>
 
-#include <m_cpp/m_matrix.h>
+#include <m_cpp/m_matrix_d.h>
+#include <m_cpp/m_vector_d.h>
 
 #include "stick_camera.hpp"
 #include "stick_length_info.hpp"
@@ -23,27 +24,23 @@ public:
         SV_Y_VELOCITY = 3,
         SV_Y_ACCELERATION = 4,
         SV_ANGLE = 5,
-        SV_ANGULAR_VELOCITY = 6
+        SV_ANGULAR_VELOCITY = 6,
+
+        // DO NOT ADD ENTRIES BELOW THIS LINE
+        SV_COUNT
     };
     enum Fragment_side {
         FS_LEFT,
         FS_RIGHT
     };
 
-    // To get around the fact that C++ doesn't have good static initialization support.
-    // Couldn't initialize a kjb::Matrix as a one-liner with a multi-dimensional array,
-    // so we have to do this instead.
-    class Static {
-    public:
-        Static();
-        const kjb::Matrix & get_state_transition() const { return state_transition_; }
-    private:
-        kjb::Matrix state_transition_;
-    };
-    Static STATIC;
+    // One frame of the deterministic simulation. Shared by every state, and
+    // fixed-size like the rest of the state, so that constructing or copying
+    // a state allocates nothing.
+    static const kjb::Matrix_d<SV_COUNT, SV_COUNT> STATE_TRANSITION;
 
     Hidden_stick_state(
-            const kjb::Vector & data,
+            const kjb::Vector_d<SV_COUNT> & data,
             const Stick_length_info & local_endpoints_homo,
             const Camera & c) :
         data_(data)
@@ -57,24 +54,24 @@ public:
             const Stick_length_info & local_endpoints_homo,
             const Camera & c,
             int num_steps = 1);
-    // Initializes a HiddenStickState after a fracture of prev_stick_state happens at the given frac_loc.
-    // Our state depends on whether we're the left or right fragment of this new fracture.
+    // Initializes a HiddenStickState after a fracture of prev_stick_state, for the fragment
+    // of length my_len. Our state depends on whether we're the left or right fragment of
+    // this new fracture.
     Hidden_stick_state(
             const Hidden_stick_state & parent_prev_state,
-            const Stick_length_info & parent_len,
+            const Stick_length_info & my_len,
             const Camera & c,
-            double frac_loc,
             Fragment_side fs);
 
     double get_state_element(State_variable sv) const { return data_[sv]; }
-    const kjb::Vector & get_state() const { return data_; }
-    const kjb::Matrix & get_world_endpoints_homo() const { return world_endpoints_homo_; }
-    const kjb::Matrix & get_image_endpoints_homo() const { return image_endpoints_homo_; }
+    const kjb::Vector_d<SV_COUNT> & get_state() const { return data_; }
+    const kjb::Matrix_d<3,2> & get_world_endpoints_homo() const { return world_endpoints_homo_; }
+    const kjb::Matrix_d<3,2> & get_image_endpoints_homo() const { return image_endpoints_homo_; }
 
     void set_state_element(
             State_variable sv,
             double val,
-            const kjb::Matrix & local_endpoints_homo,
+            const kjb::Matrix_d<3,2> & local_endpoints_homo,
             const Camera & c)
     {
         data_[sv] = val;
@@ -94,8 +91,8 @@ public:
         }
     }
     void set_data(
-            const kjb::Vector & d,
-            const kjb::Matrix & local_endpoints_homo,
+            const kjb::Vector_d<SV_COUNT> & d,
+            const kjb::Matrix_d<3,2> & local_endpoints_homo,
             const Camera & c)
     {
         data_ = d;
@@ -107,15 +104,21 @@ public:
     // update the end point matrices.
     // It can also be called manually if, for example, the stick's length, and thus its local
     // endpoints, has changed.
-    void update_data_dependents(const kjb::Matrix & local_endpoints_homo, const Camera & c);
+    void update_data_dependents(const kjb::Matrix_d<3,2> & local_endpoints_homo, const Camera & c);
 
 
     double log_prior(const Camera & c, bool initial_state = true) const
     {
         if(initial_state)
         {
-            return kjb::pdf(*prob::new_state_0_p_x_dist(Camera::CAMERA_LEFT, c.get_camera_right()), get_state_element(SV_X_POSITION))
-                    + kjb::pdf(*prob::new_state_0_p_y_dist(c.get_camera_top(), Camera::CAMERA_BOTTOM), get_state_element(SV_Y_POSITION));
+            // The velocities are stored per frame, but their priors are per second.
+            double fps(c.get_frames_per_second());
+            return prob::log_pdf(prob::state_0_p_x_dist(Camera::CAMERA_LEFT, c.get_camera_right()), get_state_element(SV_X_POSITION))
+                    + prob::log_pdf(prob::state_0_p_y_dist(c.get_camera_top(), Camera::CAMERA_BOTTOM), get_state_element(SV_Y_POSITION))
+                    + prob::log_pdf(prob::STATE_0_V_X_IN_M_S_DIST, get_state_element(SV_X_VELOCITY) * fps)
+                    + prob::log_pdf(prob::STATE_0_V_Y_IN_M_S_DIST, get_state_element(SV_Y_VELOCITY) * fps)
+                    + prob::log_pdf(prob::STATE_0_ANG_DIST, get_state_element(SV_ANGLE))
+                    + prob::log_pdf(prob::STATE_0_ANG_VEL_IN_R_S_DIST, get_state_element(SV_ANGULAR_VELOCITY) * fps);
         }
         else {
             return 0.0;
@@ -124,20 +127,21 @@ public:
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
-        ar & data_ & world_endpoints_homo_ & image_endpoints_homo_;
+        util::serialize_vector_d(ar, data_);
+        util::serialize_matrix_d(ar, world_endpoints_homo_);
+        util::serialize_matrix_d(ar, image_endpoints_homo_);
     }
 private:
 
-    // Returns a newly-created vector that represents a modifier to
-    // the parent's stick state (for fracture).
-    std::unique_ptr<kjb::Vector> calculate_new_fracture_addend() const;
+    // Returns a vector that represents a modifier to the parent's stick
+    // state (for fracture).
+    kjb::Vector_d<SV_COUNT> calculate_new_fracture_addend() const;
 
-    // Represented internally as a 3x3 matrix, where the row denotes the derivative level:
-    // position, velocity or acceleration and the column denotes the dimension: x, y,
-    // angular.
-    kjb::Vector data_;
-    kjb::Matrix world_endpoints_homo_;
-    kjb::Matrix image_endpoints_homo_;
+    // Indexed by State_variable: the position, velocity and acceleration of
+    // the stick's center, and its angle and angular velocity.
+    kjb::Vector_d<SV_COUNT> data_;
+    kjb::Matrix_d<3,2> world_endpoints_homo_;
+    kjb::Matrix_d<3,2> image_endpoints_homo_;
 };
 
 }}
@@ -0,0 +1,319 @@
+#include <cmath>
+#include <algorithm>
+
+#include <prob_cpp/prob_distribution.h>
+
+#include "metropolis_hastings.hpp"
+#include "prob.hpp"
+
+namespace stick_2d_frac {
+
+static const double STD_MULTIPLIER = 0.01;
+
+const std::string Metropolis_hastings_resampler::PK_STRS[PK_COUNT] = {
+    "camera_top",
+    "length",
+    "x_position",
+    "y_position",
+    "x_velocity",
+    "y_velocity",
+    "angle",
+    "angular_velocity",
+    "fracture_location"
+};
+
+const std::string Metropolis_hastings_resampler::JK_STRS[JK_COUNT] = {
+    "split",
+    "merge"
+};
+
+// Basically, use the std of the prior of each variable at the expected
+// camera, then multiply that by the STD_MULTIPLIER.
+const std::vector<double> Metropolis_hastings_resampler::DEFAULT_STDS = {
+    // camera_top
+    STD_MULTIPLIER * prob::C_T_STD,
+    // length
+    STD_MULTIPLIER * prob::calc_len_0_std((4.0 / 3.0) * prob::C_T_MEAN, prob::C_T_MEAN),
+    // x_position
+    STD_MULTIPLIER * prob::calc_state_0_p_x_std(sample::Camera::CAMERA_LEFT, (4.0 / 3.0) * prob::C_T_MEAN),
+    // y_position
+    STD_MULTIPLIER * prob::calc_state_0_p_y_std(prob::C_T_MEAN, sample::Camera::CAMERA_BOTTOM),
+    // x_velocity
+    STD_MULTIPLIER * prob::STATE_0_V_X_IN_M_S_STD,
+    // y_velocity
+    STD_MULTIPLIER * prob::STATE_0_V_Y_IN_M_S_STD,
+    // angle
+    STD_MULTIPLIER * prob::STATE_0_ANG_STD,
+    // angular_velocity
+    STD_MULTIPLIER * prob::STATE_0_ANG_VEL_IN_R_S_STD,
+    // fracture_location
+    STD_MULTIPLIER * prob::calc_frac_loc_i_std(1.0)
+};
+
+Chain_run::Chain_run(const std::vector<double> & values, const sample::Discrete_sample & ds, double log_prob) :
+    values_(values), log_prob_(log_prob), count_(1)
+{
+    const sample::Stick_tree_structure & structure = ds.get_stick_tree_structure();
+    for(size_t i = 0; i < structure.get_num_nonleaf_nodes(); i++)
+    {
+        nonleaf_ids_.push_back(structure.get_nonleaf_id(i));
+        fracture_times_.push_back(ds.get_frac_lifetime_tree().get_node(nonleaf_ids_.back()).get_end_time());
+    }
+}
+
+size_t Chain_record::get_num_iterations() const
+{
+    size_t r = 0;
+    for(const Chain_run & run : runs_)
+    {
+        r += run.count_;
+    }
+    return r;
+}
+
+// The leaves a split can fracture, which have to live for at least two
+// frames, so that both they and their fragments get one.
+static std::vector<unsigned> get_split_candidates(const sample::Sample & s)
+{
+    const sample::Stick_tree_structure & structure = s.get_discrete_sample().get_stick_tree_structure();
+    std::vector<unsigned> r;
+    for(unsigned id : structure.get_preorder_ids())
+    {
+        if(structure.is_leaf(id) && sample::Stick_tree_structure::can_fracture(id)
+                && s.get_discrete_sample().get_frac_lifetime_tree().get_node(id).get_lifetime() >= 2)
+        {
+            r.push_back(id);
+        }
+    }
+    return r;
+}
+
+static std::vector<unsigned> get_merge_candidates(const sample::Sample & s)
+{
+    const sample::Stick_tree_structure & structure = s.get_discrete_sample().get_stick_tree_structure();
+    std::vector<unsigned> r;
+    for(size_t i = 0; i < structure.get_num_nonleaf_nodes(); i++)
+    {
+        if(structure.is_mergeable(structure.get_nonleaf_id(i)))
+            r.push_back(structure.get_nonleaf_id(i));
+    }
+    return r;
+}
+
+Metropolis_hastings_resampler::Proposal_kind Metropolis_hastings_resampler::get_proposal_kind(size_t var_idx)
+{
+    // The adapter's variables, up to the fracture locations, are in the
+    // same order as the kinds.
+    return var_idx < size_t(PK_FRACTURE_LOCATION) ? Proposal_kind(var_idx) : PK_FRACTURE_LOCATION;
+}
+
+Metropolis_hastings_resampler::Metropolis_hastings_resampler(
+        unsigned rng_seed,
+        unsigned num_resamples,
+        const sample::Sample & initial_sample,
+        const std::vector<double> & resample_stds,
+        const sample::Observation_source & obs,
+        unsigned num_jumps) :
+    num_resamples_(num_resamples),
+    resample_stds_(resample_stds),
+    cur_iter_(0),
+    cur_sample_(initial_sample),
+    cur_log_prob_(cur_sample_.log_posterior()),
+    obs_(obs),
+    num_jumps_(num_jumps)
+{
+    if(resample_stds_.size() != PK_COUNT)
+        throw "resample_stds.size() != PK_COUNT";
+    std::fill(num_proposed_, num_proposed_ + PK_COUNT, 0);
+    std::fill(num_accepted_, num_accepted_ + PK_COUNT, 0);
+    std::fill(num_jumps_proposed_, num_jumps_proposed_ + JK_COUNT, 0);
+    std::fill(num_jumps_accepted_, num_jumps_accepted_ + JK_COUNT, 0);
+    saved_samples_.rng_seed_ = rng_seed;
+    saved_samples_.runs_.push_back(Chain_run(get_cur_values(), cur_sample_.get_discrete_sample(), cur_log_prob_));
+}
+
+double Metropolis_hastings_resampler::get_acceptance_rate(Proposal_kind pk) const
+{
+    return num_proposed_[pk] ? double(num_accepted_[pk]) / double(num_proposed_[pk]) : 0.0;
+}
+
+double Metropolis_hastings_resampler::get_acceptance_rate(Jump_kind jk) const
+{
+    return num_jumps_proposed_[jk] ? double(num_jumps_accepted_[jk]) / double(num_jumps_proposed_[jk]) : 0.0;
+}
+
+Metropolis_hastings_resampler::Inference_resample_result Metropolis_hastings_resampler::resample_once()
+{
+    if(cur_iter_ >= num_resamples_)
+        throw "cur_iter_ >= num_resamples_";
+    bool accepted(false);
+    size_t num_vars(csva_.size(&cur_sample_.get_continuous_sample()));
+    for(size_t i = 0; i < num_vars; i++)
+    {
+        // Not ||=, since every variable gets its move.
+        if(try_resample(i))
+            accepted = true;
+    }
+    for(unsigned i = 0; i < num_jumps_; i++)
+    {
+        if(try_jump())
+            accepted = true;
+    }
+    if(accepted)
+    {
+        saved_samples_.runs_.push_back(Chain_run(get_cur_values(), cur_sample_.get_discrete_sample(), cur_log_prob_));
+    }
+    else
+    {
+        saved_samples_.runs_.back().count_++;
+    }
+    cur_iter_++;
+    return accepted ? IRR_ACCEPTED : IRR_REJECTED;
+}
+
+bool Metropolis_hastings_resampler::try_resample(size_t var_idx)
+{
+    sample::Continuous_sample & cs = cur_sample_.get_continuous_sample();
+    Proposal_kind pk(get_proposal_kind(var_idx));
+    double std(resample_stds_[pk]);
+    switch(pk)
+    {
+    case PK_X_VELOCITY:
+    case PK_Y_VELOCITY:
+    case PK_ANGULAR_VELOCITY:
+        std /= cs.get_camera().get_frames_per_second();
+        break;
+    case PK_FRACTURE_LOCATION:
+    {
+        // The fragment that fractures isn't changed by this move, so the
+        // proposal stays symmetric.
+        const sample::Stick_tree & tree = cs.get_stick_tree();
+        size_t frac_idx(var_idx - size_t(PK_FRACTURE_LOCATION));
+        std *= tree.get_length_info(tree.get_structure().get_nonleaf_id(frac_idx)).get_length();
+        break;
+    }
+    default:
+        break;
+    }
+    if(!(std > 0.0))
+        return false;
+
+    num_proposed_[pk]++;
+    double old_val(csva_.get(&cs, var_idx));
+    csva_.set(&cs, var_idx, old_val + prob::sample(prob::Normal_distribution(0.0, std)));
+    double new_log_prob(cur_sample_.log_posterior());
+    if(accept(new_log_prob - cur_log_prob_))
+    {
+        cur_log_prob_ = new_log_prob;
+        num_accepted_[pk]++;
+        return true;
+    }
+    csva_.set(&cs, var_idx, old_val);
+    return false;
+}
+
+bool Metropolis_hastings_resampler::try_jump()
+{
+    static const kjb::Uniform_distribution CHOICE_DIST;
+    // Splits and merges are proposed equally often, so that choice cancels
+    // in the acceptance ratio.
+    Jump_kind jk(prob::sample(CHOICE_DIST) < 0.5 ? JK_SPLIT : JK_MERGE);
+    num_jumps_proposed_[jk]++;
+    std::vector<unsigned> candidates(jk == JK_SPLIT ? get_split_candidates(cur_sample_) : get_merge_candidates(cur_sample_));
+    if(candidates.empty())
+        return false;
+    unsigned id(candidates[std::min(size_t(prob::sample(CHOICE_DIST) * double(candidates.size())), candidates.size() - 1)]);
+    unsigned left_id(sample::Stick_tree_structure::get_left_id(id));
+    const sample::Frag_lifetime_tree & flt = cur_sample_.get_discrete_sample().get_frac_lifetime_tree();
+    const sample::Stick_tree & tree = cur_sample_.get_continuous_sample().get_stick_tree();
+    // A fracture at the very end of its fragment leaves a child without
+    // length, which has nowhere to fracture.
+    if(!(tree.get_length_info(id).get_length() > 0.0))
+        return false;
+    prob::Truncated_normal_distribution frac_loc_dist(prob::frac_loc_i_dist(tree.get_length_info(id).get_length()));
+    unsigned start_time(flt.get_node(id).get_start_time());
+
+    // The log of the reverse jump's proposal density over the forward one's.
+    // The fracture time and location are the only new variables, so there's
+    // no Jacobian.
+    double log_proposal_ratio;
+    unsigned fracture_time;
+    double frac_loc;
+    if(jk == JK_SPLIT)
+    {
+        fracture_time = prob::fr_t_sample(start_time);
+        // Out of the leaf's lifetime, the proposal is to stay put.
+        if(fracture_time >= flt.get_node(id).get_end_time())
+            return false;
+        frac_loc = prob::sample(frac_loc_dist);
+        cur_sample_.split_leaf(id, fracture_time, frac_loc, obs_);
+        log_proposal_ratio = std::log(double(candidates.size()))
+                - std::log(double(get_merge_candidates(cur_sample_).size()))
+                - prob::fr_t_log_prior(start_time, fracture_time)
+                - prob::log_pdf(frac_loc_dist, frac_loc);
+    }
+    else
+    {
+        fracture_time = flt.get_node(left_id).get_start_time();
+        frac_loc = tree.get_length_info(left_id).get_length();
+        cur_sample_.merge_leaves(id, obs_);
+        log_proposal_ratio = std::log(double(candidates.size()))
+                - std::log(double(get_split_candidates(cur_sample_).size()))
+                + prob::fr_t_log_prior(start_time, fracture_time)
+                + prob::log_pdf(frac_loc_dist, frac_loc);
+    }
+
+    double new_log_prob(cur_sample_.log_posterior());
+    if(accept(new_log_prob - cur_log_prob_ + log_proposal_ratio))
+    {
+        cur_log_prob_ = new_log_prob;
+        num_jumps_accepted_[jk]++;
+        return true;
+    }
+    if(jk == JK_SPLIT)
+        cur_sample_.merge_leaves(id, obs_);
+    else
+        cur_sample_.split_leaf(id, fracture_time, frac_loc, obs_);
+    return false;
+}
+
+bool Metropolis_hastings_resampler::accept(double log_ratio)
+{
+    static const kjb::Uniform_distribution ACCEPTANCE_TEST;
+    double log_uniform(std::log(prob::sample(ACCEPTANCE_TEST)));
+    // In log space, accept if log(u) < log(p(x') q(x | x')) - log(p(x) q(x' | x)),
+    // u ~ Uniform(0, 1). Out of the priors' support is -inf, and a bad enough
+    // move can give a nan. Either is rejected, since the comparisons are false.
+    return log_ratio > 0.0 || log_uniform < log_ratio;
+}
+
+std::vector<double> Metropolis_hastings_resampler::get_cur_values() const
+{
+    const sample::Continuous_sample & cs = cur_sample_.get_continuous_sample();
+    std::vector<double> r(csva_.size(&cs));
+    for(size_t i = 0; i < r.size(); i++)
+    {
+        r[i] = csva_.get(&cs, i);
+    }
+    return r;
+}
+
+std::vector<double> get_mh_stds(double multiplier, unsigned multiplier_exp)
+{
+    std::vector<double> r = Metropolis_hastings_resampler::DEFAULT_STDS;
+    multiplier = std::pow(multiplier, double(multiplier_exp));
+    for(double & elem : r)
+    {
+        elem *= multiplier;
+    }
+    return r;
+}
+
+sample::Sample get_mh_initial_sample(const sample::Sample & data_sample)
+{
+    sample::Sample r(data_sample);
+    r.get_continuous_sample().forward_sample_hidden_rvs();
+    return r;
+}
+
+}
@@ -0,0 +1,179 @@
+#ifndef STICK_2D_FRAC_METROPOLIS_HASTINGS_HPP
+#define STICK_2D_FRAC_METROPOLIS_HASTINGS_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "sample.hpp"
+#include "continuous_sample_vector_adapter.hpp"
+
+namespace stick_2d_frac {
+
+// A run of consecutive iterations that a chain spent on one sample.
+// values_ are the sample's continuous variables, indexed as by
+// Continuous_sample_vector_adapter. The discrete sample is given by its
+// fractures: the ids of the non-leaf nodes, in pre-order, and the frame each
+// of them fractured at.
+class Chain_run
+{
+    friend class boost::serialization::access;
+public:
+    Chain_run() : log_prob_(0.0), count_(0) {}
+    Chain_run(const std::vector<double> & values, const sample::Discrete_sample & ds, double log_prob);
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int)
+    {
+        ar & values_ & nonleaf_ids_ & fracture_times_ & log_prob_ & count_;
+    }
+
+    std::vector<double> values_;
+    std::vector<unsigned> nonleaf_ids_;
+    std::vector<unsigned> fracture_times_;
+    double log_prob_;
+    unsigned count_;
+};
+
+// Run-length encoded chain.
+class Chain_record
+{
+    friend class boost::serialization::access;
+public:
+    Chain_record() : rng_seed_(0) {}
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int)
+    {
+        ar & rng_seed_ & runs_;
+    }
+
+    size_t get_num_iterations() const;
+
+    unsigned rng_seed_;
+    std::vector<Chain_run> runs_;
+};
+
+// Single-site Metropolis-Hastings over the continuous variables of a stick
+// sample. Each move changes one variable, so, with Stick_tree's incremental
+// propagation and cached likelihood terms, it costs about as much as the
+// part of the tree that variable affects. A rejected move is undone by
+// setting the old value back, which recomputes the same states.
+//
+// Each sweep can also make reversible jumps over the structure: a split
+// fractures a leaf, drawing the fracture time and location from their
+// priors, and a merge undoes the fracture of two leaves. Only the states of
+// the leaves involved are recomputed, and a rejected jump is undone by the
+// opposite one.
+//
+// Draws from the calling thread's generator (see prob::seed_sampling_rand),
+// so that chains can run on their own threads.
+class Metropolis_hastings_resampler
+{
+// types
+public:
+    enum Inference_resample_result
+    {
+        IRR_ACCEPTED,
+        IRR_REJECTED,
+
+        // ADD NEW ELEMENTS ABOVE THIS
+        IRR_COUNT
+    };
+    // Which proposal std a continuous variable uses.
+    enum Proposal_kind
+    {
+        PK_CAMERA_TOP,
+        PK_LENGTH,
+        PK_X_POSITION,
+        PK_Y_POSITION,
+        PK_X_VELOCITY,
+        PK_Y_VELOCITY,
+        PK_ANGLE,
+        PK_ANGULAR_VELOCITY,
+        PK_FRACTURE_LOCATION,
+
+        // ADD NEW ELEMENTS ABOVE THIS
+        PK_COUNT
+    };
+    static const std::string PK_STRS[PK_COUNT];
+    enum Jump_kind
+    {
+        JK_SPLIT,
+        JK_MERGE,
+
+        // ADD NEW ELEMENTS ABOVE THIS
+        JK_COUNT
+    };
+    static const std::string JK_STRS[JK_COUNT];
+
+public:
+    // Indexed by Proposal_kind. The velocities' are per second rather than
+    // per frame, and the fracture locations' are a fraction of the length of
+    // the fragment that fractures. A std of 0 holds that kind fixed.
+    static const std::vector<double> DEFAULT_STDS;
+
+    static Proposal_kind get_proposal_kind(size_t var_idx);
+
+    // obs gives the observations for the states that jumps create. No jumps
+    // are made if num_jumps, the number per sweep, is 0.
+    Metropolis_hastings_resampler(
+            unsigned rng_seed,
+            unsigned num_resamples,
+            const sample::Sample & initial_sample,
+            const std::vector<double> & resample_stds,
+            const sample::Observation_source & obs,
+            unsigned num_jumps = 0);
+
+    const Chain_record & get_saved_samples() const { return saved_samples_; }
+    unsigned get_num_resamples() const { return num_resamples_; }
+    const sample::Sample & get_cur_sample() const { return cur_sample_; }
+    double get_cur_log_prob() const { return cur_log_prob_; }
+    double get_acceptance_rate(Proposal_kind pk) const;
+    double get_acceptance_rate(Jump_kind jk) const;
+
+    bool still_resampling() const { return cur_iter_ < num_resamples_; }
+
+    // One sweep, proposing a move for every continuous variable in turn,
+    // then the jumps. IRR_ACCEPTED if any of them was accepted.
+    Inference_resample_result resample_once();
+    void resample_all()
+    {
+        while(still_resampling()) resample_once();
+    }
+// private methods
+private:
+    bool try_resample(size_t var_idx);
+    bool try_jump();
+    // Whether the MH test accepts a move with this log acceptance ratio.
+    static bool accept(double log_ratio);
+    std::vector<double> get_cur_values() const;
+// members
+private:
+    unsigned num_resamples_;
+    std::vector<double> resample_stds_;
+    unsigned cur_iter_;
+    sample::Sample cur_sample_;
+    double cur_log_prob_;
+    Chain_record saved_samples_;
+    Continuous_sample_vector_adapter csva_;
+    unsigned num_proposed_[PK_COUNT];
+    unsigned num_accepted_[PK_COUNT];
+    sample::Observation_source obs_;
+    unsigned num_jumps_;
+    unsigned num_jumps_proposed_[JK_COUNT];
+    unsigned num_jumps_accepted_[JK_COUNT];
+};
+
+// DEFAULT_STDS scaled by multiplier^multiplier_exp.
+std::vector<double> get_mh_stds(double multiplier, unsigned multiplier_exp);
+
+// The sample a chain on data_sample starts from: the data's structure and
+// observations, with the hidden variables drawn from their priors.
+sample::Sample get_mh_initial_sample(const sample::Sample & data_sample);
+
+}
+
+#endif // STICK_2D_FRAC_METROPOLIS_HASTINGS_HPP
@@ -5,9 +5,9 @@
 
 #include <boost/serialization/access.hpp>
 
-#include <m_cpp/m_matrix.h>
-#include <prob_cpp/prob_distribution.h>
+#include <m_cpp/m_matrix_d.h>
 
+#include "prob.hpp"
 #include "hidden_stick_state.hpp"
 #include "stick_camera.hpp"
 
@@ -26,25 +26,31 @@ public:
     // camera_height and camera_width are in world coordinates, used to
     // determine the value for the Gaussian noise added to each end point.
     Observed_stick_state(
-            const kjb::Matrix & hidden_image_endpoints_homo,
-            const kjb::Normal_distribution & offset_dist);
+            const kjb::Matrix_d<3,2> & hidden_image_endpoints_homo,
+            const prob::Normal_distribution & offset_dist);
             // Can't make offset_dist a constant, since it depends on image_width and image_height.
             // Thus, we just construct one distribution and share it across all observed stick states.
+    // A frame in which the fragment wasn't observed, e.g. because the data
+    // didn't have it (see prob::OBS_MISS_P).
+    Observed_stick_state() : image_endpoints_homo_(0.0), observed_(false) {}
 
-    const kjb::Matrix & get_image_endpoints_homo() const { return image_endpoints_homo_; }
+    bool is_observed() const { return observed_; }
+    const kjb::Matrix_d<3,2> & get_image_endpoints_homo() const { return image_endpoints_homo_; }
 
     double log_likelihood(
             const Hidden_stick_state & hss,
-            const kjb::Normal_distribution & offset_dist) const;
+            const prob::Normal_distribution & offset_dist) const;
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
-        ar & image_endpoints_homo_;
+        util::serialize_matrix_d(ar, image_endpoints_homo_);
+        ar & observed_;
     }
 private:
     // Represented in homogeneous coordinates as a 3x2 matrix in world
     // coordinates.
-    kjb::Matrix image_endpoints_homo_;
+    kjb::Matrix_d<3,2> image_endpoints_homo_;
+    bool observed_;
 };
 
 }}
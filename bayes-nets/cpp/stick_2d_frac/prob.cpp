@@ -1,26 +1,71 @@
+#include <cmath>
+#include <cstdint>
+
 #include <boost/math/distributions.hpp>
 #include <boost/math/policies/policy.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_01.hpp>
 
 #include "prob.hpp"
 
 namespace stick_2d_frac { namespace prob {
 
-double pdf(const Truncated_normal_distribution & dist, double p) {
-    if (p >= dist.get_low() && p < dist.get_high()) {
-        return pdf(dist.get_base_dist(), p) / dist.get_normalizer();
-    } else {
-        return 0;
-    }
-}
-
 double sample(const Truncated_normal_distribution &dist) {
-    static const kjb::Uniform_distribution truncated_normal_sampling_dist;
     double s;
     do
     {
-        s = kjb::sample(dist.get_base_dist());
+        s = sample(dist.get_base_dist());
     } while (s < dist.get_low() || s > dist.get_high());
     return s;
 }
 
+static thread_local boost::random::mt19937 sampling_rand;
+
+void seed_sampling_rand(unsigned seed)
+{
+    sampling_rand.seed(seed);
+}
+
+// Inverts the cdf at a uniform draw in (0, 1), as kjb::sample does.
+template<class Distribution>
+static double sample_by_quantile(const Distribution & dist)
+{
+    boost::random::uniform_01<double> u01;
+    double u;
+    do
+    {
+        u = u01(sampling_rand);
+    } while(u == 0.0);
+    return boost::math::quantile(dist, u);
+}
+
+double sample(const kjb::Normal_distribution & dist)
+{
+    return sample_by_quantile(dist);
+}
+
+double sample(const Normal_distribution & dist)
+{
+    return sample_by_quantile(kjb::Normal_distribution(dist.get_mean(), dist.get_std()));
+}
+
+double sample(const kjb::Uniform_distribution & dist)
+{
+    return sample_by_quantile(dist);
+}
+
+double sample(const kjb::Geometric_distribution & dist)
+{
+    return sample_by_quantile(dist);
+}
+
+// splitmix64's finalizer
+unsigned derive_seed(unsigned base_seed, unsigned key)
+{
+    uint64_t z = (uint64_t(base_seed) << 32 | key) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return unsigned(z ^ (z >> 31));
+}
+
 }}
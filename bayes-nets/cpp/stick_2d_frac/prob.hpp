@@ -9,18 +9,55 @@
 #include <boost/random/discrete_distribution.hpp>
 
 #include <prob_cpp/prob_sample.h>
+#include <prob_cpp/prob_pdf.h>
 
 namespace stick_2d_frac { namespace prob {
 
+// A normal distribution with its log-normalizer precomputed, so that its
+// log density is a few flops and it can be built on the stack wherever its
+// parameters depend on the sample.
+class Normal_distribution {
+public:
+    Normal_distribution(double mean, double std) :
+        mean_(mean),
+        std_(std),
+        inv_std_(1.0 / std),
+        log_normalizer_(-std::log(std) - 0.5 * std::log(2.0 * M_PI))
+    {
+    }
+    double get_mean() const { return mean_; }
+    double get_std() const { return std_; }
+    double get_log_normalizer() const { return log_normalizer_; }
+    double get_standardized(double p) const { return (p - mean_) * inv_std_; }
+private:
+    double mean_;
+    double std_;
+    double inv_std_;
+    double log_normalizer_;
+};
+inline double log_pdf(const Normal_distribution & dist, double p)
+{
+    double z(dist.get_standardized(p));
+    return dist.get_log_normalizer() - 0.5 * z * z;
+}
+double sample(const Normal_distribution & dist);
+
+// The truncation's log mass is folded into the log-normalizer. Computing it
+// takes two cdfs, so a family of distributions whose bounds are fixed in
+// stds from the mean (see the len_0 and frac_loc_i priors) shares one log
+// mass, computed once, instead.
 class Truncated_normal_distribution {
 public:
     Truncated_normal_distribution(double mean, double std, double low, double high) :
+        Truncated_normal_distribution(mean, std, low, high, calc_log_mass(mean, std, low, high))
+    {
+    }
+    Truncated_normal_distribution(double mean, double std, double low, double high, double log_mass) :
         base_dist_(mean, std),
         low_(low),
         high_(high),
-        low_cdf_(kjb::cdf(base_dist_, low_)),
-        high_cdf_(kjb::cdf(base_dist_, high_)),
-        normalizer_(high_cdf_ - low_cdf_)
+        log_mass_(log_mass),
+        log_normalizer_(base_dist_.get_log_normalizer() - log_mass)
     {
         if(std < 0)
         {
@@ -31,25 +68,49 @@ public:
             throw "low >= high";
         }
     }
+    static double calc_log_mass(double mean, double std, double low, double high)
+    {
+        kjb::Normal_distribution base(mean, std);
+        return std::log(kjb::cdf(base, high) - kjb::cdf(base, low));
+    }
     double get_low() const { return low_; }
     double get_high() const { return high_; }
-    double get_low_cdf() const { return low_cdf_; }
-    double get_high_cdf() const { return high_cdf_; }
-    double get_mean() const { return base_dist_.mean(); }
-    double get_std() const { return base_dist_.standard_deviation(); }
-    double get_normalizer() const { return normalizer_; }
-    const kjb::Normal_distribution & get_base_dist() const { return base_dist_; }
+    double get_mean() const { return base_dist_.get_mean(); }
+    double get_std() const { return base_dist_.get_std(); }
+    double get_log_mass() const { return log_mass_; }
+    double get_log_normalizer() const { return log_normalizer_; }
+    const Normal_distribution & get_base_dist() const { return base_dist_; }
 private:
-    kjb::Normal_distribution base_dist_;
+    Normal_distribution base_dist_;
     double low_;
     double high_;
-    double low_cdf_;
-    double high_cdf_;
-    double normalizer_;
+    double log_mass_;
+    double log_normalizer_;
 };
-double pdf(const Truncated_normal_distribution & dist, double p);
+// -inf outside of [low, high)
+inline double log_pdf(const Truncated_normal_distribution & dist, double p)
+{
+    if(p >= dist.get_low() && p < dist.get_high())
+    {
+        double z(dist.get_base_dist().get_standardized(p));
+        return dist.get_log_normalizer() - 0.5 * z * z;
+    }
+    return double(-INFINITY);
+}
 double sample(const Truncated_normal_distribution & dist);
 
+// Draws from a generator owned by the calling thread, rather than kjb's
+// process-wide one, so that threads can sample at once and each stream is
+// reproducible from its seed. Each thread must seed its own generator.
+void seed_sampling_rand(unsigned seed);
+double sample(const kjb::Normal_distribution & dist);
+double sample(const kjb::Uniform_distribution & dist);
+double sample(const kjb::Geometric_distribution & dist);
+
+// The seed of sub-task key (a chain, a dataset, ...) of a run seeded with
+// base_seed.
+unsigned derive_seed(unsigned base_seed, unsigned key);
+
 const double C_T_MEAN = 8.0;
 const double C_T_STD = 2.0;
 const double C_T_LOW = 0.0;
@@ -69,14 +130,16 @@ inline double calc_len_0_std(double c_width, double c_height)
 {
     return std::sqrt(c_width * c_height) / 16;
 }
-inline std::unique_ptr<Truncated_normal_distribution> new_len_0_dist(double c_width, double c_height)
+// The mean is always 4 stds above the lower bound of 0.
+const double LEN_0_LOG_MASS = Truncated_normal_distribution::calc_log_mass(4.0, 1.0, 0.0, double(INFINITY));
+inline Truncated_normal_distribution len_0_dist(double c_width, double c_height)
 {
-    return std::unique_ptr<Truncated_normal_distribution>(
-            new Truncated_normal_distribution(
-                    calc_len_0_mean(c_width, c_height),
-                    calc_len_0_std(c_width, c_height),
-                    0.0,
-                    double(INFINITY)));
+    return Truncated_normal_distribution(
+            calc_len_0_mean(c_width, c_height),
+            calc_len_0_std(c_width, c_height),
+            0.0,
+            double(INFINITY),
+            LEN_0_LOG_MASS);
 }
 
 inline double calc_frac_loc_i_mean(double stick_len) {
@@ -85,13 +148,15 @@ inline double calc_frac_loc_i_mean(double stick_len) {
 inline double calc_frac_loc_i_std(double stick_len) {
     return stick_len / 4;
 }
-inline std::unique_ptr<Truncated_normal_distribution> new_frac_loc_i_dist(double stick_len) {
-    return std::unique_ptr<Truncated_normal_distribution>(
-            new Truncated_normal_distribution(
-                    calc_frac_loc_i_mean(stick_len),
-                    calc_frac_loc_i_std(stick_len),
-                    0.0,
-                    stick_len));
+// The bounds, 0 and stick_len, are always 2 stds from the mean.
+const double FRAC_LOC_I_LOG_MASS = Truncated_normal_distribution::calc_log_mass(0.0, 1.0, -2.0, 2.0);
+inline Truncated_normal_distribution frac_loc_i_dist(double stick_len) {
+    return Truncated_normal_distribution(
+            calc_frac_loc_i_mean(stick_len),
+            calc_frac_loc_i_std(stick_len),
+            0.0,
+            stick_len,
+            FRAC_LOC_I_LOG_MASS);
 }
 
 inline double calc_0_p_x_mean(double c_l, double c_r)
@@ -102,12 +167,11 @@ inline double calc_state_0_p_x_std(double c_l, double c_r)
 {
     return (c_r - c_l) / 16;
 }
-inline std::unique_ptr<kjb::Normal_distribution> new_state_0_p_x_dist(double c_l, double c_r)
+inline Normal_distribution state_0_p_x_dist(double c_l, double c_r)
 {
-    return std::unique_ptr<kjb::Normal_distribution>(
-            new kjb::Normal_distribution(
-                    calc_0_p_x_mean(c_l, c_r),
-                    calc_state_0_p_x_std(c_l, c_r)));
+    return Normal_distribution(
+            calc_0_p_x_mean(c_l, c_r),
+            calc_state_0_p_x_std(c_l, c_r));
 }
 
 inline double calc_state_0_p_y_mean(double c_t, double c_b) {
@@ -116,37 +180,36 @@ inline double calc_state_0_p_y_mean(double c_t, double c_b) {
 inline double calc_state_0_p_y_std(double c_t, double c_b) {
     return (c_t - c_b) / 16;
 }
-inline std::unique_ptr<kjb::Normal_distribution> new_state_0_p_y_dist(double c_t, double c_b) {
-    return std::unique_ptr<kjb::Normal_distribution>(
-            new kjb::Normal_distribution(
-                    calc_state_0_p_y_mean(c_t, c_b),
-                    calc_state_0_p_y_std(c_t, c_b)));
+inline Normal_distribution state_0_p_y_dist(double c_t, double c_b) {
+    return Normal_distribution(
+            calc_state_0_p_y_mean(c_t, c_b),
+            calc_state_0_p_y_std(c_t, c_b));
 }
 
 const double STATE_0_V_X_IN_M_S_MEAN = 0.0;
 const double STATE_0_V_X_IN_M_S_STD = 2.0;
-const kjb::Normal_distribution STATE_0_V_X_IN_M_S_DIST(
+const Normal_distribution STATE_0_V_X_IN_M_S_DIST(
         STATE_0_V_X_IN_M_S_MEAN,
         STATE_0_V_X_IN_M_S_STD
 );
 
 const double STATE_0_V_Y_IN_M_S_MEAN = 1.0;
 const double STATE_0_V_Y_IN_M_S_STD = 2.0;
-const kjb::Normal_distribution STATE_0_V_Y_IN_M_S_DIST(
+const Normal_distribution STATE_0_V_Y_IN_M_S_DIST(
         STATE_0_V_Y_IN_M_S_MEAN,
         STATE_0_V_Y_IN_M_S_STD
 );
 
 const double STATE_0_ANG_MEAN = 0.0;
 const double STATE_0_ANG_STD = M_PI / 2;
-const kjb::Normal_distribution STATE_0_ANG_DIST(
+const Normal_distribution STATE_0_ANG_DIST(
         STATE_0_ANG_MEAN,
         STATE_0_ANG_STD
 );
 
 const double STATE_0_ANG_VEL_IN_R_S_MEAN = 0.0;
 const double STATE_0_ANG_VEL_IN_R_S_STD = 8 * M_PI;
-const kjb::Normal_distribution STATE_0_ANG_VEL_IN_R_S_DIST(
+const Normal_distribution STATE_0_ANG_VEL_IN_R_S_DIST(
         STATE_0_ANG_VEL_IN_R_S_MEAN,
         STATE_0_ANG_VEL_IN_R_S_STD
 );
@@ -157,11 +220,10 @@ const kjb::Normal_distribution STATE_0_ANG_VEL_IN_R_S_DIST(
 inline double calc_noise_offset_std(unsigned im_height, unsigned im_width) {
     return std::sqrt(double(im_width) * double(im_height)) / 64;
 }
-inline std::unique_ptr<kjb::Normal_distribution> new_noise_offset_dist(unsigned im_height, unsigned im_width) {
-    return std::unique_ptr<kjb::Normal_distribution>(
-            new kjb::Normal_distribution(
-                    0.0,
-                    calc_noise_offset_std(im_height, im_width)));
+inline Normal_distribution noise_offset_dist(unsigned im_height, unsigned im_width) {
+    return Normal_distribution(
+            0.0,
+            calc_noise_offset_std(im_height, im_width));
 }
 
 const double FR_T_OFFSET_P = 0.5;
@@ -169,7 +231,24 @@ const double FR_T_OFFSET_P = 0.5;
 const boost::math::geometric_distribution<> FR_T_OFFSET_DIST(FR_T_OFFSET_P);
 // Because of the offset distribution, need to add the previous fracture time.
 inline unsigned fr_t_sample(unsigned prev_fr_t) {
-    return prev_fr_t + 1 + unsigned(kjb::sample(FR_T_OFFSET_DIST));
+    return prev_fr_t + 1 + unsigned(sample(FR_T_OFFSET_DIST));
+}
+inline double fr_t_log_prior(unsigned prev_fr_t, unsigned fr_t) {
+    return kjb::log_pdf(FR_T_OFFSET_DIST, double(fr_t - prev_fr_t - 1));
+}
+
+// The prior on the tree structure, when it isn't fixed: every fragment that
+// isn't on the bottom level fractures with this chance.
+const double FRAC_CHANCE = 0.5;
+
+// So that a stick tree whose structure differs from the data's still
+// explains it, the likelihood treats the observations as detections. A
+// fragment goes unobserved in a frame with OBS_MISS_P, and an observation
+// that no fragment explains is clutter, with both endpoints uniform over the
+// image. Forward sampling neither misses nor adds clutter.
+const double OBS_MISS_P = 0.01;
+inline double calc_clutter_log_density(unsigned im_height, unsigned im_width) {
+    return -2.0 * std::log(double(im_width) * double(im_height));
 }
 
 // TODO find out where to put these to avoid a circular include
@@ -17,8 +17,8 @@ class Sample {
     friend class boost::serialization::access;
 public:
     // Constructs a new Sample using the forward sampling strategy.
-    Sample(unsigned num_ims, unsigned im_w, unsigned im_h, double cam_fps) :
-        ds_(num_ims),
+    Sample(unsigned num_ims, unsigned im_w, unsigned im_h, double cam_fps, int depth = Discrete_sample::DEPTH_DEF) :
+        ds_(num_ims, depth),
         cs_(ds_, im_w, im_h, cam_fps) { }
 
     // Returns a reference to the DiscreteSample object owned by this sample.
@@ -26,6 +26,27 @@ public:
 
     // Returns a reference to the ContinuousSample object owned by this sample.
     const Continuous_sample & get_continuous_sample() const { return cs_; }
+    Continuous_sample & get_continuous_sample() { return cs_; }
+
+    // The observations of this sample, to fit another one's structure to.
+    // This sample must outlive it.
+    Observation_source get_observation_source() const
+    {
+        return Observation_source(cs_.get_stick_tree(), ds_.get_frac_lifetime_tree());
+    }
+
+    // Change the structure of both samples. The continuous sample takes the
+    // observations of any new states from obs.
+    void split_leaf(unsigned id, unsigned fracture_time, double frac_loc, const Observation_source & obs)
+    {
+        ds_.split_leaf(id, fracture_time);
+        cs_.split_leaf(id, frac_loc, ds_.get_frac_lifetime_tree(), obs);
+    }
+    void merge_leaves(unsigned id, const Observation_source & obs)
+    {
+        ds_.merge_leaves(id);
+        cs_.merge_leaves(id, ds_.get_frac_lifetime_tree(), obs);
+    }
 
     double log_prior() const { return get_discrete_sample().log_prior() + get_continuous_sample().log_prior(); }
     double log_likelihood() const { return get_continuous_sample().log_likelihood(); }
@@ -39,7 +60,7 @@ private:
     Discrete_sample ds_;
     Continuous_sample cs_;
 };
-double log_posterior(const Sample & s) { return s.log_posterior(); }
+inline double log_posterior(const Sample & s) { return s.log_posterior(); }
 
 }}
 
@@ -11,7 +11,6 @@ Camera::Camera(unsigned image_width, unsigned image_height, double frames_per_se
     im_w_(image_width),
     im_h_(image_height),
     im_aspect_ratio_(double(image_width) / double(image_height)),
-    c_mat_(kjb::Matrix(3,3)),
     fps_(frames_per_second)
 {
     // (1, 0), (0, 1), (0, 2), (1, 2) depend on c_t, so that's updated in the setter for c_t.
@@ -44,7 +43,11 @@ std::unique_ptr<kjb::Vector> Camera::project(const kjb::Vector & world_coordinat
         ex_stream << "wrong dimensionality for world_coordinate: " << world_coordinate.size();
         throw ex_stream.str();
     }
-    *result = c_mat_ * *result;
+    kjb::Vector homo(*result);
+    for(int i = 0; i < 3; i++)
+    {
+        (*result)[i] = c_mat_(i, 0) * homo[0] + c_mat_(i, 1) * homo[1] + c_mat_(i, 2) * homo[2];
+    }
     switch(world_coordinate.size()) {
     case 2:
         *result /= (*result)[result->size() - 1];
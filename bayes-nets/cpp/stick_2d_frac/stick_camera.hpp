@@ -6,9 +6,11 @@
 #include <boost/serialization/access.hpp>
 
 #include <m_cpp/m_matrix.h>
+#include <m_cpp/m_matrix_d.h>
 #include <prob_cpp/prob_pdf.h>
 
 #include "prob.hpp"
+#include "util.hpp"
 
 namespace stick_2d_frac { namespace sample {
 
@@ -32,7 +34,7 @@ public:
     double get_camera_height() const { return c_t_ - CAMERA_BOTTOM; }
     double get_camera_width() const { return c_r_ - CAMERA_LEFT; }
     double get_meters_per_pixel() const {return meter_px_; }
-    const kjb::Matrix & get_camera_matrix() const { return c_mat_; }
+    const kjb::Matrix_d<3,3> & get_camera_matrix() const { return c_mat_; }
     double get_frames_per_second() const { return fps_; }
 
     void set_camera_top(double val);
@@ -43,11 +45,13 @@ public:
     // For any other dimensionality, an exception is thrown.
     std::unique_ptr<kjb::Vector> project(const kjb::Vector & world_coordinate) const;
 
-    double log_prior() const { return prob::pdf(prob::C_T_DIST, c_t_); }
+    double log_prior() const { return prob::log_pdf(prob::C_T_DIST, c_t_); }
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
-        ar & im_w_ & im_h_ & c_t_ & c_r_ & meter_px_ & c_mat_ & fps_;
+        ar & im_w_ & im_h_ & c_t_ & c_r_ & meter_px_;
+        util::serialize_matrix_d(ar, c_mat_);
+        ar & fps_;
     }
 private:
     unsigned im_w_;
@@ -56,7 +60,7 @@ private:
     double c_t_;
     double c_r_;
     double meter_px_;
-    kjb::Matrix c_mat_;
+    kjb::Matrix_d<3,3> c_mat_;
     double fps_;
 };
 
@@ -6,6 +6,7 @@
 #include <boost/serialization/access.hpp>
 
 #include <m_cpp/m_matrix.h>
+#include <m_cpp/m_matrix_d.h>
 
 #include "util.hpp"
 
@@ -21,38 +22,41 @@ class Stick_length_info
     friend class boost::serialization::access;
 public:
     Stick_length_info(double len) :
-        len_(len),
-        local_endpoints_homo_(3, 2)
+        len_(len)
     {
         local_endpoints_homo_(0, 0) = -len / 2.0; local_endpoints_homo_(0, 1) = len / 2.0;
         local_endpoints_homo_(1, 0) =        0.0; local_endpoints_homo_(1, 1) =       0.0;
         local_endpoints_homo_(2, 0) =        1.0; local_endpoints_homo_(2, 1) =       1.0;
     }
     Stick_length_info(const kjb::Matrix & local_endpoints, bool endpoints_homogeneous = true):
-        len_(local_endpoints(0, 1)),
-        local_endpoints_homo_(local_endpoints)
+        len_(local_endpoints(0, 1))
     {
         if(endpoints_homogeneous)
         {
             len_ /= local_endpoints(2, 1);
         }
-        else
+        for(int col = 0; col < 2; col++)
         {
-            local_endpoints_homo_.resize(local_endpoints.get_num_rows() + 1, local_endpoints.get_num_cols(), 1.0);
+            for(int row = 0; row < 2; row++)
+            {
+                local_endpoints_homo_(row, col) = local_endpoints(row, col);
+            }
+            local_endpoints_homo_(2, col) = endpoints_homogeneous ? local_endpoints(2, col) : 1.0;
         }
     }
 
     double get_length() const { return len_; }
-    const kjb::Matrix & get_local_endpoints_homo() const { return local_endpoints_homo_; }
+    const kjb::Matrix_d<3,2> & get_local_endpoints_homo() const { return local_endpoints_homo_; }
     std::unique_ptr<kjb::Matrix> get_local_endpoints_non_homo() const { return util::homo_col_vecs_to_non_homo_col_vecs(local_endpoints_homo_); }
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
-        ar & len_ & local_endpoints_homo_;
+        ar & len_;
+        util::serialize_matrix_d(ar, local_endpoints_homo_);
     }
 private:
     double len_;
-    kjb::Matrix local_endpoints_homo_;
+    kjb::Matrix_d<3,2> local_endpoints_homo_;
 };
 
 }}
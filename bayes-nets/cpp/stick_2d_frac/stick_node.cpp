@@ -1,3 +1,5 @@
+#include <cassert>
+#include <cmath>
 #include <vector>
 
 #include <prob_cpp/prob_sample.h>
@@ -8,249 +10,365 @@
 
 namespace stick_2d_frac { namespace sample {
 
-Stick_node::Stick_node(
+Stick_tree::Stick_tree(
         const Stick_tree_structure & tree_structure,
-        const Frag_lifetime_node & frac_tree,
+        const Frag_lifetime_tree & frac_tree,
         const Stick_length_info & stick_len,
         const Hidden_stick_state & init_state,
         const Camera & c,
-        const kjb::Normal_distribution & observed_image_endpoints_offset_dist):
-    stick_len_(stick_len)
+        const prob::Normal_distribution & observed_image_endpoints_offset_dist):
+    structure_(tree_structure),
+    nodes_(tree_structure.get_max_id_in_tree() + 1),
+    num_observations_(0)
 {
-    hss_.reserve(size_t(frac_tree.get_lifetime()));
-    oss_.reserve(size_t(frac_tree.get_lifetime()));
-    hss_.push_back(init_state);
-    oss_.push_back(Observed_stick_state(hss_[0].get_image_endpoints_homo(), observed_image_endpoints_offset_dist));
-    for(unsigned i = 1; i < frac_tree.get_lifetime(); i++) {
-        hss_.push_back(Hidden_stick_state(hss_[i - 1], stick_len_, c, 1));
-        oss_.push_back(Observed_stick_state(hss_[i].get_image_endpoints_homo(), observed_image_endpoints_offset_dist));
-    }
-    if(tree_structure.get_left())
+    size_t num_states(0);
+    for(unsigned id : structure_.get_preorder_ids())
     {
-
-        double fr_loc(prob::sample(*prob::new_frac_loc_i_dist(stick_len.get_length())));
-        // Use the constructor of Hidden_stick_state for when a fracture happens
-        l_ = new Stick_node
-        (
-            *(tree_structure.get_left()),
-            *(frac_tree.get_left()),
-            fr_loc,
-            Hidden_stick_state
-            (
-                hss_[hss_.size() - 1],
-                stick_len,
-                c,
-                fr_loc,
-                Hidden_stick_state::FS_LEFT
-            ),
-            c,
-            observed_image_endpoints_offset_dist
-        );
-        r_ = new Stick_node
-        (
-            *(tree_structure.get_right()),
-            *(frac_tree.get_right()),
-            fr_loc,
-            Hidden_stick_state
-            (
-                hss_[hss_.size() - 1],
-                stick_len,
-                c,
-                fr_loc,
-                Hidden_stick_state::FS_RIGHT
-            ),
-            c,
-            observed_image_endpoints_offset_dist
-        );
+        nodes_[id].first_state_ = num_states;
+        nodes_[id].num_states_ = frac_tree.get_node(id).get_lifetime();
+        num_states += nodes_[id].num_states_;
     }
-    else
+    hss_.reserve(num_states);
+    oss_.reserve(num_states);
+    nodes_[Stick_tree_structure::ROOT_ID].stick_len_ = stick_len;
+    // In pre-order, a node's parent has all of its states, and has sampled
+    // the node's length, by the time we get to it.
+    for(unsigned id : structure_.get_preorder_ids())
     {
-        l_ = nullptr;
-        r_ = nullptr;
-    }
-}
-
-Stick_node::~Stick_node() {
-    if(l_) {
-        delete l_;
-        delete r_;
+        Stick_node & node = nodes_[id];
+        if(id == Stick_tree_structure::ROOT_ID)
+        {
+            hss_.push_back(init_state);
+        }
+        else
+        {
+            // Use the constructor of Hidden_stick_state for when a fracture happens
+            hss_.push_back(get_fracture_state(id, c));
+        }
+        oss_.push_back(Observed_stick_state(hss_.back().get_image_endpoints_homo(), observed_image_endpoints_offset_dist));
+        for(size_t i = 1; i < node.num_states_; i++)
+        {
+            hss_.push_back(Hidden_stick_state(hss_.back(), node.stick_len_, c, 1));
+            oss_.push_back(Observed_stick_state(hss_.back().get_image_endpoints_homo(), observed_image_endpoints_offset_dist));
+        }
+        if(!structure_.is_leaf(id))
+        {
+            double fr_loc(prob::sample(prob::frac_loc_i_dist(node.stick_len_.get_length())));
+            nodes_[Stick_tree_structure::get_left_id(id)].stick_len_ = Stick_length_info(fr_loc);
+            nodes_[Stick_tree_structure::get_right_id(id)].stick_len_ = Stick_length_info(node.stick_len_.get_length() - fr_loc);
+        }
     }
+    // Forward sampling observes every state.
+    num_observations_ = num_states;
 }
 
-void Stick_node::get_all_active_hidden_states(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<Hidden_stick_state> & out) const
+void Stick_tree::get_all_active_hidden_lines(const Frag_lifetime_tree & flt, unsigned timestamp, std::vector<kjb::Matrix> & out) const
 {
-    if(fln.get_end_time() > timestamp && fln.get_start_time() <= timestamp)
-    {
-        out.push_back(hss_[timestamp - fln.get_start_time()]);
-    }
-    else if(fln.get_end_time() <= timestamp && l_)
+    for_each_active_state(flt, timestamp, [&](unsigned, const Hidden_stick_state & hss, const Observed_stick_state &)
     {
-        l_->get_all_active_hidden_states(*(fln.get_left()), timestamp, out);
-        r_->get_all_active_hidden_states(*(fln.get_right()), timestamp, out);
-    }
+        out.push_back(*util::homo_col_vecs_to_non_homo_col_vecs(hss.get_image_endpoints_homo()));
+    });
 }
 
-void Stick_node::get_all_active_observed_states(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<Observed_stick_state> & out) const
+void Stick_tree::get_all_active_observed_lines(const Frag_lifetime_tree & flt, unsigned timestamp, std::vector<kjb::Matrix> & out) const
 {
-    if(fln.get_end_time() > timestamp && fln.get_start_time() <= timestamp)
+    for_each_active_state(flt, timestamp, [&](unsigned, const Hidden_stick_state &, const Observed_stick_state & oss)
     {
-        out.push_back(oss_[timestamp - fln.get_start_time()]);
-    }
-    else if(fln.get_end_time() <= timestamp && l_)
-    {
-        l_->get_all_active_observed_states(*(fln.get_left()), timestamp, out);
-        r_->get_all_active_observed_states(*(fln.get_right()), timestamp, out);
-    }
+        out.push_back(*util::homo_col_vecs_to_non_homo_col_vecs(oss.get_image_endpoints_homo()));
+    });
 }
 
-void Stick_node::get_all_active_hidden_lines(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<kjb::Matrix> & out) const
+double Stick_tree::get_fracture_location(size_t idx) const
 {
-    std::vector<Hidden_stick_state> temp_vec;
-    get_all_active_hidden_states(fln, timestamp, temp_vec);
-    for(const Hidden_stick_state & hss : temp_vec)
-    {
-        out.push_back(*util::homo_col_vecs_to_non_homo_col_vecs(hss.get_image_endpoints_homo()));
-    }
+    return nodes_[Stick_tree_structure::get_left_id(structure_.get_nonleaf_id(idx))].stick_len_.get_length();
+}
+
+void Stick_tree::set_length(double val, const Camera & c) {
+    Stick_node & root = nodes_[Stick_tree_structure::ROOT_ID];
+    root.stick_len_ = Stick_length_info(val);
+    // The root's state variables don't depend on its length, only their
+    // endpoints do.
+    root.change_ = Stick_node::SC_ENDPOINTS;
+    propagate_hidden_variables(c, 0, structure_.get_num_nodes());
 }
 
-void Stick_node::get_all_active_observed_lines(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<kjb::Matrix> & out) const
+void Stick_tree::set_initial_state_element(
+        Hidden_stick_state::State_variable sv,
+        double val,
+        const Camera & c)
 {
-    std::vector<Observed_stick_state> temp_vec;
-    get_all_active_observed_states(fln, timestamp, temp_vec);
-    for(const Observed_stick_state & oss : temp_vec)
-    {
-        out.push_back(*util::homo_col_vecs_to_non_homo_col_vecs(oss.get_image_endpoints_homo()));
-    }
+    Stick_node & root = nodes_[Stick_tree_structure::ROOT_ID];
+    hss_[0].set_state_element(sv, val, root.stick_len_.get_local_endpoints_homo(), c);
+    root.change_ = Stick_node::SC_STATES;
+    propagate_hidden_variables(c, 0, structure_.get_num_nodes());
 }
 
-size_t Stick_node::get_num_nonleaf_nodes() const
+void Stick_tree::set_fracture_location(size_t idx, double val, const Camera & c)
 {
-    if(!l_)
-    {
-        return 0;
-    }
-    return 1 + l_->get_num_nonleaf_nodes() + r_->get_num_nonleaf_nodes();
+    unsigned parent(structure_.get_nonleaf_id(idx));
+    Stick_node & left = nodes_[Stick_tree_structure::get_left_id(parent)];
+    left.stick_len_ = Stick_length_info(val);
+    left.change_ = Stick_node::SC_STATES;
+    // Both children's subtrees, which follow the parent in pre-order.
+    propagate_hidden_variables(c, structure_.get_preorder_pos(parent) + 1, structure_.get_subtree_end(parent));
 }
 
-size_t Stick_node::get_total_number_of_states() const
+void Stick_tree::update_camera(const Camera & c)
 {
-    size_t result(hss_.size());
-    if(l_)
+    for(unsigned id : structure_.get_preorder_ids())
     {
-        result += l_->get_total_number_of_states() + r_->get_total_number_of_states();
+        nodes_[id].change_ = Stick_node::SC_ENDPOINTS;
     }
-    return result;
+    propagate_hidden_variables(c, 0, structure_.get_num_nodes());
 }
 
-const Stick_node * Stick_node::get_nonleaf_node_by_index(size_t & idx) const
+void Stick_tree::forward_sample_hidden_rvs(
+        const Stick_length_info & stick_len,
+        const Hidden_stick_state & init_state,
+        const Camera & c)
 {
-    if(!l_)
-        return nullptr;
-    if(idx == 0)
+    nodes_[Stick_tree_structure::ROOT_ID].stick_len_ = stick_len;
+    hss_[0] = init_state;
+    // A fracture location's prior depends on the length of the fragment, so
+    // the right fragments' lengths have to be kept up to date as we go.
+    for(unsigned id : structure_.get_preorder_ids())
     {
-        return this;
+        if(id != Stick_tree_structure::ROOT_ID && !Stick_tree_structure::is_left_id(id))
+        {
+            unsigned parent_id(Stick_tree_structure::get_parent_id(id));
+            nodes_[id].stick_len_ = Stick_length_info(
+                    nodes_[parent_id].stick_len_.get_length() -
+                    nodes_[Stick_tree_structure::get_left_id(parent_id)].stick_len_.get_length());
+        }
+        if(!structure_.is_leaf(id))
+        {
+            double fr_loc(prob::sample(prob::frac_loc_i_dist(nodes_[id].stick_len_.get_length())));
+            nodes_[Stick_tree_structure::get_left_id(id)].stick_len_ = Stick_length_info(fr_loc);
+        }
     }
-    idx -= 1;
-    const Stick_node * result(l_->get_nonleaf_node_by_index(idx));
-    if(!result)
-        result = r_->get_nonleaf_node_by_index(idx);
-    return result;
-}
-
-void Stick_node::set_length(double val, const Camera & c) {
-    Stick_length_info temp(val);
-    propagate_hidden_variables(c, &temp, nullptr);
+    nodes_[Stick_tree_structure::ROOT_ID].change_ = Stick_node::SC_STATES;
+    propagate_hidden_variables(c, 0, structure_.get_num_nodes());
 }
 
-void Stick_node::set_initial_state_element(
-        Hidden_stick_state::State_variable sv,
-        double val,
-        const Camera & c)
+void Stick_tree::split_leaf(
+        unsigned id,
+        double frac_loc,
+        const Frag_lifetime_tree & flt,
+        const Camera & c,
+        const Observation_source & obs)
 {
-    hss_[0].set_state_element(sv, val, stick_len_.get_local_endpoints_homo(), c);
-    kjb::Vector temp_vec(hss_[0].get_state());
-    temp_vec[sv] = val;
-    Hidden_stick_state temp_hss(hss_[0]);
+    unsigned left_id(Stick_tree_structure::get_left_id(id));
+    unsigned right_id(Stick_tree_structure::get_right_id(id));
+    structure_.split(id);
+    if(nodes_.size() <= right_id)
+        nodes_.resize(right_id + 1);
+    Stick_node & node = nodes_[id];
+    Stick_node & left = nodes_[left_id];
+    Stick_node & right = nodes_[right_id];
+    // The end of the leaf's states is handed to its fragments, which live
+    // for the same frames, so each needs as many states as that.
+    size_t num_child_states(node.num_states_ - flt.get_node(id).get_lifetime());
+    node.num_states_ -= num_child_states;
+    node.log_likelihood_dirty_ = true;
+    size_t begin(node.first_state_ + node.num_states_);
+    hss_.insert(hss_.begin() + begin, num_child_states, Hidden_stick_state(hss_[begin - 1]));
+    oss_.insert(oss_.begin() + begin, num_child_states, Observed_stick_state());
+    shift_first_states(structure_.get_subtree_end(id), structure_.get_num_nodes(), std::ptrdiff_t(num_child_states));
 
-    propagate_hidden_variables(c, nullptr, &temp_hss);
+    left.first_state_ = begin;
+    right.first_state_ = begin + num_child_states;
+    unsigned start_time(flt.get_node(left_id).get_start_time());
+    for(Stick_node * child : {&left, &right})
+    {
+        unsigned child_id(child == &left ? left_id : right_id);
+        child->num_states_ = num_child_states;
+        for(size_t i = 0; i < num_child_states; i++)
+        {
+            oss_[child->first_state_ + i] = obs.get(child_id, start_time + unsigned(i));
+        }
+        child->change_ = Stick_node::SC_STATES;
+    }
+    left.stick_len_ = Stick_length_info(frac_loc);
+    propagate_hidden_variables(c, structure_.get_preorder_pos(id) + 1, structure_.get_subtree_end(id));
 }
 
-void Stick_node::set_fracture_location(size_t idx, double val, const Camera & c)
+void Stick_tree::merge_leaves(
+        unsigned id,
+        const Frag_lifetime_tree & flt,
+        const Camera & c,
+        const Observation_source & obs)
 {
-    Stick_node *parent = get_nonleaf_node_by_index(idx);
-    Stick_length_info sli_l(val);
-    Stick_length_info sli_r(stick_len_.get_length() - val);
-    Hidden_stick_state hss_l(parent->hss_[hss_.size() - 1], stick_len_, c, val, Hidden_stick_state::FS_LEFT);
-    Hidden_stick_state hss_r(parent->hss_[hss_.size() - 1], stick_len_, c, val, Hidden_stick_state::FS_RIGHT);
-    parent->get_left()->propagate_hidden_variables(c, &sli_l, &hss_l);
-    parent->get_right()->propagate_hidden_variables(c, &sli_r, &hss_r);
+    if(!structure_.is_mergeable(id))
+        throw "merge of a node that isn't mergeable";
+    Stick_node & node = nodes_[id];
+    // The fragments' states come right after the node's, and the node takes
+    // over the first half of them.
+    size_t num_child_states(nodes_[Stick_tree_structure::get_left_id(id)].num_states_);
+    size_t begin(node.first_state_ + node.num_states_);
+    hss_.erase(hss_.begin() + begin + num_child_states, hss_.begin() + begin + 2 * num_child_states);
+    oss_.erase(oss_.begin() + begin + num_child_states, oss_.begin() + begin + 2 * num_child_states);
+    structure_.merge(id);
+    shift_first_states(structure_.get_subtree_end(id), structure_.get_num_nodes(), -std::ptrdiff_t(num_child_states));
+    nodes_[Stick_tree_structure::get_left_id(id)] = Stick_node();
+    nodes_[Stick_tree_structure::get_right_id(id)] = Stick_node();
+    nodes_.resize(structure_.get_max_id_in_tree() + 1);
+
+    // Nothing depends on a leaf's states, so there's nothing to propagate.
+    Stick_node & merged = nodes_[id];
+    unsigned start_time(flt.get_node(id).get_start_time());
+    for(size_t i = begin; i < begin + num_child_states; i++)
+    {
+        hss_[i] = Hidden_stick_state(hss_[i - 1], merged.stick_len_, c);
+        oss_[i] = obs.get(id, start_time + unsigned(i - merged.first_state_));
+    }
+    merged.num_states_ += num_child_states;
+    merged.log_likelihood_dirty_ = true;
 }
 
-double Stick_node::log_prior(const Camera & cam, bool is_root) const
+double Stick_tree::log_prior(const Camera & cam) const
 {
     double result(0.0);
-    if(is_root)
-    {
-        // Our length is conditioned on the camera
-        // TODO instead of creating a new distribution, maybe save it in the class object?
-        result += prob::pdf(*prob::new_len_0_dist(cam.get_camera_width(), cam.get_camera_height()), stick_len_.get_length());
+    const Stick_node & root = nodes_[Stick_tree_structure::ROOT_ID];
+    // Our length is conditioned on the camera
+    result += prob::log_pdf(prob::len_0_dist(cam.get_camera_width(), cam.get_camera_height()), root.stick_len_.get_length());
 
-        // Don't forget to do the prior for the initial state variables
-        result+= hss_[0].log_prior(cam);
-    }
-    if(l_)
+    // Don't forget to do the prior for the initial state variables
+    result += hss_[0].log_prior(cam);
+
+    // Just have sticks handle their fracture location random variables as well.
+    for(size_t i = 0; i < structure_.get_num_nonleaf_nodes(); i++)
     {
-        // Just have sticks handle their fracture location random variables as well.
-        result += prob::pdf(*prob::new_frac_loc_i_dist(stick_len_.get_length()), l_->get_length_info().get_length());
-        result += l_->log_prior(cam, false) + r_->log_prior(cam, false);
+        unsigned id(structure_.get_nonleaf_id(i));
+        double len(nodes_[id].stick_len_.get_length());
+        // A proposal can push a length past zero, where the fracture location
+        // has no range to be in.
+        if(!(len > 0.0))
+            return double(-INFINITY);
+        result += prob::log_pdf(prob::frac_loc_i_dist(len), get_fracture_location(i));
     }
     return result;
 }
 
-double Stick_node::log_likelihood(const kjb::Normal_distribution & offset_dist) const
+double Stick_tree::log_likelihood(const prob::Normal_distribution & offset_dist, double clutter_log_density) const
 {
-    double result(0.0);
+    static const double LOG_OBS_P = std::log(1.0 - prob::OBS_MISS_P);
+    static const double LOG_MISS_P = std::log(prob::OBS_MISS_P);
+    // Every observation starts out as clutter, and explaining one trades
+    // that for how well the state explains it.
+    double result(double(num_observations_) * clutter_log_density);
     assert(oss_.size() == hss_.size());
-    for(size_t i = 0; i < oss_.size(); i++)
-    {
-        result += oss_[i].log_likelihood(hss_[i], offset_dist);
-    }
-    if(l_)
+    for(unsigned id : structure_.get_preorder_ids())
     {
-        result += l_->log_likelihood(offset_dist) + r_->log_likelihood(offset_dist);
+        const Stick_node & node = nodes_[id];
+        if(node.log_likelihood_dirty_)
+        {
+            node.log_likelihood_ = 0.0;
+            for(size_t i = node.first_state_; i < node.first_state_ + node.num_states_; i++)
+            {
+                if(oss_[i].is_observed())
+                    node.log_likelihood_ += oss_[i].log_likelihood(hss_[i], offset_dist) + LOG_OBS_P - clutter_log_density;
+                else
+                    node.log_likelihood_ += LOG_MISS_P;
+            }
+            node.log_likelihood_dirty_ = false;
+        }
+        result += node.log_likelihood_;
     }
     return result;
 }
 
-void Stick_node::propagate_hidden_variables(const Camera & c, const Stick_length_info * my_length, const Hidden_stick_state * initial_state)
+Hidden_stick_state Stick_tree::get_fracture_state(unsigned id, const Camera & c) const
 {
-    if(initial_state)
-    {
-        hss_[0] = *initial_state;
-    }
-    if(my_length)
-    {
-        stick_len_ = *my_length;
-    }
-    for(size_t i = 1; i < hss_.size(); i++)
+    const Stick_node & parent = nodes_[Stick_tree_structure::get_parent_id(id)];
+    return Hidden_stick_state
+    (
+        hss_[parent.first_state_ + parent.num_states_ - 1],
+        nodes_[id].stick_len_,
+        c,
+        Stick_tree_structure::is_left_id(id) ? Hidden_stick_state::FS_LEFT : Hidden_stick_state::FS_RIGHT
+    );
+}
+
+void Stick_tree::shift_first_states(size_t begin, size_t end, std::ptrdiff_t offset)
+{
+    const std::vector<unsigned> & preorder_ids = structure_.get_preorder_ids();
+    for(size_t pos = begin; pos < end; pos++)
     {
-        hss_[i] = Hidden_stick_state(hss_[i - 1], stick_len_, c);
+        nodes_[preorder_ids[pos]].first_state_ += offset;
     }
-    if(l_)
+}
+
+void Stick_tree::propagate_hidden_variables(const Camera & c, size_t begin, size_t end)
+{
+    const std::vector<unsigned> & preorder_ids = structure_.get_preorder_ids();
+    // Parents come first, so a node's parent's change_ is final by the time
+    // we get to it.
+    for(size_t pos = begin; pos < end; pos++)
     {
-        Hidden_stick_state hss_l(hss_[hss_.size() - 1], stick_len_, c, l_->get_length_info().get_length(), Hidden_stick_state::FS_LEFT);
-        Hidden_stick_state hss_r(hss_[hss_.size() - 1], stick_len_, c, l_->get_length_info().get_length(), Hidden_stick_state::FS_RIGHT);
-        l_->propagate_hidden_variables(c, nullptr, &hss_l);
-        if(my_length)
+        unsigned id(preorder_ids[pos]);
+        Stick_node & node = nodes_[id];
+        size_t first_changed(node.first_state_);
+        if(id != Stick_tree_structure::ROOT_ID)
         {
-            Stick_length_info sli_r(stick_len_.get_length() - l_->get_length_info().get_length());
-            r_->propagate_hidden_variables(c, &sli_r, &hss_r);
+            unsigned parent_id(Stick_tree_structure::get_parent_id(id));
+            if(!Stick_tree_structure::is_left_id(id))
+            {
+                double len(nodes_[parent_id].stick_len_.get_length() -
+                        nodes_[Stick_tree_structure::get_left_id(parent_id)].stick_len_.get_length());
+                if(len != node.stick_len_.get_length())
+                {
+                    node.stick_len_ = Stick_length_info(len);
+                    node.change_ = Stick_node::SC_STATES;
+                }
+            }
+            if(nodes_[parent_id].change_ == Stick_node::SC_STATES)
+            {
+                node.change_ = Stick_node::SC_STATES;
+            }
+            if(node.change_ == Stick_node::SC_STATES)
+            {
+                hss_[node.first_state_] = get_fracture_state(id, c);
+                first_changed++;
+            }
         }
-        else
+        else if(node.change_ == Stick_node::SC_STATES)
+        {
+            // The caller has already set the root's first state.
+            first_changed++;
+        }
+        switch(node.change_)
         {
-            r_->propagate_hidden_variables(c, nullptr, &hss_r);
+        case Stick_node::SC_NONE:
+            break;
+        case Stick_node::SC_ENDPOINTS:
+            for(size_t i = node.first_state_; i < node.first_state_ + node.num_states_; i++)
+            {
+                hss_[i].update_data_dependents(node.stick_len_.get_local_endpoints_homo(), c);
+            }
+            node.log_likelihood_dirty_ = true;
+            break;
+        case Stick_node::SC_STATES:
+            for(size_t i = first_changed; i < node.first_state_ + node.num_states_; i++)
+            {
+                hss_[i] = Hidden_stick_state(hss_[i - 1], node.stick_len_, c);
+            }
+            node.log_likelihood_dirty_ = true;
+            break;
+        default:
+            throw "unknown state change";
         }
     }
+    for(size_t pos = begin; pos < end; pos++)
+    {
+        nodes_[preorder_ids[pos]].change_ = Stick_node::SC_NONE;
+    }
+}
+
+Observed_stick_state Observation_source::get(unsigned id, unsigned timestamp) const
+{
+    if(!tree_.get_structure().has_node(id) || !flt_.get_node(id).is_active(timestamp))
+        return Observed_stick_state();
+    return tree_.get_observed_stick_state(id, timestamp - flt_.get_node(id).get_start_time());
 }
 
 }}
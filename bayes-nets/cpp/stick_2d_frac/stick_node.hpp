@@ -1,9 +1,11 @@
 #ifndef FRAC_LOC_NODE_HPP
 #define FRAC_LOC_NODE_HPP
 
-#include <memory>
+#include <cstddef>
+#include <vector>
 
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include "prob.hpp"
 #include "stick_tree_structure.hpp"
@@ -14,75 +16,175 @@
 
 namespace stick_2d_frac { namespace sample {
 
+// One fragment of the stick. Its states live in the owning Stick_tree.
 class Stick_node {
     friend class boost::serialization::access;
+    friend class Stick_tree;
 public:
-    Stick_node(
+    Stick_node() :
+        stick_len_(0.0),
+        first_state_(0),
+        num_states_(0),
+        change_(SC_NONE),
+        log_likelihood_(0.0),
+        log_likelihood_dirty_(true) {}
+
+    const Stick_length_info & get_length_info() const { return stick_len_; }
+    // Where this fragment's states start in the tree's state arrays.
+    size_t get_first_state() const { return first_state_; }
+    size_t get_num_states() const { return num_states_; }
+
+    // The cache isn't saved. It's rebuilt on the first log_likelihood.
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int)
+    {
+        ar & stick_len_ & first_state_ & num_states_;
+    }
+private:
+    // How much of a fragment's states are stale. Each implies the ones
+    // before it.
+    enum State_change {
+        SC_NONE,
+        // The endpoints, but not the state variables, e.g. the camera moved.
+        SC_ENDPOINTS,
+        // The variables of the first state, and so everything after it.
+        SC_STATES
+    };
+
+    Stick_length_info stick_len_;
+    size_t first_state_;
+    size_t num_states_;
+    // Only set during Stick_tree's propagation.
+    State_change change_;
+    // This fragment's term of the log likelihood, recomputed when its states
+    // change.
+    mutable double log_likelihood_;
+    mutable bool log_likelihood_dirty_;
+};
+
+class Observation_source;
+
+// The continuous part of the stick model: every fragment's length and its
+// hidden and observed states for each frame of its lifetime. The nodes are
+// indexed by Stick_tree_structure id. The states of all fragments are kept
+// in two flat arrays, laid out in pre-order, so that the states of any
+// subtree are one contiguous range.
+//
+// The setters only recompute the states that depend on what was set, and
+// each fragment caches its part of the log likelihood, so the cost of a
+// change is proportional to the lifetime of the subtree it affects. The same
+// goes for split_leaf and merge_leaves, which change the structure, apart
+// from moving the states that come after the changed leaves.
+class Stick_tree {
+    friend class boost::serialization::access;
+public:
+    Stick_tree(
             const Stick_tree_structure & tree_structure,
-            const Frag_lifetime_node & frac_tree,
+            const Frag_lifetime_tree & frac_tree,
             const Stick_length_info & stick_len,
             const Hidden_stick_state & init_state,
             const Camera & c,
-            const kjb::Normal_distribution & observed_image_endpoints_offset_dist);
-    ~Stick_node();
+            const prob::Normal_distribution & observed_image_endpoints_offset_dist);
 
-    const Stick_length_info & get_length_info() const { return stick_len_; }
+    const Stick_tree_structure & get_structure() const { return structure_; }
+    const Stick_node & get_node(unsigned id) const { return nodes_[id]; }
+    const Stick_length_info & get_length_info(unsigned id = Stick_tree_structure::ROOT_ID) const { return nodes_[id].stick_len_; }
     // state_index must be the difference between a given time stamp and
-    // this node's start time. This class cannot calculate this on its own,
+    // the node's start time. This class cannot calculate this on its own,
     // since it does not know the start time on account of that being part of
-    // a Frag_lifetime_node.
-    const Hidden_stick_state & get_hidden_stick_state(unsigned state_index) const { return hss_[state_index]; }
-    const Observed_stick_state & get_observed_stick_state(unsigned state_index) const { return oss_[state_index]; }
-    bool is_leaf() const { return !l_; }
-    // May return null if this is a leaf
-    const Stick_node * get_left() const { return l_; }
-    Stick_node * get_left() { return l_; }
-    const Stick_node * get_right() const { return r_;}
-    Stick_node * get_right() { return r_;}
-
-    // need the Frag_lifetime_node to calculate the array index from the timestamp.
-    void get_all_active_hidden_states(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<Hidden_stick_state> & out) const;
-    void get_all_active_observed_states(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<Observed_stick_state> & out) const;
-
-    // Basically a wrapper around get_all_active_hidden_states that also returns non-homogeneous matrices, ready to be drawn.
-    void get_all_active_hidden_lines(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<kjb::Matrix> & out) const;
-    void get_all_active_observed_lines(const Frag_lifetime_node & fln, unsigned timestamp, std::vector<kjb::Matrix> & out) const;
-
-    size_t get_num_nonleaf_nodes() const;
-    size_t get_total_number_of_states() const;
-
-    const Stick_node * get_nonleaf_node_by_index(size_t & idx) const;
-    Stick_node * get_nonleaf_node_by_index(size_t & idx)
+    // a Frag_lifetime_tree.
+    const Hidden_stick_state & get_hidden_stick_state(unsigned id, unsigned state_index) const { return hss_[nodes_[id].first_state_ + state_index]; }
+    const Observed_stick_state & get_observed_stick_state(unsigned id, unsigned state_index) const { return oss_[nodes_[id].first_state_ + state_index]; }
+
+    // Calls f(id, hss, oss) with the states of every fragment active at
+    // timestamp, in increasing id order, without copying them. Need the
+    // Frag_lifetime_tree to calculate the array index from the timestamp.
+    template<class F>
+    void for_each_active_state(const Frag_lifetime_tree & flt, unsigned timestamp, F f) const
     {
-        return const_cast<Stick_node *>(const_cast<const Stick_node *>(this)->get_nonleaf_node_by_index(idx));
+        for(unsigned id : flt.get_active_ids(timestamp))
+        {
+            size_t i(nodes_[id].first_state_ + (timestamp - flt.get_node(id).get_start_time()));
+            f(id, hss_[i], oss_[i]);
+        }
     }
 
-    // Also propagate the changes to all hidden states in the stick tree.
-    // ONLY CALL THIS ON THE ROOT
+    // Appends the endpoints of the active fragments as non-homogeneous
+    // matrices, ready to be drawn.
+    void get_all_active_hidden_lines(const Frag_lifetime_tree & flt, unsigned timestamp, std::vector<kjb::Matrix> & out) const;
+    void get_all_active_observed_lines(const Frag_lifetime_tree & flt, unsigned timestamp, std::vector<kjb::Matrix> & out) const;
+
+    size_t get_num_nonleaf_nodes() const { return structure_.get_num_nonleaf_nodes(); }
+    size_t get_total_number_of_states() const { return hss_.size(); }
+
+    // The location of the idx-th fracture (in pre-order), which is the length
+    // of the left fragment.
+    double get_fracture_location(size_t idx) const;
+
+    // Also propagate the changes to the hidden states that depend on them.
+    // Changing the root's length leaves its left subtree alone.
     void set_length(double val, const Camera & c);
-    // ONLY CALL THIS ON THE ROOT
     void set_initial_state_element(Hidden_stick_state::State_variable sv, double val, const Camera & c);
     void set_fracture_location(size_t idx, double val, const Camera & c);
+    // Call after the camera has changed, to reproject every state.
+    void update_camera(const Camera & c);
+    // Replaces the root's length and first state, and draws every fracture
+    // location from its prior. The observed states are kept.
+    void forward_sample_hidden_rvs(const Stick_length_info & stick_len, const Hidden_stick_state & init_state, const Camera & c);
+
+    // Fractures the leaf id at frac_loc, or undoes the fracture of a
+    // mergeable id. flt must already have been split or merged the same way.
+    // The new states take their observations from obs. Undoing one with the
+    // other gives back the same states.
+    void split_leaf(unsigned id, double frac_loc, const Frag_lifetime_tree & flt, const Camera & c, const Observation_source & obs);
+    void merge_leaves(unsigned id, const Frag_lifetime_tree & flt, const Camera & c, const Observation_source & obs);
 
-    double log_prior(const Camera & cam, bool is_root = true) const;
-    double log_likelihood(const kjb::Normal_distribution & offset_dist) const;
+    double log_prior(const Camera & cam) const;
+    // offset_dist and clutter_log_density must be the same on every call,
+    // since the terms of the fragments that haven't changed are reused.
+    double log_likelihood(const prob::Normal_distribution & offset_dist, double clutter_log_density) const;
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int)
     {
-        ar & stick_len_ & hss_ & oss_ & l_ & r_;
+        ar & structure_ & nodes_ & hss_ & oss_ & num_observations_;
     }
 private:
-    // Either internal length, initial state, or both will be set, depending on
-    // if null was passed for the arguments or not. If both are null, this is
-    // a no-op.
-    void propagate_hidden_variables(const Camera & c, const Stick_length_info * my_length = nullptr, const Hidden_stick_state * initial_state = nullptr);
-    Stick_length_info stick_len_;
+    // The first state of a non-root fragment, from its parent's last state.
+    Hidden_stick_state get_fracture_state(unsigned id, const Camera & c) const;
+    // Brings the nodes at pre-order positions [begin, end) up to date. The
+    // nodes whose own variables changed must be marked in change_ first, and
+    // the nodes before begin must already be up to date. A fragment's first
+    // state depends on its parent's last state and on its own length, and
+    // the length of a right fragment depends on its parent's and sibling's.
+    void propagate_hidden_variables(const Camera & c, size_t begin, size_t end);
+    // Moves the states of the nodes at pre-order positions [begin, end) by
+    // offset, after states have been inserted or erased before them.
+    void shift_first_states(size_t begin, size_t end, std::ptrdiff_t offset);
+
+    Stick_tree_structure structure_;
+    // Indexed by id. Ids that aren't in the tree are left default constructed.
+    std::vector<Stick_node> nodes_;
     std::vector<Hidden_stick_state> hss_;
     std::vector<Observed_stick_state> oss_;
-    // Both of these will be null if we're a leaf.
-    Stick_node * l_;
-    Stick_node * r_;
+    // How many observations the data has, which doesn't change with the
+    // structure. The ones that no state explains are clutter.
+    size_t num_observations_;
+};
+
+// The observations of the data a Stick_tree is fit to, for the states that a
+// change of structure creates. A fragment is observed in a frame if the data
+// has the fragment with the same id in that frame. Both trees must outlive
+// this.
+class Observation_source {
+public:
+    Observation_source(const Stick_tree & tree, const Frag_lifetime_tree & flt) :
+        tree_(tree), flt_(flt) {}
+
+    Observed_stick_state get(unsigned id, unsigned timestamp) const;
+private:
+    const Stick_tree & tree_;
+    const Frag_lifetime_tree & flt_;
 };
 
 }}
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <memory>
 #include <utility>
 #include <algorithm>
@@ -6,9 +7,13 @@
 #include <prob_cpp/prob_sample.h>
 
 #include "stick_tree_structure.hpp"
+#include "prob.hpp"
 
 namespace stick_2d_frac { namespace sample {
 
+const unsigned Stick_tree_structure::ROOT_ID;
+const int Stick_tree_structure::MAX_DEPTH;
+
 std::unique_ptr<std::stack<Stick_tree_structure::Direction>> Stick_tree_structure::id_to_directions(unsigned id)
 {
     std::unique_ptr<std::stack<Stick_tree_structure::Direction>> result =
@@ -57,70 +62,108 @@ unsigned Stick_tree_structure::directions_to_id(std::stack<Stick_tree_structure:
     return result;
 }
 
-Stick_tree_structure::Stick_tree_structure(int depth, unsigned id) :
-    id_(id)
+Stick_tree_structure::Stick_tree_structure(int depth)
 {
-
-    if(depth > 1)
-    {
-        l_ = new Stick_tree_structure(depth - 1, id * 2 + 1);
-        r_ = new Stick_tree_structure(depth - 1, id * 2 + 2);
-    }
-    else {
-        l_ = nullptr;
-        r_ = nullptr;
-    }
+    if(depth > MAX_DEPTH)
+        throw "depth > MAX_DEPTH";
+    // A full tree has every id up to the last one on its bottom level.
+    is_node_.assign((size_t(1) << std::max(depth, 1)) - 1, true);
+    index();
 }
 
 // Need to explicitly create the vectors, else got ambiguous constructor call error.
-Stick_tree_structure::Stick_tree_structure(const kjb::Categorical_distribution<> & dist, unsigned id) :
-    Stick_tree_structure(kjb::sample(dist), id) { }
+Stick_tree_structure::Stick_tree_structure(const kjb::Categorical_distribution<> & dist) :
+    Stick_tree_structure(int(kjb::sample(dist))) { }
 
-Stick_tree_structure::Stick_tree_structure(double frac_chance, unsigned id) :
-    id_(id)
+Stick_tree_structure::Stick_tree_structure(double frac_chance) :
+    is_node_(1, true)
 {
     static const kjb::Uniform_distribution VARIABLE_DEPTH_DIST;
-    if (kjb::sample(VARIABLE_DEPTH_DIST) < frac_chance) {
-        l_ = new Stick_tree_structure(frac_chance, id * 2 + 1);
-        r_ = new Stick_tree_structure(frac_chance, id * 2 + 2);
-    } else {
-        l_ = nullptr;
-        r_ = nullptr;
-    }
-}
-
-Stick_tree_structure::~Stick_tree_structure() {
-    if(l_) {
-        delete l_;
-        delete r_;
+    // Parents have smaller ids than their children, so by the time we get to
+    // an id, we know whether it's in the tree.
+    for(unsigned id = 0; id < is_node_.size() && can_fracture(id); id++)
+    {
+        if(is_node_[id] && prob::sample(VARIABLE_DEPTH_DIST) < frac_chance)
+        {
+            if(is_node_.size() <= get_right_id(id))
+                is_node_.resize(get_right_id(id) + 1, false);
+            is_node_[get_left_id(id)] = true;
+            is_node_[get_right_id(id)] = true;
+        }
     }
+    index();
 }
 
-unsigned Stick_tree_structure::get_id() const {
-    return id_;
-}
-
-bool Stick_tree_structure::is_leaf() const {
-    return !l_;
+void Stick_tree_structure::split(unsigned id)
+{
+    if(!has_node(id) || !is_leaf(id))
+        throw "split of a node that isn't a leaf";
+    if(!can_fracture(id))
+        throw "split below MAX_DEPTH";
+    if(is_node_.size() <= get_right_id(id))
+        is_node_.resize(get_right_id(id) + 1, false);
+    is_node_[get_left_id(id)] = true;
+    is_node_[get_right_id(id)] = true;
+    index();
 }
 
-const Stick_tree_structure * Stick_tree_structure::get_left() const {
-    return l_;
+void Stick_tree_structure::merge(unsigned id)
+{
+    if(!is_mergeable(id))
+        throw "merge of a node that isn't mergeable";
+    is_node_[get_left_id(id)] = false;
+    is_node_[get_right_id(id)] = false;
+    // Keep the last id in the tree.
+    while(!is_node_.back())
+        is_node_.pop_back();
+    index();
 }
 
-const Stick_tree_structure * Stick_tree_structure::get_right() const {
-    return r_;
+double Stick_tree_structure::log_prior(double frac_chance) const
+{
+    double result(0.0);
+    for(unsigned id : preorder_ids_)
+    {
+        if(can_fracture(id))
+            result += std::log(is_leaf(id) ? 1.0 - frac_chance : frac_chance);
+    }
+    return result;
 }
 
-unsigned Stick_tree_structure::get_max_id_in_tree() const {
-    if(!l_)
+void Stick_tree_structure::index()
+{
+    size_t num_ids = is_node_.size();
+    subtree_size_.assign(num_ids, 0);
+    preorder_pos_.assign(num_ids, 0);
+    // Going down the ids, every subtree is counted before its root needs it.
+    for(size_t i = num_ids; i > 0; i--)
+    {
+        unsigned id = unsigned(i - 1);
+        if(!is_node_[id])
+            continue;
+        subtree_size_[id] = 1;
+        if(!is_leaf(id))
+            subtree_size_[id] += subtree_size_[get_left_id(id)] + subtree_size_[get_right_id(id)];
+    }
+    // Going up, every node is placed before its children need its position.
+    preorder_ids_.assign(subtree_size_[ROOT_ID], ROOT_ID);
+    for(unsigned id = 0; id < num_ids; id++)
+    {
+        if(!is_node_[id])
+            continue;
+        preorder_ids_[preorder_pos_[id]] = id;
+        if(!is_leaf(id))
+        {
+            preorder_pos_[get_left_id(id)] = preorder_pos_[id] + 1;
+            preorder_pos_[get_right_id(id)] = preorder_pos_[id] + 1 + subtree_size_[get_left_id(id)];
+        }
+    }
+    nonleaf_ids_.clear();
+    for(unsigned id : preorder_ids_)
     {
-        return id_;
+        if(!is_leaf(id))
+            nonleaf_ids_.push_back(id);
     }
-    // You might assume the right subtree is guaranteed to have a higher id. However,
-    // this is only the case with full trees. What if the left subtree has greater
-    // depth?
-    return std::max(l_->get_max_id_in_tree(), r_->get_max_id_in_tree());
 }
 
 }}
@@ -6,6 +6,7 @@
 #include <stack>
 
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/random.hpp>
 
 #include <prob_cpp/prob_distribution.h>
@@ -17,6 +18,11 @@ namespace stick_2d_frac { namespace sample {
  * stick (the root) to its children, grandchildren, etc. This class is only
  * meant to represent the *structure* of the fracture, so it does not contain
  * any data other than the structure of the tree.
+ *
+ * The tree is implicit: nodes are named by their heap-style ids (the root is
+ * 0, and the children of id are 2 * id + 1 and 2 * id + 2), and everything
+ * else is a flat array indexed by id or by pre-order position. Per-node data
+ * in other classes can then be kept in arrays indexed the same way.
  */
 class Stick_tree_structure
 {
@@ -49,42 +55,84 @@ public:
     };
     static const Static STATIC;
 
+    static const unsigned ROOT_ID = 0;
+    // Deeper fixed depths are refused, and variable depth trees stop
+    // fracturing here, so that the id arrays stay bounded.
+    static const int MAX_DEPTH = 16;
+
     static std::unique_ptr<std::stack<Direction>> id_to_directions(unsigned id);
     static unsigned directions_to_id(const std::stack<Stick_tree_structure::Direction> & directions);
     static unsigned directions_to_id(std::stack<Stick_tree_structure::Direction> & directions);
+
+    static unsigned get_left_id(unsigned id) { return 2 * id + 1; }
+    static unsigned get_right_id(unsigned id) { return 2 * id + 2; }
+    // Not defined for the root.
+    static unsigned get_parent_id(unsigned id) { return (id - 1) / 2; }
+    // odd implies left, as in id_to_directions
+    static bool is_left_id(unsigned id) { return id % 2 == 1; }
+    // Whether id's children would be within MAX_DEPTH levels.
+    static bool can_fracture(unsigned id) { return id < (1u << (MAX_DEPTH - 1)) - 1; }
 // Member stuff
 public:
     // Initialize from a single, deterministic depth
-    Stick_tree_structure(int depth, unsigned id = 0);
+    Stick_tree_structure(int depth);
 
     // Initialize from a single, sampled depth. A distribution is given, and we will
     // perform the sample.
-    Stick_tree_structure(const kjb::Categorical_distribution<> & dist = STATIC.get_default_single_depth_dist(), unsigned id = 1);
+    Stick_tree_structure(const kjb::Categorical_distribution<> & dist = STATIC.get_default_single_depth_dist());
 
     // Initialize from a variable depth. Essentially, this entails that there is a
     // binary variable at each node in the tree. If the variable is sampled as 1, a
     // fracture happens, otherwise, no fracture happens.
-    Stick_tree_structure(double frac_chance = STATIC.get_default_frac_chance(), unsigned id = 1);
+    Stick_tree_structure(double frac_chance = STATIC.get_default_frac_chance());
+
+    bool has_node(unsigned id) const { return id < is_node_.size() && is_node_[id]; }
+    bool is_leaf(unsigned id) const { return !has_node(get_left_id(id)); }
+    // A fracture whose fragments haven't fractured, which merge can undo.
+    bool is_mergeable(unsigned id) const
+    {
+        return has_node(id) && !is_leaf(id) && is_leaf(get_left_id(id)) && is_leaf(get_right_id(id));
+    }
+
+    // Might need this for the vector adapter.
+    unsigned get_max_id_in_tree() const { return unsigned(is_node_.size() - 1); }
+    size_t get_num_nodes() const { return preorder_ids_.size(); }
 
-    ~Stick_tree_structure();
+    // The node ids in pre-order (node, left subtree, right subtree). Parents
+    // come before their children, and every subtree is a contiguous range.
+    const std::vector<unsigned> & get_preorder_ids() const { return preorder_ids_; }
+    size_t get_preorder_pos(unsigned id) const { return preorder_pos_[id]; }
+    // One past the pre-order position of the last node in id's subtree.
+    size_t get_subtree_end(unsigned id) const { return preorder_pos_[id] + subtree_size_[id]; }
 
-    unsigned get_id() const;
-    bool is_leaf() const;
-    const Stick_tree_structure * get_left() const;
-    const Stick_tree_structure * get_right() const;
+    // The non-leaf nodes (the fractures), in pre-order.
+    size_t get_num_nonleaf_nodes() const { return nonleaf_ids_.size(); }
+    unsigned get_nonleaf_id(size_t idx) const { return nonleaf_ids_[idx]; }
 
-    // Might need this for the vector adapter.
-    unsigned get_max_id_in_tree() const;
+    // Fractures the leaf id, or undoes the fracture of a mergeable id. Both
+    // reindex, so they're linear in the number of ids.
+    void split(unsigned id);
+    void merge(unsigned id);
+
+    // As sampled by the variable depth constructor.
+    double log_prior(double frac_chance) const;
 
     template<class Archive>
     void serialize(Archive & ar, const unsigned int) {
-        ar & l_ & r_ & id_;
+        ar & is_node_ & subtree_size_ & preorder_pos_ & preorder_ids_ & nonleaf_ids_;
     }
 private:
-    Stick_tree_structure * l_;
-    Stick_tree_structure * r_;
+    // Fills in everything below is_node_ from it.
+    void index();
+
+    // Indexed by id. Ids that aren't in the tree are false.
+    std::vector<bool> is_node_;
+    // Indexed by id, 0 for ids that aren't in the tree.
+    std::vector<unsigned> subtree_size_;
+    std::vector<unsigned> preorder_pos_;
 
-    unsigned id_;
+    std::vector<unsigned> preorder_ids_;
+    std::vector<unsigned> nonleaf_ids_;
 };
 
 }}
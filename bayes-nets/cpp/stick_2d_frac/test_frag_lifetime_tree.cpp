@@ -0,0 +1,65 @@
+#include <cassert>
+#include <vector>
+
+#include "prob.hpp"
+#include "discrete_sample.hpp"
+
+using namespace stick_2d_frac;
+using namespace sample;
+
+// The active index agrees with the lifetimes themselves.
+static void check_active_ids(const Discrete_sample & ds, unsigned num_ims)
+{
+    const Stick_tree_structure & structure = ds.get_stick_tree_structure();
+    const Frag_lifetime_tree & flt = ds.get_frac_lifetime_tree();
+    for(unsigned t = 0; t < num_ims; t++)
+    {
+        std::vector<unsigned> expected;
+        for(unsigned id = 0; id <= structure.get_max_id_in_tree(); id++)
+        {
+            if(structure.has_node(id) && flt.get_node(id).is_active(t))
+                expected.push_back(id);
+        }
+        Id_range active(flt.get_active_ids(t));
+        assert(std::vector<unsigned>(active.begin(), active.end()) == expected);
+    }
+    assert(flt.get_active_ids(num_ims).empty());
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned num_ims = 40;
+    int depth = 2;
+
+    prob::seed_sampling_rand(11);
+    Discrete_sample ds(num_ims, depth);
+    check_active_ids(ds, num_ims);
+
+    // random splits and merges, as the jumps make them
+    for(unsigned i = 0; i < 500; i++)
+    {
+        const Stick_tree_structure & structure = ds.get_stick_tree_structure();
+        const Frag_lifetime_tree & flt = ds.get_frac_lifetime_tree();
+        std::vector<unsigned> splittable;
+        std::vector<unsigned> mergeable;
+        for(unsigned id : structure.get_preorder_ids())
+        {
+            if(structure.is_leaf(id) && Stick_tree_structure::can_fracture(id) && flt.get_node(id).get_lifetime() > 1)
+                splittable.push_back(id);
+            if(structure.is_mergeable(id))
+                mergeable.push_back(id);
+        }
+        if(!mergeable.empty() && (splittable.empty() || i % 3 == 0))
+        {
+            ds.merge_leaves(mergeable[i % mergeable.size()]);
+        }
+        else
+        {
+            assert(!splittable.empty());
+            unsigned id(splittable[i % splittable.size()]);
+            const Frag_lifetime_node & node = flt.get_node(id);
+            ds.split_leaf(id, node.get_start_time() + 1 + i % (node.get_lifetime() - 1));
+        }
+        check_active_ids(ds, num_ims);
+    }
+}
@@ -0,0 +1,53 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "prob.hpp"
+#include "sample.hpp"
+#include "metropolis_hastings.hpp"
+
+int main(int argc, char *argv[])
+{
+    using namespace stick_2d_frac;
+
+    unsigned num_ims = 20;
+    unsigned im_w = 640;
+    unsigned im_h = 480;
+    double cam_fps = 30.0;
+    int depth = 2;
+
+    prob::seed_sampling_rand(7);
+    sample::Sample data(num_ims, im_w, im_h, cam_fps, depth);
+    sample::Sample s(get_mh_initial_sample(data));
+    sample::Continuous_sample & cs = s.get_continuous_sample();
+    assert(std::isfinite(s.log_posterior()));
+
+    // a length proposed past zero is out of the support, rather than a
+    // distribution with an empty range
+    double len = cs.get_stick_tree().get_length_info().get_length();
+    cs.set_initial_length(-0.5 * len);
+    assert(s.log_prior() == -INFINITY && s.log_posterior() == -INFINITY);
+    cs.set_initial_length(0.0);
+    assert(s.log_prior() == -INFINITY);
+    cs.set_initial_length(len);
+    assert(std::isfinite(s.log_posterior()));
+
+    // as is a fracture location past the end of its fragment, which leaves
+    // the right child, itself fractured at this depth, a negative length
+    double loc = cs.get_stick_tree().get_fracture_location(0);
+    cs.set_fracture_location(0, 2.0 * len);
+    assert(s.log_prior() == -INFINITY);
+    cs.set_fracture_location(0, loc);
+    assert(std::isfinite(s.log_posterior()));
+
+    // and a chain with proposals wide enough to cross zero all the time
+    // rejects them instead of throwing
+    std::vector<double> stds(get_mh_stds(1.0, 0));
+    for(double &std : stds)
+    {
+        std *= 1e3;
+    }
+    Metropolis_hastings_resampler mh(3, 200, s, stds, data.get_observation_source(), 1);
+    mh.resample_all();
+    assert(std::isfinite(mh.get_cur_log_prob()));
+}
@@ -4,12 +4,50 @@
 #include <memory>
 
 #include <m_cpp/m_matrix.h>
+#include <m_cpp/m_matrix_d.h>
+#include <m_cpp/m_vector_d.h>
 
 namespace stick_2d_frac { namespace util {
 
 std::unique_ptr<kjb::Matrix> homo_col_vecs_to_non_homo_col_vecs(const kjb::Matrix & in);
 std::unique_ptr<kjb::Matrix> non_homo_col_vecs_to_homo_col_vecs(const kjb::Matrix & in);
 
+template<size_t rows, size_t cols>
+std::unique_ptr<kjb::Matrix> homo_col_vecs_to_non_homo_col_vecs(const kjb::Matrix_d<rows, cols> & in)
+{
+    std::unique_ptr<kjb::Matrix> r = std::unique_ptr<kjb::Matrix>(new kjb::Matrix(int(rows) - 1, int(cols)));
+    for(size_t i = 0; i < rows - 1; i++)
+    {
+        for(size_t j = 0; j < cols; j++)
+        {
+            (*r)(int(i), int(j)) = in(i, j) / in(rows - 1, j);
+        }
+    }
+    return r;
+}
+
+// Element by element, for the fixed-size types.
+template<class Archive, size_t rows, size_t cols>
+void serialize_matrix_d(Archive & ar, kjb::Matrix_d<rows, cols> & m)
+{
+    for(size_t i = 0; i < rows; i++)
+    {
+        for(size_t j = 0; j < cols; j++)
+        {
+            ar & m(i, j);
+        }
+    }
+}
+
+template<class Archive, size_t dims>
+void serialize_vector_d(Archive & ar, kjb::Vector_d<dims> & v)
+{
+    for(size_t i = 0; i < dims; i++)
+    {
+        ar & v[i];
+    }
+}
+
 std::unique_ptr<kjb::Matrix> stick_length_to_local_endpoints_homo(double len);
 double local_endpoints_homo_to_stick_length(const kjb::Matrix & in);
 